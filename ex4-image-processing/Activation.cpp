@@ -1,5 +1,5 @@
 #include "Activation.h"
-#include <cmath>
+#include "VectorOps.h"
 #define ACTIVATION_ERROR "ERROR: invalid activation type"
 #define ZERO 0
 #define ONE 1
@@ -50,13 +50,7 @@ Matrix Activation::operator()( Matrix &m) const
 Matrix Activation::_reluAct(const Matrix &m) const
 {
     Matrix resultMat = Matrix(m);
-    for (int i = 0; i < m.getRows() * m.getCols(); ++i)
-    {
-        if(m[i] < ZERO )
-        {
-            resultMat[i] = ZERO;
-        }
-    }
+    vecRelu(resultMat.data(), resultMat.data(), resultMat.size());
     return resultMat;
 }
 
@@ -68,15 +62,6 @@ Matrix Activation::_reluAct(const Matrix &m) const
 Matrix Activation::_softMaxAct(const Matrix& m) const
 {
     Matrix resultMat = Matrix(m);
-    float sumOfExp  = ZERO;
-    for (int i = 0; i < m.getCols() * m.getRows() ; i++)
-    {
-        resultMat[i] = std::exp(m[i]);
-        sumOfExp += resultMat[i];
-    }
-    return   (ONE / sumOfExp)  *  resultMat; ;
+    vecSoftmax(resultMat.data(), resultMat.data(), resultMat.size());
+    return resultMat;
 }
-
-
-
-
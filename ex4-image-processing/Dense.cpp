@@ -1,4 +1,13 @@
 #include "Dense.h"
+#include "Gemm.h"
+#include "VectorOps.h"
+#include <utility>
+#include <vector>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define ONE 1
+#define ZERO 0
+#define FLOAT_ZERO 0.0f
+#define PARALLEL_ROWS 32
 
 /**
  * constractor - Inits a new layer with given parameters
@@ -6,9 +15,23 @@
  * @param bias matrix
  * @param activationType (Relu/Softmax)
  */
-Dense::Dense(const Matrix w, const Matrix bias,  ActivationType activationType): _w(w), _bias(bias),
+Dense::Dense(Matrix w, Matrix bias,  ActivationType activationType): _w(std::move(w)), _bias(std::move(bias)),
             _activationType(activationType)
 {
+    // every output row reads its own bias, the fused kernels index it without a check
+    if(_bias.getRows() != _w.getRows() || _bias.getCols() != ONE)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    // weights viewed in a mapped model are not scanned, that would read every page on construction
+    if(!_w.isView() && SparseMatrix::density(_w) <= SPARSE_DENSITY_THRESHOLD)
+    {
+        _sparseW = SparseMatrix(_w);
+        return;
+    }
+    // nothing is packed yet, the batch kernels pack what they read on first use
+    _packed = std::make_shared<PackedWeights>();
 }
 
 
@@ -16,7 +39,7 @@ Dense::Dense(const Matrix w, const Matrix bias,  ActivationType activationType):
 /**
  * getter - Returns the weights of this layer
  */
-Matrix Dense::getWeights() const
+const Matrix& Dense::getWeights() const
 {
     return _w;
 }
@@ -25,7 +48,7 @@ Matrix Dense::getWeights() const
  * getter- Returns the bias of this layer
  * @return
  */
-Matrix Dense::getBias() const
+const Matrix& Dense::getBias() const
 {
     return _bias;
 }
@@ -48,7 +71,278 @@ Activation Dense::getActivation() const
  */
 Matrix Dense::operator()(const Matrix &m) const
 {
-    Activation activationFun = getActivation();
-    Matrix matrix = getWeights() * m + getBias();
-    return activationFun(matrix);
+    if(m.getRows() != _w.getCols())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if(m.getCols() != ONE)
+    {
+        // a batch turns the layer into a real GEMM, the epilogue runs over the L2-resident output
+        Matrix result = _batchProduct(m);
+        _batchEpilogue(result);
+        return result;
+    }
+    Matrix result = Matrix(_w.getRows(), ONE);
+    apply(m.data(), result.data());
+    return result;
+}
+
+/**
+ * Applies the layer on a single input vector into caller memory, without allocating
+ * @param x pointer to the getWeights().getCols() input floats
+ * @param y pointer to getWeights().getRows() floats, overwritten with the activated outputs
+ */
+void Dense::apply(const float *x, float *y) const
+{
+    // W·x + b and the activation are produced row by row in one sweep over the weights,
+    // softmax needs the largest logit first so it runs over the finished outputs
+    GemvActivation act = (_activationType == Softmax) ? GemvIdentity : GemvRelu;
+    _gemv(ZERO, _w.getRows(), x, y, act);
+    if(_activationType == Softmax)
+    {
+        vecSoftmax(y, y, _w.getRows());
+    }
+}
+
+/**
+ * Applies the layer without its activation, W * m + b
+ * @param m matrix, a single input vector or a batch with one input per column
+ * @return result matrix, one output per column
+ */
+Matrix Dense::logits(const Matrix &m) const
+{
+    if(m.getRows() != _w.getCols())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if(m.getCols() != ONE)
+    {
+        Matrix result = _batchProduct(m);
+        _addBias(result);
+        return result;
+    }
+    Matrix result = Matrix(_w.getRows(), ONE);
+    _gemv(ZERO, _w.getRows(), m.data(), result.data(), GemvIdentity);
+    return result;
+}
+
+/**
+ * Applies the layer on a batch with one input per row, act(m * W^T + b) row by row
+ * @param m matrix, one input per row
+ * @return result matrix, one output per row
+ */
+Matrix Dense::applyRows(const Matrix &m) const
+{
+    if(m.getCols() != _w.getCols())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    Matrix result = _rowsProduct(m);
+    // every output is a contiguous row, the epilogue is plain vector kernels
+    for(int i = 0; i < result.getRows(); i++)
+    {
+        float *row = result.row(i);
+        vecAdd(row, _bias.data(), row, result.getCols());
+        if(_activationType == Softmax)
+        {
+            vecSoftmax(row, row, result.getCols());
+        }
+        else
+        {
+            vecRelu(row, row, result.getCols());
+        }
+    }
+    return result;
+}
+
+/**
+ * Parenthesis operator - Applies the layer on a single input vector, splitting the rows of a
+ * large ReLU layer across the pool
+ * @param m matrix, a single input vector or a batch with one input per column
+ * @param pool threads to use
+ * @return result matrix, one output per column
+ */
+Matrix Dense::operator()(const Matrix &m, ThreadPool &pool) const
+{
+    // softmax rows depend on each other through the sum, and small layers are not worth a hand-off
+    if(m.getCols() != ONE || _activationType != Relu || _w.getRows() < 2 * PARALLEL_ROWS ||
+       m.getRows() != _w.getCols())
+    {
+        return (*this)(m);
+    }
+    Matrix result = Matrix(_w.getRows(), ONE);
+    pool.parallelFor(ZERO, _w.getRows(), PARALLEL_ROWS, [this, &m, &result](int first, int last)
+    {
+        _gemv(first, last, m.data(), result.data(), GemvRelu);
+    });
+    return result;
+}
+
+/**
+ * Adds the bias to every column of z and applies the activation column-wise, in place
+ * @param z the batch product W * X
+ */
+void Dense::_batchEpilogue(Matrix &z) const
+{
+    const float *bias = _bias.data();
+    int cols = z.getCols();
+    if(_activationType == Softmax)
+    {
+        // every column is shifted by its largest logit, rows stay contiguous for the exp kernel
+        _addBias(z);
+        std::vector<float> max(z.row(ZERO), z.row(ZERO) + cols);
+        for(int i = ONE; i < z.getRows(); i++)
+        {
+            const float *row = z.row(i);
+            for(int j = 0; j < cols; j++)
+            {
+                max[j] = (row[j] > max[j]) ? row[j] : max[j];
+            }
+        }
+        std::vector<float> sums(cols, ZERO);
+        for(int i = 0; i < z.getRows(); i++)
+        {
+            float *row = z.row(i);
+            for(int j = 0; j < cols; j++)
+            {
+                row[j] -= max[j];
+            }
+            vecExp(row, FLOAT_ZERO, row, cols);
+            for(int j = 0; j < cols; j++)
+            {
+                sums[j] += row[j];
+            }
+        }
+        for(int j = 0; j < cols; j++)
+        {
+            sums[j] = ONE / sums[j];
+        }
+        for(int i = 0; i < z.getRows(); i++)
+        {
+            float *row = z.row(i);
+            for(int j = 0; j < cols; j++)
+            {
+                row[j] *= sums[j];
+            }
+        }
+        return;
+    }
+    for(int i = 0; i < z.getRows(); i++)
+    {
+        float *row = z.row(i);
+        for(int j = 0; j < cols; j++)
+        {
+            row[j] += bias[i];
+        }
+        vecRelu(row, row, cols);
+    }
+}
+
+/**
+ * Adds the bias to every column of z, in place
+ * @param z the batch product W * X
+ */
+void Dense::_addBias(Matrix &z) const
+{
+    const float *bias = _bias.data();
+    for(int i = 0; i < z.getRows(); i++)
+    {
+        float *row = z.row(i);
+        for(int j = 0; j < z.getCols(); j++)
+        {
+            row[j] += bias[i];
+        }
+    }
+}
+
+/**
+ * Returns true if the products of this layer run on sparse weights
+ */
+bool Dense::isSparse() const
+{
+    return _sparseW.getRows() != ZERO;
+}
+
+/**
+ * y = act(W * x + b) over the rows [first, last) of the layer
+ * @param first first row
+ * @param last one past the last row
+ * @param x pointer to the contiguous input
+ * @param y pointer to the outputs, indexed by row
+ * @param act function applied to every output
+ */
+void Dense::_gemv(int first, int last, const float *x, float *y, GemvActivation act) const
+{
+    if(isSparse())
+    {
+        _sparseW.gemvBiasAct(first, last, x, _bias.data(), y, act);
+        return;
+    }
+    gemvBiasAct(last - first, _w.getCols(), _w.row(first), _w.getCols(), x, _bias.data() + first, y + first, act);
+}
+
+/**
+ * Returns W packed into GEMM_MR row slivers for gemmPrepackedA, packing it on the first call
+ */
+const float* Dense::_packedSlivers() const
+{
+    PackedWeights &packed = *_packed;
+    std::call_once(packed.slivers, [this, &packed]()
+    {
+        packed.packedW.resize(prepackedASize(_w.getRows(), _w.getCols()));
+        prepackA(_w.getRows(), _w.getCols(), _w.data(), _w.getCols(), ONE, packed.packedW.data());
+    });
+    return packed.packedW.data();
+}
+
+/**
+ * Returns W^T packed into GEMM_NR panels for gemmPrepackedB, packing it on the first call
+ */
+const float* Dense::_packedPanels() const
+{
+    PackedWeights &packed = *_packed;
+    std::call_once(packed.panels, [this, &packed]()
+    {
+        // W^T is read straight out of W, row p of W^T is column p of W
+        packed.packedWt.resize(prepackedBSize(_w.getCols(), _w.getRows()));
+        prepackB(_w.getCols(), _w.getRows(), _w.data(), ONE, _w.getCols(), packed.packedWt.data());
+    });
+    return packed.packedWt.data();
+}
+
+/**
+ * The product W * m of a batch with one input per column, without the bias
+ * @param m matrix, one input per column
+ */
+Matrix Dense::_batchProduct(const Matrix &m) const
+{
+    Matrix result = Matrix(_w.getRows(), m.getCols());
+    if(isSparse())
+    {
+        _sparseW.gemm(m.getCols(), m.data(), m.getCols(), result.data(), result.getCols());
+        return result;
+    }
+    gemmPrepackedA(_w.getRows(), m.getCols(), _w.getCols(), _packedSlivers(), m.data(), m.getCols(),
+                   result.data(), result.getCols());
+    return result;
+}
+
+/**
+ * The product m * W^T of a batch with one input per row, without the bias
+ * @param m matrix, one input per row
+ */
+Matrix Dense::_rowsProduct(const Matrix &m) const
+{
+    if(isSparse())
+    {
+        // a gather per weight is slower than turning the batch around for the column kernel
+        return _batchProduct(m.transpose()).transpose();
+    }
+    Matrix result = Matrix(m.getRows(), _w.getRows());
+    gemmPrepackedB(m.getRows(), _w.getRows(), _w.getCols(), m.data(), m.getCols(), _packedPanels(),
+                   result.data(), result.getCols());
+    return result;
 }
@@ -3,9 +3,30 @@
 
 #include "Matrix.h"
 #include "Activation.h"
+#include "ThreadPool.h"
+#include "SparseMatrix.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+ * Layers with at most this fraction of nonzero weights run on a compressed sparse row copy of them
+ * instead of the packed dense layouts, may be overridden at build time (e.g.
+ * -DSPARSE_DENSITY_THRESHOLD=0.3f). Around a quarter is where the sparse GEMV overtakes the dense one.
+ */
+#ifndef SPARSE_DENSITY_THRESHOLD
+#define SPARSE_DENSITY_THRESHOLD 0.25f
+#endif
 
 /**
- * A class representing a dense in the network
+ * A class representing a dense in the network. The single input GEMV reads the row major weights as
+ * they are, so weights mapped from a model file are never copied on that path. A batch kernel packs
+ * the layout it needs on its first call and keeps it: GEMM_MR row slivers for batches with one input
+ * per column, GEMM_NR panels of W^T for batches with one input per row. A layer only ever used one
+ * way holds one packed copy, and copies of a layer share it.
+ * Layers pruned below SPARSE_DENSITY_THRESHOLD keep a CSR copy instead, which every product reads.
+ * Weights that are views (Matrix::isView, e.g. mapped from a model file) are never scanned for
+ * zeros and always run dense, so building a layer on them touches none of their pages.
  */
 class Dense
 {
@@ -16,18 +37,18 @@ public:
      * @param bias matrix
      * @param activationType (Relu/Softmax)
      */
-    Dense(const Matrix w, const Matrix bias, ActivationType activationType);
+    Dense(Matrix w, Matrix bias, ActivationType activationType);
 
     /**
      * getter - Returns the weights of this layer
      */
-    Matrix getWeights() const;
+    const Matrix& getWeights() const;
 
     /**
      * getter- Returns the bias of this layer
      * @return
      */
-    Matrix getBias() const ;
+    const Matrix& getBias() const ;
 
 
     /**
@@ -38,16 +59,108 @@ public:
 
     /**
      * Parenthesis operator - Applies the layer on input and returns output matrix Layers operate
-     * @param m matrix
-     * @return result matrix
+     * @param m matrix, a single input vector or a batch with one input per column
+     * @return result matrix, one output per column
      */
     Matrix operator()(const Matrix& m) const;
 
+    /**
+     * Parenthesis operator - Applies the layer on a single input vector, splitting the rows of a
+     * large ReLU layer across the pool
+     * @param m matrix, a single input vector or a batch with one input per column
+     * @param pool threads to use
+     * @return result matrix, one output per column
+     */
+    Matrix operator()(const Matrix& m, ThreadPool& pool) const;
+
+    /**
+     * Applies the layer on a single input vector into caller memory, without allocating
+     * @param x pointer to the getWeights().getCols() input floats
+     * @param y pointer to getWeights().getRows() floats, overwritten with the activated outputs
+     */
+    void apply(const float *x, float *y) const;
+
+    /**
+     * Applies the layer without its activation, W * m + b
+     * @param m matrix, a single input vector or a batch with one input per column
+     * @return result matrix, one output per column
+     */
+    Matrix logits(const Matrix& m) const;
+
+    /**
+     * Applies the layer on a batch with one input per row, act(m * W^T + b) row by row
+     * @param m matrix, one input per row
+     * @return result matrix, one output per row
+     */
+    Matrix applyRows(const Matrix& m) const;
+
+    /**
+     * Returns true if the products of this layer run on sparse weights
+     */
+    bool isSparse() const;
+
 
 private:
     Matrix _w;
     Matrix _bias;
     ActivationType _activationType;
+    /**
+     * The packed layouts of the weights, each filled once on first use
+     */
+    struct PackedWeights
+    {
+        std::once_flag slivers;
+        std::once_flag panels;
+        std::vector<float> packedW;
+        std::vector<float> packedWt;
+    };
+
+    std::shared_ptr<PackedWeights> _packed;
+    SparseMatrix _sparseW;
+
+    /**
+     * y = act(W * x + b) over the rows [first, last) of the layer
+     * @param first first row
+     * @param last one past the last row
+     * @param x pointer to the contiguous input
+     * @param y pointer to the outputs, indexed by row
+     * @param act function applied to every output
+     */
+    void _gemv(int first, int last, const float *x, float *y, GemvActivation act) const;
+
+    /**
+     * Returns W packed into GEMM_MR row slivers for gemmPrepackedA, packing it on the first call
+     */
+    const float* _packedSlivers() const;
+
+    /**
+     * Returns W^T packed into GEMM_NR panels for gemmPrepackedB, packing it on the first call
+     */
+    const float* _packedPanels() const;
+
+    /**
+     * The product W * m of a batch with one input per column, without the bias
+     * @param m matrix, one input per column
+     */
+    Matrix _batchProduct(const Matrix& m) const;
+
+    /**
+     * The product m * W^T of a batch with one input per row, without the bias
+     * @param m matrix, one input per row
+     */
+    Matrix _rowsProduct(const Matrix& m) const;
+
+    /**
+     * Adds the bias to every column of z and applies the activation column-wise, in place
+     * @param z the batch product W * X
+     */
+    void _batchEpilogue(Matrix& z) const;
+
+    /**
+     * Adds the bias to every column of z, in place
+     * @param z the batch product W * X
+     */
+    void _addBias(Matrix& z) const;
 
 };
 
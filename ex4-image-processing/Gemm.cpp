@@ -0,0 +1,731 @@
+#include "Gemm.h"
+#include "MatrixView.h"
+#include "ThreadPool.h"
+#include "VectorOps.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define ZERO 0
+#define FLOAT_ZERO 0.0f
+#define GEMV_LANES 8
+#define GEMV_ROWS 4
+// tiles of a parallel product per thread, some slack for the work stealing to even out
+#define GEMM_TASKS_PER_THREAD 4
+// smallest tile of a parallel product, keeps the repacking of shared operands in proportion
+#define GEMM_MIN_TILE_ROWS 32
+#define GEMM_MIN_TILE_COLS 64
+
+// pre-packed operands are addressed by block offsets, blocks must hold whole slivers and panels
+static_assert(GEMM_MC % GEMM_MR == 0 && GEMM_NC % GEMM_NR == 0,
+              "GEMM_MC and GEMM_NC must be multiples of the register tile");
+
+/**
+ * Packs a mc × kc block of A into GEMM_MR row slivers, each stored column by column,
+ * the last sliver is padded with zeros.
+ * @param mc rows in block
+ * @param kc cols in block
+ * @param a pointer to the block
+ * @param rsa distance between two rows of A
+ * @param csa distance between two cols of A
+ * @param packed destination, at least roundUp(mc, GEMM_MR) * kc floats
+ */
+static void packA(int mc, int kc, const float *a, int rsa, int csa, float *packed)
+{
+    for (int i = 0; i < mc; i += GEMM_MR)
+    {
+        int rows = (mc - i < GEMM_MR) ? mc - i : GEMM_MR;
+        for (int p = 0; p < kc; p++)
+        {
+            for (int r = 0; r < GEMM_MR; r++)
+            {
+                *packed++ = (r < rows) ? a[(i + r) * rsa + p * csa] : FLOAT_ZERO;
+            }
+        }
+    }
+}
+
+/**
+ * Packs a kc × nc block of B into GEMM_NR column panels, each stored row by row,
+ * the last panel is padded with zeros.
+ * @param kc rows in block
+ * @param nc cols in block
+ * @param b pointer to the block
+ * @param rsb distance between two rows of B
+ * @param csb distance between two cols of B
+ * @param packed destination, at least kc * roundUp(nc, GEMM_NR) floats
+ */
+static void packB(int kc, int nc, const float *b, int rsb, int csb, float *packed)
+{
+    for (int j = 0; j < nc; j += GEMM_NR)
+    {
+        int cols = (nc - j < GEMM_NR) ? nc - j : GEMM_NR;
+        for (int p = 0; p < kc; p++)
+        {
+            const float *row = b + p * rsb + j * csb;
+            if (csb == 1)
+            {
+                // kept apart so that the common row major copy stays a vector copy
+                for (int c = 0; c < GEMM_NR; c++)
+                {
+                    *packed++ = (c < cols) ? row[c] : FLOAT_ZERO;
+                }
+                continue;
+            }
+            for (int c = 0; c < GEMM_NR; c++)
+            {
+                *packed++ = (c < cols) ? row[c * csb] : FLOAT_ZERO;
+            }
+        }
+    }
+}
+
+/**
+ * Computes one GEMM_MR × GEMM_NR tile of C from packed slivers, the accumulators stay in registers.
+ * @param kc depth of the slivers
+ * @param ap A sliver
+ * @param rsa distance between two rows of the A sliver (1 when packed)
+ * @param csa distance between two cols of the A sliver (GEMM_MR when packed)
+ * @param bp packed B panel
+ * @param c pointer to the tile in C
+ * @param rsc distance between two rows of C
+ * @param csc distance between two cols of C
+ * @param mr valid rows of the tile
+ * @param nr valid cols of the tile
+ * @param accumulate add to C instead of overwriting it
+ */
+static void microKernel(int kc, const float *ap, int rsa, int csa, const float *bp, float *c, int rsc, int csc,
+                        int mr, int nr, bool accumulate)
+{
+    float acc[GEMM_MR][GEMM_NR];
+#if defined(__GNUC__) || defined(__clang__)
+    // one vector register (or a pair) per accumulator row, independent of the auto vectorizer's mood
+    typedef float GemmRow __attribute__((vector_size(GEMM_NR * sizeof(float))));
+    GemmRow rows[GEMM_MR] = {};
+    for (int p = 0; p < kc; p++)
+    {
+        GemmRow b;
+        std::memcpy(&b, bp, sizeof(b));
+#pragma GCC unroll 8
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            rows[i] += ((i < mr) ? ap[i * rsa] : FLOAT_ZERO) * b;
+        }
+        ap += csa;
+        bp += GEMM_NR;
+    }
+    std::memcpy(acc, rows, sizeof(acc));
+#else
+    std::memset(acc, ZERO, sizeof(acc));
+    for (int p = 0; p < kc; p++)
+    {
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            const float ai = (i < mr) ? ap[i * rsa] : FLOAT_ZERO;
+            for (int j = 0; j < GEMM_NR; j++)
+            {
+                acc[i][j] += ai * bp[j];
+            }
+        }
+        ap += csa;
+        bp += GEMM_NR;
+    }
+#endif
+    for (int i = 0; i < mr; i++)
+    {
+        float *row = c + i * rsc;
+        if (csc == 1)
+        {
+            for (int j = 0; j < nr; j++)
+            {
+                row[j] = accumulate ? row[j] + acc[i][j] : acc[i][j];
+            }
+            continue;
+        }
+        for (int j = 0; j < nr; j++)
+        {
+            row[j * csc] = accumulate ? row[j * csc] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+/**
+ * Rounds count up to a multiple of step
+ * @param count positive number
+ * @param step positive number
+ * @return the rounded count
+ */
+static inline int roundUp(int count, int step)
+{
+    return (count + step - 1) / step * step;
+}
+
+/**
+ * The operands of one product, either of A and B may come pre-packed (see prepackA and prepackB),
+ * the other one is packed block by block as it is used
+ */
+struct GemmOperands
+{
+    const float *a;
+    int rsa;
+    int csa;
+    const float *preA;
+    const float *b;
+    int rsb;
+    int csb;
+    const float *preB;
+    float *c;
+    int rsc;
+    int csc;
+};
+
+/**
+ * Blocked product of the rows [rowBegin, rowEnd) and cols [colBegin, colEnd) of C = A * B, the
+ * bounds are multiples of the register tile (or m and n) so pre-packed blocks keep their offsets
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param op the operands
+ * @param rowBegin first row of C
+ * @param rowEnd one past the last row of C
+ * @param colBegin first col of C
+ * @param colEnd one past the last col of C
+ */
+static void gemmTile(int m, int n, int k, const GemmOperands &op, int rowBegin, int rowEnd, int colBegin,
+                     int colEnd)
+{
+    static thread_local std::vector<float> packedA;
+    static thread_local std::vector<float> packedB;
+    packedA.resize((GEMM_MC + GEMM_MR) * GEMM_KC);
+    packedB.resize((GEMM_NC + GEMM_NR) * GEMM_KC);
+    const int mPadded = roundUp(m, GEMM_MR);
+    const int nPadded = roundUp(n, GEMM_NR);
+    const float *a = op.a;
+    const int rsa = op.rsa;
+    const int csa = op.csa;
+    float *c = op.c;
+    const int rsc = op.rsc;
+    const int csc = op.csc;
+
+    for (int jc = colBegin; jc < colEnd; jc += GEMM_NC)
+    {
+        int nc = (colEnd - jc < GEMM_NC) ? colEnd - jc : GEMM_NC;
+        for (int pc = 0; pc < k; pc += GEMM_KC)
+        {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            const float *panelsB = packedB.data();
+            if (op.preB != nullptr)
+            {
+                panelsB = op.preB + (size_t) pc * nPadded + (size_t) jc * kc;
+            }
+            else
+            {
+                packB(kc, nc, op.b + pc * op.rsb + jc * op.csb, op.rsb, op.csb, packedB.data());
+            }
+            // a single B panel uses every A sliver once, packing A would cost as much as the product
+            bool packingA = op.preA == nullptr && nc > GEMM_NR;
+            for (int ic = rowBegin; ic < rowEnd; ic += GEMM_MC)
+            {
+                int mc = (rowEnd - ic < GEMM_MC) ? rowEnd - ic : GEMM_MC;
+                const float *slivers = packedA.data();
+                if (op.preA != nullptr)
+                {
+                    slivers = op.preA + (size_t) pc * mPadded + (size_t) ic * kc;
+                }
+                else if (packingA)
+                {
+                    packA(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA.data());
+                }
+                bool packed = op.preA != nullptr || packingA;
+                for (int jr = 0; jr < nc; jr += GEMM_NR)
+                {
+                    int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+                    for (int ir = 0; ir < mc; ir += GEMM_MR)
+                    {
+                        int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+                        const float *ap = packed ? slivers + ir * kc : a + (ic + ir) * rsa + pc * csa;
+                        microKernel(kc, ap, packed ? 1 : rsa, packed ? GEMM_MR : csa, panelsB + jr * kc,
+                                    c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc, mr, nr, pc != ZERO);
+                    }
+                }
+            }
+        }
+    }
+    if (k == ZERO)
+    {
+        for (int i = rowBegin; i < rowEnd; i++)
+        {
+            for (int j = colBegin; j < colEnd; j++)
+            {
+                c[i * rsc + j * csc] = FLOAT_ZERO;
+            }
+        }
+    }
+}
+
+/**
+ * The threads of large products, created on first use with gemmThreads threads
+ */
+static std::mutex gemmPoolLock;
+static std::unique_ptr<ThreadPool> gemmPool;
+static int gemmThreads = ZERO;
+
+/**
+ * Sets the amount of threads a large product is split across, process wide. Must not be called
+ * while a product is running.
+ * @param threads amount of threads including the caller, 1 runs every product on the calling
+ * thread, 0 uses one per core
+ */
+void setGemmThreads(int threads)
+{
+    std::lock_guard<std::mutex> guard(gemmPoolLock);
+    gemmThreads = (threads < ZERO) ? ZERO : threads;
+    gemmPool.reset();
+}
+
+/**
+ * Returns the amount of threads a large product is split across
+ */
+int getGemmThreads()
+{
+    std::lock_guard<std::mutex> guard(gemmPoolLock);
+    if (gemmThreads != ZERO)
+    {
+        return gemmThreads;
+    }
+    int cores = (int) std::thread::hardware_concurrency();
+    return (cores <= ZERO) ? 1 : cores;
+}
+
+/**
+ * Returns true if a blocked product of this shape, issued from the calling thread, is split across
+ * the gemm threads
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ */
+bool gemmRunsParallel(int m, int n, int k)
+{
+    return (double) m * n * k >= GEMM_PARALLEL_WORK && !ThreadPool::insideTask() && getGemmThreads() > 1;
+}
+
+/**
+ * Returns the pool of large products, nullptr when products run on a single thread
+ */
+static ThreadPool *parallelPool()
+{
+    int threads = getGemmThreads();
+    std::lock_guard<std::mutex> guard(gemmPoolLock);
+    if (threads <= 1)
+    {
+        return nullptr;
+    }
+    if (gemmPool == nullptr)
+    {
+        gemmPool.reset(new ThreadPool(threads));
+    }
+    return gemmPool.get();
+}
+
+/**
+ * Blocked product C = A * B, either operand may come pre-packed (see prepackA and prepackB),
+ * the other one is packed block by block as it is used. Products of at least GEMM_PARALLEL_WORK
+ * multiply-adds split C into row × col tiles run across the gemm threads, every tile is first
+ * written by the thread computing it. A Matrix product of that size gets its C from
+ * pageMatrixAllocator(), untouched pages, so on NUMA machines each page lands on the node of the
+ * thread that computes it; buffers from the pool are placed wherever they were first used.
+ * Products issued from inside a ThreadPool task stay on their thread, the enclosing loop already
+ * keeps the cores busy.
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param a pointer to A, ignored when preA is given
+ * @param rsa distance between two rows of A
+ * @param csa distance between two cols of A
+ * @param preA A in the prepackA layout, may be nullptr
+ * @param b pointer to B, ignored when preB is given
+ * @param rsb distance between two rows of B
+ * @param csb distance between two cols of B
+ * @param preB B in the prepackB layout, may be nullptr
+ * @param c pointer to C, overwritten
+ * @param rsc distance between two rows of C
+ * @param csc distance between two cols of C
+ */
+static void gemmBlocked(int m, int n, int k, const float *a, int rsa, int csa, const float *preA, const float *b,
+                        int rsb, int csb, const float *preB, float *c, int rsc, int csc)
+{
+    const GemmOperands op = {a, rsa, csa, preA, b, rsb, csb, preB, c, rsc, csc};
+    ThreadPool *pool = nullptr;
+    if (gemmRunsParallel(m, n, k))
+    {
+        pool = parallelPool();
+    }
+    if (pool == nullptr)
+    {
+        gemmTile(m, n, k, op, ZERO, m, ZERO, n);
+        return;
+    }
+    // rows first, every row tile packs its own A blocks, then cols until there are enough tiles
+    const int target = pool->getThreadCount() * GEMM_TASKS_PER_THREAD;
+    int rowTiles = std::max(1, std::min(target, m / GEMM_MIN_TILE_ROWS));
+    int colTiles = std::max(1, std::min((target + rowTiles - 1) / rowTiles, n / GEMM_MIN_TILE_COLS));
+    const int rowStep = roundUp((m + rowTiles - 1) / rowTiles, GEMM_MR);
+    const int colStep = roundUp((n + colTiles - 1) / colTiles, GEMM_NR);
+    rowTiles = (m + rowStep - 1) / rowStep;
+    colTiles = (n + colStep - 1) / colStep;
+    pool->parallelFor(ZERO, rowTiles * colTiles, 1, [&](int first, int last)
+    {
+        for (int t = first; t < last; t++)
+        {
+            const int row = t / colTiles * rowStep;
+            const int col = t % colTiles * colStep;
+            gemmTile(m, n, k, op, row, std::min(row + rowStep, m), col, std::min(col + colStep, n));
+        }
+    });
+}
+
+/**
+ * Row major single precision matrix product C = A * B, products of at least GEMM_PARALLEL_WORK
+ * multiply-adds run across getGemmThreads() threads
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param b pointer to B
+ * @param ldb distance between two rows of B
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemm(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc)
+{
+    if (n == 1)
+    {
+        gemv(m, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+    gemmBlocked(m, n, k, a, lda, 1, nullptr, b, ldb, 1, nullptr, c, ldc, 1);
+}
+
+/**
+ * Amount of floats prepackA writes for an m × k left operand
+ * @param m rows of A
+ * @param k cols of A
+ */
+size_t prepackedASize(int m, int k)
+{
+    return (size_t) roundUp(m, GEMM_MR) * k;
+}
+
+/**
+ * Packs a whole left operand once, in the order gemm would pack it block by block: every
+ * GEMM_KC deep slice of A as GEMM_MR row slivers stored column by column
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param rsa distance between two rows of A
+ * @param csa distance between two cols of A
+ * @param packed destination, prepackedASize(m, k) floats
+ */
+void prepackA(int m, int k, const float *a, int rsa, int csa, float *packed)
+{
+    for (int pc = 0; pc < k; pc += GEMM_KC)
+    {
+        int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+        for (int i = 0; i < m; i += GEMM_MR)
+        {
+            for (int p = pc; p < pc + kc; p++)
+            {
+                for (int r = i; r < i + GEMM_MR; r++)
+                {
+                    *packed++ = (r < m) ? a[(size_t) r * rsa + (size_t) p * csa] : FLOAT_ZERO;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Amount of floats prepackB writes for a k × n right operand
+ * @param k rows of B
+ * @param n cols of B
+ */
+size_t prepackedBSize(int k, int n)
+{
+    return (size_t) k * roundUp(n, GEMM_NR);
+}
+
+/**
+ * Packs a whole right operand once, in the order gemm would pack it block by block: every
+ * GEMM_KC deep slice of B as GEMM_NR column panels stored row by row
+ * @param k rows of B
+ * @param n cols of B
+ * @param b pointer to B
+ * @param rsb distance between two rows of B
+ * @param csb distance between two cols of B
+ * @param packed destination, prepackedBSize(k, n) floats
+ */
+void prepackB(int k, int n, const float *b, int rsb, int csb, float *packed)
+{
+    for (int pc = 0; pc < k; pc += GEMM_KC)
+    {
+        int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+        for (int j = 0; j < n; j += GEMM_NR)
+        {
+            for (int p = pc; p < pc + kc; p++)
+            {
+                for (int c = j; c < j + GEMM_NR; c++)
+                {
+                    *packed++ = (c < n) ? b[(size_t) p * rsb + (size_t) c * csb] : FLOAT_ZERO;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Row major matrix product C = A * B with A packed by prepackA
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param packedA A in the prepackA layout
+ * @param b pointer to B
+ * @param ldb distance between two rows of B
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemmPrepackedA(int m, int n, int k, const float *packedA, const float *b, int ldb, float *c, int ldc)
+{
+    gemmBlocked(m, n, k, nullptr, ZERO, ZERO, packedA, b, ldb, 1, nullptr, c, ldc, 1);
+}
+
+/**
+ * Row major matrix product C = A * B with B packed by prepackB
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param packedB B in the prepackB layout
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemmPrepackedB(int m, int n, int k, const float *a, int lda, const float *packedB, float *c, int ldc)
+{
+    gemmBlocked(m, n, k, a, lda, 1, nullptr, nullptr, ZERO, ZERO, packedB, c, ldc, 1);
+}
+
+/**
+ * Epilogue of a single gemv output, adds the bias and applies the activation
+ * @param dot the row dot product
+ * @param bias pointer to the bias of this row, may be nullptr
+ * @param act activation
+ * @return the output value
+ */
+static inline float finishRow(float dot, const float *bias, GemvActivation act)
+{
+    float z = (bias != nullptr) ? dot + *bias : dot;
+    if (act == GemvRelu)
+    {
+        return (z < FLOAT_ZERO) ? FLOAT_ZERO : z;
+    }
+    return z;
+}
+
+/**
+ * Shared gemv body, y = act(A * x + bias)
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param x pointer to contiguous x
+ * @param bias pointer to m contiguous biases, may be nullptr
+ * @param y pointer to y, overwritten
+ * @param incy distance between two elements of y
+ * @param act activation
+ * @return sum of the outputs
+ */
+static float gemvKernel(int m, int k, const float *a, int lda, const float *x, const float *bias, float *y,
+                        int incy, GemvActivation act)
+{
+    float total = FLOAT_ZERO;
+    int kMain = k - k % GEMV_LANES;
+    int i = 0;
+    // GEMV_ROWS rows share every load of x, the lanes are independent partial sums so
+    // the compiler vectorizes them without reassociating
+    for (; i + GEMV_ROWS <= m; i += GEMV_ROWS)
+    {
+        float acc[GEMV_ROWS][GEMV_LANES] = {};
+        for (int p = 0; p < kMain; p += GEMV_LANES)
+        {
+            for (int r = 0; r < GEMV_ROWS; r++)
+            {
+                const float *row = a + (i + r) * lda + p;
+                for (int l = 0; l < GEMV_LANES; l++)
+                {
+                    acc[r][l] += row[l] * x[p + l];
+                }
+            }
+        }
+        for (int r = 0; r < GEMV_ROWS; r++)
+        {
+            float sum = FLOAT_ZERO;
+            for (int l = 0; l < GEMV_LANES; l++)
+            {
+                sum += acc[r][l];
+            }
+            for (int p = kMain; p < k; p++)
+            {
+                sum += a[(i + r) * lda + p] * x[p];
+            }
+            y[(i + r) * incy] = finishRow(sum, (bias != nullptr) ? bias + i + r : nullptr, act);
+            total += y[(i + r) * incy];
+        }
+    }
+    for (; i < m; i++)
+    {
+        float acc[GEMV_LANES] = {};
+        const float *row = a + i * lda;
+        for (int p = 0; p < kMain; p += GEMV_LANES)
+        {
+            for (int l = 0; l < GEMV_LANES; l++)
+            {
+                acc[l] += row[p + l] * x[p + l];
+            }
+        }
+        float sum = FLOAT_ZERO;
+        for (int l = 0; l < GEMV_LANES; l++)
+        {
+            sum += acc[l];
+        }
+        for (int p = kMain; p < k; p++)
+        {
+            sum += row[p] * x[p];
+        }
+        y[i * incy] = finishRow(sum, (bias != nullptr) ? bias + i : nullptr, act);
+        total += y[i * incy];
+    }
+    return total;
+}
+
+/**
+ * Row major matrix vector product y = A * x
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param x pointer to x
+ * @param incx distance between two elements of x
+ * @param y pointer to y, overwritten
+ * @param incy distance between two elements of y
+ */
+void gemv(int m, int k, const float *a, int lda, const float *x, int incx, float *y, int incy)
+{
+    static thread_local std::vector<float> contiguousX;
+    if (incx != 1)
+    {
+        contiguousX.resize(k);
+        for (int p = 0; p < k; p++)
+        {
+            contiguousX[p] = x[p * incx];
+        }
+        x = contiguousX.data();
+    }
+    gemvKernel(m, k, a, lda, x, nullptr, y, incy, GemvIdentity);
+}
+
+/**
+ * Fused dense layer kernel y = act(A * x + bias), computed in a single sweep over A
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param x pointer to contiguous x
+ * @param bias pointer to m contiguous biases, may be nullptr
+ * @param y pointer to m contiguous outputs, overwritten
+ * @param act function applied to every output
+ * @return sum of the outputs, in row order
+ */
+float gemvBiasAct(int m, int k, const float *a, int lda, const float *x, const float *bias, float *y,
+                  GemvActivation act)
+{
+    return gemvKernel(m, k, a, lda, x, bias, y, 1, act);
+}
+
+/**
+ * Matrix product C = A * B of views of any strides, transposed views included. Strided operands
+ * are read in place by the packing routines, nothing is copied up front.
+ * @param a m × k view
+ * @param b k × n view
+ * @param c m × n view, overwritten, must not overlap the operands
+ */
+void gemm(const ConstMatrixView &a, const ConstMatrixView &b, const MatrixView &c)
+{
+    if (a.getCols() != b.getRows() || c.getRows() != a.getRows() || c.getCols() != b.getCols())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (b.getCols() == 1)
+    {
+        gemv(a, b, c);
+        return;
+    }
+    gemmBlocked(a.getRows(), b.getCols(), a.getCols(), a.data(), a.getRowStride(), a.getColStride(), nullptr,
+                b.data(), b.getRowStride(), b.getColStride(), nullptr, c.data(), c.getRowStride(),
+                c.getColStride());
+}
+
+/**
+ * Distance between two elements of a vector view
+ * @param v a single row or a single column
+ */
+static int vectorStride(const ConstMatrixView &v)
+{
+    return (v.getCols() == 1) ? v.getRowStride() : v.getColStride();
+}
+
+/**
+ * Matrix vector product y = A * x of views of any strides. A row major A runs the gemv kernel, a
+ * column major one (such as a transposed view) accumulates its columns with axpy sweeps.
+ * @param a m × k view
+ * @param x k elements, a single row or a single column
+ * @param y m elements, a single row or a single column, overwritten, must not overlap the operands
+ */
+void gemv(const ConstMatrixView &a, const ConstMatrixView &x, const MatrixView &y)
+{
+    const int m = a.getRows();
+    const int k = a.getCols();
+    if ((x.getRows() != 1 && x.getCols() != 1) || (y.getRows() != 1 && y.getCols() != 1) ||
+        x.getRows() * x.getCols() != k || y.getRows() * y.getCols() != m)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    const int incx = vectorStride(x);
+    const int incy = vectorStride(y);
+    if (a.isRowMajor())
+    {
+        gemv(m, k, a.data(), a.getRowStride(), x.data(), incx, y.data(), incy);
+        return;
+    }
+    if (a.getRowStride() != 1)
+    {
+        gemmBlocked(m, 1, k, a.data(), a.getRowStride(), a.getColStride(), nullptr, x.data(), incx, 1, nullptr,
+                    y.data(), incy, 1);
+        return;
+    }
+    static thread_local std::vector<float> sum;
+    sum.assign(m, FLOAT_ZERO);
+    for (int p = 0; p < k; p++)
+    {
+        vecScaleAdd(a.data() + (size_t) p * a.getColStride(), x.data()[(size_t) p * incx], sum.data(), sum.data(),
+                    m);
+    }
+    for (int i = 0; i < m; i++)
+    {
+        y.data()[(size_t) i * incy] = sum[i];
+    }
+}
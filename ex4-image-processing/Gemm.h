@@ -0,0 +1,205 @@
+// Gemm.h
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+
+template<class T>
+class BasicMatrixView;
+
+/**
+ * Writable and read only strided views, see MatrixView.h
+ */
+typedef BasicMatrixView<float> MatrixView;
+typedef BasicMatrixView<const float> ConstMatrixView;
+
+/*
+ * Cache blocking parameters, may be overridden at build time (e.g. -DGEMM_KC=384).
+ * GEMM_KC × GEMM_NR floats of B and GEMM_KC × GEMM_MR floats of A should fit in L1,
+ * GEMM_MC × GEMM_KC floats of packed A should fit in L2.
+ */
+#ifndef GEMM_MC
+#define GEMM_MC 64
+#endif
+
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+
+#ifndef GEMM_NC
+#define GEMM_NC 1024
+#endif
+
+/*
+ * Products of at least this many multiply-adds (m * n * k) are split across the gemm threads,
+ * smaller ones run on the calling thread. May be overridden at build time.
+ */
+#ifndef GEMM_PARALLEL_WORK
+#define GEMM_PARALLEL_WORK (1 << 21)
+#endif
+
+/*
+ * Register tile of the micro kernel, GEMM_NR is a multiple of the widest vector we target.
+ */
+#define GEMM_MR 4
+#define GEMM_NR 16
+
+/**
+ * @enum GemvActivation
+ * @brief Element-wise function applied to every output of gemvBiasAct as it is produced
+ */
+enum GemvActivation
+{
+    GemvIdentity,
+    GemvRelu
+};
+
+/**
+ * Sets the amount of threads a large product is split across, process wide. Must not be called
+ * while a product is running.
+ * @param threads amount of threads including the caller, 1 runs every product on the calling
+ * thread, 0 uses one per core
+ */
+void setGemmThreads(int threads);
+
+/**
+ * Returns the amount of threads a large product is split across
+ */
+int getGemmThreads();
+
+/**
+ * Returns true if a blocked product of this shape, issued from the calling thread, is split across
+ * the gemm threads
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ */
+bool gemmRunsParallel(int m, int n, int k);
+
+/**
+ * Row major single precision matrix product C = A * B, products of at least GEMM_PARALLEL_WORK
+ * multiply-adds run across getGemmThreads() threads
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param b pointer to B
+ * @param ldb distance between two rows of B
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemm(int m, int n, int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc);
+
+/**
+ * Amount of floats prepackA writes for an m × k left operand
+ * @param m rows of A
+ * @param k cols of A
+ */
+size_t prepackedASize(int m, int k);
+
+/**
+ * Packs a whole left operand once, in the order gemm would pack it block by block: every
+ * GEMM_KC deep slice of A as GEMM_MR row slivers stored column by column
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param rsa distance between two rows of A
+ * @param csa distance between two cols of A
+ * @param packed destination, prepackedASize(m, k) floats
+ */
+void prepackA(int m, int k, const float *a, int rsa, int csa, float *packed);
+
+/**
+ * Amount of floats prepackB writes for a k × n right operand
+ * @param k rows of B
+ * @param n cols of B
+ */
+size_t prepackedBSize(int k, int n);
+
+/**
+ * Packs a whole right operand once, in the order gemm would pack it block by block: every
+ * GEMM_KC deep slice of B as GEMM_NR column panels stored row by row
+ * @param k rows of B
+ * @param n cols of B
+ * @param b pointer to B
+ * @param rsb distance between two rows of B
+ * @param csb distance between two cols of B
+ * @param packed destination, prepackedBSize(k, n) floats
+ */
+void prepackB(int k, int n, const float *b, int rsb, int csb, float *packed);
+
+/**
+ * Row major matrix product C = A * B with A packed by prepackA
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param packedA A in the prepackA layout
+ * @param b pointer to B
+ * @param ldb distance between two rows of B
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemmPrepackedA(int m, int n, int k, const float *packedA, const float *b, int ldb, float *c, int ldc);
+
+/**
+ * Row major matrix product C = A * B with B packed by prepackB
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A, rows of B
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param packedB B in the prepackB layout
+ * @param c pointer to C, overwritten
+ * @param ldc distance between two rows of C
+ */
+void gemmPrepackedB(int m, int n, int k, const float *a, int lda, const float *packedB, float *c, int ldc);
+
+/**
+ * Row major matrix vector product y = A * x
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param x pointer to x
+ * @param incx distance between two elements of x
+ * @param y pointer to y, overwritten
+ * @param incy distance between two elements of y
+ */
+void gemv(int m, int k, const float *a, int lda, const float *x, int incx, float *y, int incy);
+
+/**
+ * Fused dense layer kernel y = act(A * x + bias), computed in a single sweep over A
+ * @param m rows of A
+ * @param k cols of A
+ * @param a pointer to A
+ * @param lda distance between two rows of A
+ * @param x pointer to contiguous x
+ * @param bias pointer to m contiguous biases, may be nullptr
+ * @param y pointer to m contiguous outputs, overwritten
+ * @param act function applied to every output
+ * @return sum of the outputs, in row order
+ */
+float gemvBiasAct(int m, int k, const float *a, int lda, const float *x, const float *bias, float *y,
+                  GemvActivation act);
+
+/**
+ * Matrix product C = A * B of views of any strides, transposed views included. Strided operands
+ * are read in place by the packing routines, nothing is copied up front.
+ * @param a m × k view
+ * @param b k × n view
+ * @param c m × n view, overwritten, must not overlap the operands
+ */
+void gemm(const ConstMatrixView &a, const ConstMatrixView &b, const MatrixView &c);
+
+/**
+ * Matrix vector product y = A * x of views of any strides. A row major A runs the gemv kernel, a
+ * column major one (such as a transposed view) accumulates its columns with axpy sweeps.
+ * @param a m × k view
+ * @param x k elements, a single row or a single column
+ * @param y m elements, a single row or a single column, overwritten, must not overlap the operands
+ */
+void gemv(const ConstMatrixView &a, const ConstMatrixView &x, const MatrixView &y);
+
+#endif //GEMM_H
@@ -0,0 +1,369 @@
+#include "HalfDense.h"
+#include "VectorOps.h"
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HALF_X86 1
+#include <immintrin.h>
+#endif
+// a contracted scalar fallback would stop matching the vector kernels
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+#include <cstring>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define FLOAT_ZERO 0.0f
+#define FLOAT_HALF 0.5f
+#define ONE 1
+#define ZERO 0
+// partial sums of dotHalf, one AVX-512 register or two AVX2 registers
+#define HALF_LANES 16
+#define SIGN_MASK 0x80000000u
+#define MAGNITUDE_MASK 0x7fffffffu
+#define FLOAT_INFINITY_BITS 0x7f800000u
+#define HALF_SIGN_MASK 0x8000u
+#define HALF_INFINITY 0x7c00u
+#define HALF_QUIET_BIT 0x200u
+#define FLOAT_QUIET_BIT 0x400000u
+#define HALF_MANTISSA_MASK 0x3ffu
+#define HALF_EXPONENT_MASK 0x1fu
+#define HALF_MANTISSA_BITS 10
+// 65520, halfway between the largest fp16 (65504) and 2^16, rounds to infinity
+#define HALF_OVERFLOW_BITS 0x477ff000u
+// 2^-14, the smallest normal fp16
+#define HALF_MIN_NORMAL_BITS 0x38800000u
+// float and fp16 exponent biases differ by 127 - 15
+#define HALF_REBIAS (112u << 23)
+// 0.5f has a unit in the last place of 2^-24, the fp16 subnormal step
+#define HALF_SUBNORMAL_MAGIC_BITS 0x3f000000u
+#define HALF_SUBNORMAL_UNIT 5.9604644775390625e-8f
+#define HALF_DROPPED_BITS 13
+#define HALF_ROUND_BIAS 0xfffu
+#define BFLOAT16_DROPPED_BITS 16
+#define BFLOAT16_ROUND_BIAS 0x7fffu
+#define BFLOAT16_QUIET_BIT 0x40u
+
+/**
+ * Rounds a float to the nearest fp16 value, ties to even, out of range values become infinities
+ * @param v value
+ * @return the fp16 bits
+ */
+uint16_t floatToHalf(float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    const uint16_t sign = (uint16_t) ((bits & SIGN_MASK) >> BFLOAT16_DROPPED_BITS);
+    uint32_t magnitude = bits & MAGNITUDE_MASK;
+    if (magnitude > FLOAT_INFINITY_BITS)
+    {
+        // quieted, with the top of the payload, the way the conversion instructions do it
+        return (uint16_t) (sign | HALF_INFINITY | HALF_QUIET_BIT |
+                           ((magnitude >> HALF_DROPPED_BITS) & HALF_MANTISSA_MASK));
+    }
+    if (magnitude >= HALF_OVERFLOW_BITS)
+    {
+        return (uint16_t) (sign | HALF_INFINITY);
+    }
+    if (magnitude < HALF_MIN_NORMAL_BITS)
+    {
+        // the addition rounds to a multiple of 2^-24, the mantissa then holds the fp16 subnormal
+        float shifted;
+        std::memcpy(&shifted, &magnitude, sizeof(shifted));
+        shifted += FLOAT_HALF;
+        std::memcpy(&magnitude, &shifted, sizeof(magnitude));
+        return (uint16_t) (sign | (magnitude - HALF_SUBNORMAL_MAGIC_BITS));
+    }
+    magnitude += HALF_ROUND_BIAS + ((magnitude >> HALF_DROPPED_BITS) & ONE);
+    return (uint16_t) (sign | ((magnitude - HALF_REBIAS) >> HALF_DROPPED_BITS));
+}
+
+/**
+ * Widens fp16 bits to the float of the same value
+ * @param h fp16 bits
+ * @return the value
+ */
+float halfToFloat(uint16_t h)
+{
+    const uint32_t sign = (uint32_t) (h & HALF_SIGN_MASK) << BFLOAT16_DROPPED_BITS;
+    const uint32_t exponent = (h >> HALF_MANTISSA_BITS) & HALF_EXPONENT_MASK;
+    const uint32_t mantissa = h & HALF_MANTISSA_MASK;
+    uint32_t bits;
+    if (exponent == HALF_EXPONENT_MASK)
+    {
+        bits = sign | FLOAT_INFINITY_BITS | (mantissa << HALF_DROPPED_BITS);
+        bits |= (mantissa != ZERO) ? FLOAT_QUIET_BIT : ZERO;
+    }
+    else if (exponent == ZERO)
+    {
+        float subnormal = (float) mantissa * HALF_SUBNORMAL_UNIT;
+        std::memcpy(&bits, &subnormal, sizeof(bits));
+        bits |= sign;
+    }
+    else
+    {
+        bits = sign | (((exponent << HALF_MANTISSA_BITS) | mantissa) << HALF_DROPPED_BITS);
+        bits += HALF_REBIAS;
+    }
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * Rounds a float to the nearest bf16 value, ties to even
+ * @param v value
+ * @return the bf16 bits
+ */
+uint16_t floatToBFloat16(float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    if ((bits & MAGNITUDE_MASK) > FLOAT_INFINITY_BITS)
+    {
+        return (uint16_t) ((bits >> BFLOAT16_DROPPED_BITS) | BFLOAT16_QUIET_BIT);
+    }
+    bits += BFLOAT16_ROUND_BIAS + ((bits >> BFLOAT16_DROPPED_BITS) & ONE);
+    return (uint16_t) (bits >> BFLOAT16_DROPPED_BITS);
+}
+
+/**
+ * Widens bf16 bits to the float of the same value
+ * @param h bf16 bits
+ * @return the value
+ */
+float bfloat16ToFloat(uint16_t h)
+{
+    const uint32_t bits = (uint32_t) h << BFLOAT16_DROPPED_BITS;
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static float scalarDotHalf(const uint16_t *w, const float *x, int n, HalfFormat format)
+{
+    float acc[HALF_LANES] = {};
+    for (int i = 0; i < n; i += HALF_LANES)
+    {
+        for (int l = 0; l < HALF_LANES; l++)
+        {
+            float product = FLOAT_ZERO;
+            if (i + l < n)
+            {
+                product = ((format == Float16) ? halfToFloat(w[i + l]) : bfloat16ToFloat(w[i + l])) * x[i + l];
+            }
+            acc[l] += product;
+        }
+    }
+    // halving, lane l with lane l + width, the order the vector kernels fold their registers in
+    for (int width = HALF_LANES / 2; width > 0; width /= 2)
+    {
+        for (int l = 0; l < width; l++)
+        {
+            acc[l] += acc[l + width];
+        }
+    }
+    return acc[0];
+}
+
+#ifdef HALF_X86
+
+// the last partial block is staged through zero padded copies, the padding adds 0 * 0 like the scalar lanes
+
+__attribute__((target("avx2,f16c"))) static inline __m256 avx2Widen(const uint16_t *w, HalfFormat format)
+{
+    __m128i h = _mm_loadu_si128((const __m128i *) w);
+    if (format == Float16)
+    {
+        return _mm256_cvtph_ps(h);
+    }
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), BFLOAT16_DROPPED_BITS));
+}
+
+__attribute__((target("avx2,f16c"))) static float avx2DotHalf(const uint16_t *w, const float *x, int n,
+                                                              HalfFormat format)
+{
+    __m256 low = _mm256_setzero_ps();
+    __m256 high = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + HALF_LANES <= n; i += HALF_LANES)
+    {
+        low = _mm256_add_ps(low, _mm256_mul_ps(avx2Widen(w + i, format), _mm256_loadu_ps(x + i)));
+        high = _mm256_add_ps(high, _mm256_mul_ps(avx2Widen(w + i + 8, format), _mm256_loadu_ps(x + i + 8)));
+    }
+    if (i < n)
+    {
+        uint16_t wTail[HALF_LANES] = {};
+        float xTail[HALF_LANES] = {};
+        for (int l = 0; l < n - i; l++)
+        {
+            wTail[l] = w[i + l];
+            xTail[l] = x[i + l];
+        }
+        low = _mm256_add_ps(low, _mm256_mul_ps(avx2Widen(wTail, format), _mm256_loadu_ps(xTail)));
+        high = _mm256_add_ps(high, _mm256_mul_ps(avx2Widen(wTail + 8, format), _mm256_loadu_ps(xTail + 8)));
+    }
+    __m256 eight = _mm256_add_ps(low, high);
+    __m128 quarter = _mm_add_ps(_mm256_castps256_ps128(eight), _mm256_extractf128_ps(eight, 1));
+    __m128 pair = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+
+// the unmasked conversions, shifts and extracts start from an undefined register that gcc 12 reports as
+// uninitialized, the zero-masked forms are the same
+__attribute__((target("avx512f"))) static inline __m512 avx512Widen(const uint16_t *w, HalfFormat format)
+{
+    const __mmask16 all = (__mmask16) ~0u;
+    __m256i h = _mm256_loadu_si256((const __m256i *) w);
+    if (format == Float16)
+    {
+        return _mm512_maskz_cvtph_ps(all, h);
+    }
+    return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(all, _mm512_maskz_cvtepu16_epi32(all, h),
+                                                       BFLOAT16_DROPPED_BITS));
+}
+
+__attribute__((target("avx512f"))) static float avx512DotHalf(const uint16_t *w, const float *x, int n,
+                                                              HalfFormat format)
+{
+    const __mmask8 all = (__mmask8) ~0u;
+    __m512 acc = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + HALF_LANES <= n; i += HALF_LANES)
+    {
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(avx512Widen(w + i, format), _mm512_loadu_ps(x + i)));
+    }
+    if (i < n)
+    {
+        uint16_t wTail[HALF_LANES] = {};
+        float xTail[HALF_LANES] = {};
+        for (int l = 0; l < n - i; l++)
+        {
+            wTail[l] = w[i + l];
+            xTail[l] = x[i + l];
+        }
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(avx512Widen(wTail, format), _mm512_loadu_ps(xTail)));
+    }
+    __m256 low = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(all, _mm512_castps_pd(acc), 0));
+    __m256 high = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(all, _mm512_castps_pd(acc), 1));
+    __m256 eight = _mm256_add_ps(low, high);
+    __m128 quarter = _mm_add_ps(_mm256_castps256_ps128(eight), _mm256_extractf128_ps(eight, 1));
+    __m128 pair = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+
+#endif //HALF_X86
+
+/**
+ * Queries cpuid and picks the widest supported 16 bit dot product
+ * @return the kernel
+ */
+static float (*selectDot())(const uint16_t *, const float *, int, HalfFormat)
+{
+#ifdef HALF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return avx512DotHalf;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+    {
+        return avx2DotHalf;
+    }
+#endif
+    return scalarDotHalf;
+}
+
+/**
+ * Dot product of 16 bit weights and a float vector, accumulated in float, dispatched to AVX-512,
+ * F16C/AVX2 or scalar code at runtime. The products are summed in 16 interleaved partial sums
+ * folded in a fixed order, all variants give the same exact result.
+ * @param w weights
+ * @param x float vector
+ * @param n amount of elements
+ * @param format format of the weights
+ * @return the dot product
+ */
+float dotHalf(const uint16_t *w, const float *x, int n, HalfFormat format)
+{
+    static float (*const dot)(const uint16_t *, const float *, int, HalfFormat) = selectDot();
+    return dot(w, x, n, format);
+}
+
+/**
+ * Constructor - rounds the weights of a float layer to a 16 bit format
+ * @param dense the float layer
+ * @param format Float16 (more mantissa) or BFloat16 (the float exponent range)
+ */
+HalfDense::HalfDense(const Dense &dense, HalfFormat format) : _rowsNum(dense.getWeights().getRows()),
+                                                              _colsNum(dense.getWeights().getCols()),
+                                                              _format(format),
+                                                              _w(dense.getWeights().size()),
+                                                              _bias(dense.getBias().data(),
+                                                                    dense.getBias().data() + dense.getBias().size()),
+                                                              _activationType(dense.getActivation().getActivationType())
+{
+    const float *w = dense.getWeights().data();
+    for (size_t i = 0; i < _w.size(); i++)
+    {
+        _w[i] = (format == Float16) ? floatToHalf(w[i]) : floatToBFloat16(w[i]);
+    }
+}
+
+/**
+ * getter - returns the format of the weights
+ */
+HalfFormat HalfDense::getFormat() const
+{
+    return _format;
+}
+
+/**
+ * getter - returns the amount of output rows
+ */
+int HalfDense::getRows() const
+{
+    return _rowsNum;
+}
+
+/**
+ * getter - returns the amount of input cols
+ */
+int HalfDense::getCols() const
+{
+    return _colsNum;
+}
+
+/**
+ * Applies the layer on a single input vector
+ * @param x pointer to getCols() floats
+ * @param y pointer to getRows() floats, overwritten with the activated outputs
+ */
+void HalfDense::apply(const float *x, float *y) const
+{
+    for (int i = 0; i < _rowsNum; i++)
+    {
+        float z = dotHalf(_w.data() + (size_t) i * _colsNum, x, _colsNum, _format) + _bias[i];
+        y[i] = (_activationType == Relu && z < FLOAT_ZERO) ? FLOAT_ZERO : z;
+    }
+    if (_activationType == Softmax)
+    {
+        vecSoftmax(y, y, _rowsNum);
+    }
+}
+
+/**
+ * Parenthesis operator - Applies the layer on a single input vector
+ * @param m matrix of getCols() × 1
+ * @return result matrix of getRows() × 1
+ */
+Matrix HalfDense::operator()(const Matrix &m) const
+{
+    if (m.getRows() != _colsNum || m.getCols() != ONE)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    Matrix result = Matrix(_rowsNum, ONE);
+    apply(m.data(), result.data());
+    return result;
+}
@@ -0,0 +1,113 @@
+// HalfDense.h
+
+#ifndef HALFDENSE_H
+#define HALFDENSE_H
+
+#include "Dense.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum HalfFormat
+ * @brief 16 bit float format of stored weights
+ */
+enum HalfFormat
+{
+    Float16,
+    BFloat16
+};
+
+/**
+ * A copy of a Dense layer with 16 bit weights, half the weight bytes of the float layer. The weights
+ * are rounded to the nearest fp16 or bf16 value once, every product widens them back to float on
+ * the fly and accumulates in float.
+ */
+class HalfDense
+{
+public:
+    /**
+     * Constructor - rounds the weights of a float layer to a 16 bit format
+     * @param dense the float layer
+     * @param format Float16 (more mantissa) or BFloat16 (the float exponent range)
+     */
+    HalfDense(const Dense &dense, HalfFormat format);
+
+    /**
+     * getter - returns the format of the weights
+     */
+    HalfFormat getFormat() const;
+
+    /**
+     * getter - returns the amount of output rows
+     */
+    int getRows() const;
+
+    /**
+     * getter - returns the amount of input cols
+     */
+    int getCols() const;
+
+    /**
+     * Applies the layer on a single input vector
+     * @param x pointer to getCols() floats
+     * @param y pointer to getRows() floats, overwritten with the activated outputs
+     */
+    void apply(const float *x, float *y) const;
+
+    /**
+     * Parenthesis operator - Applies the layer on a single input vector
+     * @param m matrix of getCols() × 1
+     * @return result matrix of getRows() × 1
+     */
+    Matrix operator()(const Matrix &m) const;
+
+private:
+    int _rowsNum;
+    int _colsNum;
+    HalfFormat _format;
+    std::vector<uint16_t> _w;
+    std::vector<float> _bias;
+    ActivationType _activationType;
+};
+
+/**
+ * Rounds a float to the nearest fp16 value, ties to even, out of range values become infinities
+ * @param v value
+ * @return the fp16 bits
+ */
+uint16_t floatToHalf(float v);
+
+/**
+ * Widens fp16 bits to the float of the same value
+ * @param h fp16 bits
+ * @return the value
+ */
+float halfToFloat(uint16_t h);
+
+/**
+ * Rounds a float to the nearest bf16 value, ties to even
+ * @param v value
+ * @return the bf16 bits
+ */
+uint16_t floatToBFloat16(float v);
+
+/**
+ * Widens bf16 bits to the float of the same value
+ * @param h bf16 bits
+ * @return the value
+ */
+float bfloat16ToFloat(uint16_t h);
+
+/**
+ * Dot product of 16 bit weights and a float vector, accumulated in float, dispatched to AVX-512,
+ * F16C/AVX2 or scalar code at runtime. The products are summed in 16 interleaved partial sums
+ * folded in a fixed order, all variants give the same exact result.
+ * @param w weights
+ * @param x float vector
+ * @param n amount of elements
+ * @param format format of the weights
+ * @return the dot product
+ */
+float dotHalf(const uint16_t *w, const float *x, int n, HalfFormat format);
+
+#endif //HALFDENSE_H
@@ -0,0 +1,208 @@
+#include "ImageStream.h"
+#include <iostream>
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define IMAGE_FORMAT_ERROR "Error: invalid image file"
+#define IDX3_HEADER_WORDS 4
+#define PIXEL_MAX 255.0f
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Decodes a big endian 32 bit word
+ * @param bytes the 4 bytes
+ * @return the value
+ */
+static uint32_t bigEndian(const unsigned char *bytes)
+{
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+/**
+ * Reports an unreadable image file and terminates
+ */
+static void formatError()
+{
+    std::cerr << IMAGE_FORMAT_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Constructor - opens a file and starts reading the first chunk, terminates when the file
+ * cannot be read or does not hold whole images
+ * @param path path of the image file
+ * @param imageSize floats per image of a raw float file, ignored for idx3 files
+ * @param chunkImages images per chunk, positive
+ */
+ImageStream::ImageStream(const std::string &path, int imageSize, int chunkImages) :
+        _file(path, std::ios::binary), _idx(false), _imageCount(ZERO), _imageSize(imageSize),
+        _chunkImages(chunkImages), _current(ZERO), _holding(false), _stopping(false)
+{
+    if (!_file.good() || chunkImages <= ZERO)
+    {
+        std::cerr << READ_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    _file.seekg(ZERO, std::ios::end);
+    const uint64_t length = (uint64_t) _file.tellg();
+    _file.seekg(ZERO, std::ios::beg);
+
+    unsigned char header[IDX3_HEADER_WORDS * sizeof(uint32_t)];
+    if (length >= sizeof(header) && _file.read((char *) header, sizeof(header)) && bigEndian(header) == IDX3_MAGIC)
+    {
+        _idx = true;
+        const uint64_t count = bigEndian(header + sizeof(uint32_t));
+        const uint64_t pixels = (uint64_t) bigEndian(header + 2 * sizeof(uint32_t)) *
+                                bigEndian(header + 3 * sizeof(uint32_t));
+        if (pixels == ZERO || pixels > INT32_MAX || count * pixels != length - sizeof(header))
+        {
+            formatError();
+        }
+        _imageSize = (int) pixels;
+        _imageCount = (int) count;
+    }
+    else
+    {
+        _file.clear();
+        _file.seekg(ZERO, std::ios::beg);
+        const uint64_t imageBytes = (uint64_t) imageSize * sizeof(float);
+        if (imageSize <= ZERO || length % imageBytes != ZERO || length / imageBytes > INT32_MAX)
+        {
+            formatError();
+        }
+        _imageCount = (int) (length / imageBytes);
+    }
+    for (Chunk &chunk : _chunks)
+    {
+        chunk.images.resize((size_t) _chunkImages * _imageSize);
+        chunk.count = ZERO;
+        chunk.full = false;
+        chunk.failed = false;
+    }
+    _reader = std::thread(&ImageStream::_readerLoop, this);
+}
+
+/**
+ * destructor, stops and joins the reader thread
+ */
+ImageStream::~ImageStream()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _changed.notify_all();
+    _reader.join();
+}
+
+/**
+ * getter - returns the amount of images in the file
+ */
+int ImageStream::getImageCount() const
+{
+    return _imageCount;
+}
+
+/**
+ * getter - returns the amount of floats per image
+ */
+int ImageStream::getImageSize() const
+{
+    return _imageSize;
+}
+
+/**
+ * Hands out the next chunk, waits for the reader if it is not loaded yet. The previous chunk is
+ * given back to the reader and must not be used any more. Terminates when the reader could not
+ * read the chunk, e.g. because the file was cut short after it was opened.
+ * @param images set to the first float of the chunk, images stored one after the other
+ * @return amount of images in the chunk, 0 after the last one
+ */
+int ImageStream::next(const float *&images)
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    if (_holding)
+    {
+        _chunks[_current].full = false;
+        _current ^= ONE;
+        _holding = false;
+        _changed.notify_all();
+    }
+    Chunk &chunk = _chunks[_current];
+    _changed.wait(guard, [&chunk]()
+    { return chunk.full; });
+    // the reader has stopped, the error is reported on the thread that asked for the images
+    if (chunk.failed)
+    {
+        std::cerr << READ_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    // the empty chunk that marks the end stays full, every later call returns 0 again
+    _holding = chunk.count > ZERO;
+    images = chunk.images.data();
+    return chunk.count;
+}
+
+/**
+ * Main loop of the reader thread, fills the chunks in turn until the file is exhausted or cannot
+ * be read, a failed read is handed to the caller with the chunk
+ */
+void ImageStream::_readerLoop()
+{
+    int remaining = _imageCount;
+    int slot = ZERO;
+    while (true)
+    {
+        Chunk &chunk = _chunks[slot];
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _changed.wait(guard, [this, &chunk]()
+            { return _stopping || !chunk.full; });
+            if (_stopping)
+            {
+                return;
+            }
+        }
+        // the caller never touches a chunk that is not full, the file is read without the lock
+        const int count = (remaining < _chunkImages) ? remaining : _chunkImages;
+        const bool loaded = _load(chunk.images.data(), count);
+        remaining -= count;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            chunk.count = loaded ? count : ZERO;
+            chunk.failed = !loaded;
+            chunk.full = true;
+        }
+        _changed.notify_all();
+        if (count == ZERO || !loaded)
+        {
+            return;
+        }
+        slot ^= ONE;
+    }
+}
+
+/**
+ * Reads and converts count images into dst
+ * @param dst count × _imageSize floats
+ * @param count amount of images
+ * @return false when the file could not be read
+ */
+bool ImageStream::_load(float *dst, int count)
+{
+    const size_t values = (size_t) count * _imageSize;
+    if (!_idx)
+    {
+        _file.read((char *) dst, (std::streamsize) (values * sizeof(float)));
+    }
+    else
+    {
+        // the bytes land in the back quarter of dst and are widened front to back, never overtaking them
+        unsigned char *bytes = (unsigned char *) (dst + values) - values;
+        _file.read((char *) bytes, (std::streamsize) values);
+        for (size_t i = 0; i < values; i++)
+        {
+            dst[i] = (float) bytes[i] / PIXEL_MAX;
+        }
+    }
+    return _file.good() || values == ZERO;
+}
@@ -0,0 +1,112 @@
+// ImageStream.h
+
+#ifndef IMAGESTREAM_H
+#define IMAGESTREAM_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Images handed out per chunk, a chunk of 28×28 float images is about 3 MB.
+ */
+#define IMAGE_CHUNK 1024
+
+/*
+ * First word of an MNIST idx3-ubyte image file: unsigned bytes, 3 dimensions.
+ */
+#define IDX3_MAGIC 0x00000803
+
+/**
+ * Reads a file of many images chunk by chunk. A reader thread loads and converts the next chunk into
+ * one buffer while the caller works on the previous chunk in the other, so the caller only waits for
+ * the disk. Two file layouts are understood:
+ *   MNIST idx3-ubyte    big endian header (magic, count, rows, cols) then count × rows × cols bytes,
+ *                       pixels are scaled to [0, 1]
+ *   raw float images    count × imageSize native floats, the layout operator>> reads one image from
+ */
+class ImageStream
+{
+public:
+    /**
+     * Constructor - opens a file and starts reading the first chunk, terminates when the file
+     * cannot be read or does not hold whole images
+     * @param path path of the image file
+     * @param imageSize floats per image of a raw float file, ignored for idx3 files
+     * @param chunkImages images per chunk, positive
+     */
+    ImageStream(const std::string &path, int imageSize, int chunkImages = IMAGE_CHUNK);
+
+    /**
+     * destructor, stops and joins the reader thread
+     */
+    ~ImageStream();
+
+    ImageStream(const ImageStream &) = delete;
+    ImageStream &operator=(const ImageStream &) = delete;
+
+    /**
+     * getter - returns the amount of images in the file
+     */
+    int getImageCount() const;
+
+    /**
+     * getter - returns the amount of floats per image
+     */
+    int getImageSize() const;
+
+    /**
+     * Hands out the next chunk, waits for the reader if it is not loaded yet. The previous chunk is
+     * given back to the reader and must not be used any more. Terminates when the reader could not
+     * read the chunk, e.g. because the file was cut short after it was opened.
+     * @param images set to the first float of the chunk, images stored one after the other
+     * @return amount of images in the chunk, 0 after the last one
+     */
+    int next(const float *&images);
+
+private:
+    /**
+     * One of the two buffers, filled by the reader and drained by the caller
+     */
+    struct Chunk
+    {
+        std::vector<float> images;
+        int count;
+        bool full;
+        // the reader failed on this chunk, it is full but holds nothing
+        bool failed;
+    };
+
+    std::ifstream _file;
+    bool _idx;
+    int _imageCount;
+    int _imageSize;
+    int _chunkImages;
+    Chunk _chunks[2];
+    int _current;
+    bool _holding;
+    bool _stopping;
+    std::mutex _lock;
+    std::condition_variable _changed;
+    std::thread _reader;
+
+    /**
+     * Main loop of the reader thread, fills the chunks in turn until the file is exhausted or cannot
+     * be read, a failed read is handed to the caller with the chunk
+     */
+    void _readerLoop();
+
+    /**
+     * Reads and converts count images into dst
+     * @param dst count × _imageSize floats
+     * @param count amount of images
+     * @return false when the file could not be read
+     */
+    bool _load(float *dst, int count);
+};
+
+#endif //IMAGESTREAM_H
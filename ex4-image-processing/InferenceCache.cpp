@@ -0,0 +1,247 @@
+#include "InferenceCache.h"
+#include <algorithm>
+#include <cstring>
+#define CAPACITY_ERROR_MSG "Error: cache capacity must be positive"
+#define ZERO 0
+#define HASH_PRIME_1 0x9E3779B185EBCA87ull
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME_3 0x165667B19E3779F9ull
+#define HASH_PRIME_4 0x85EBCA77C2B2AE63ull
+#define HASH_LANES 4
+#define HASH_SHARD_SHIFT 32
+
+/**
+ * Rotates a word left
+ * @param v the word
+ * @param bits amount of bits, in (0, 64)
+ */
+static inline uint64_t rotateLeft(uint64_t v, int bits)
+{
+    return (v << bits) | (v >> (64 - bits));
+}
+
+/**
+ * Mixes one input word into an accumulator
+ * @param acc accumulator
+ * @param word input
+ * @return the new accumulator
+ */
+static inline uint64_t hashRound(uint64_t acc, uint64_t word)
+{
+    return rotateLeft(acc + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+}
+
+/**
+ * 64 bit hash of the bits of an image
+ * @param image pointer to the floats
+ * @param size amount of floats
+ * @return the hash
+ */
+uint64_t InferenceCache::hashImage(const float *image, int size)
+{
+    // xxHash64 style, four independent multiply-rotate lanes so the rounds overlap, then an avalanche
+    const unsigned char *bytes = (const unsigned char *) image;
+    const size_t length = (size_t) size * sizeof(float);
+    uint64_t lanes[HASH_LANES] = {HASH_PRIME_1 + HASH_PRIME_2, HASH_PRIME_2, ZERO, ZERO - HASH_PRIME_1};
+    size_t i = 0;
+    for (; i + HASH_LANES * sizeof(uint64_t) <= length; i += HASH_LANES * sizeof(uint64_t))
+    {
+        for (int l = 0; l < HASH_LANES; l++)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i + l * sizeof(uint64_t), sizeof(word));
+            lanes[l] = hashRound(lanes[l], word);
+        }
+    }
+    uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) +
+                    rotateLeft(lanes[3], 18) + length;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = rotateLeft(hash ^ hashRound(ZERO, word), 27) * HASH_PRIME_1 + HASH_PRIME_4;
+    }
+    if (i < length)
+    {
+        uint32_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = rotateLeft(hash ^ (word * HASH_PRIME_1), 23) * HASH_PRIME_2 + HASH_PRIME_3;
+    }
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME_3;
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Constructor - an empty cache, the network has to outlive it
+ * @param network the network answering the misses
+ * @param capacity most results kept, positive. Split as evenly as it goes across
+ * min(capacity, CACHE_SHARDS) shards, each evicting its own least recently used entry when full,
+ * so the total never exceeds capacity but a shard may evict while others still have room.
+ */
+InferenceCache::InferenceCache(const MlpNetwork &network, size_t capacity) : _network(network),
+                                                                              _shardCount(ZERO)
+{
+    if (capacity == ZERO)
+    {
+        std::cerr << CAPACITY_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    _shardCount = std::min(capacity, (size_t) CACHE_SHARDS);
+    for (size_t s = 0; s < CACHE_SHARDS; s++)
+    {
+        Shard &shard = _shards[s];
+        shard.stats = CacheStats{ZERO, ZERO, ZERO, ZERO};
+        // the first capacity % _shardCount shards take one entry of the remainder each
+        shard.capacity = (s < _shardCount) ? capacity / _shardCount + ((s < capacity % _shardCount) ? 1 : 0) : ZERO;
+        shard.index.reserve(shard.capacity);
+    }
+}
+
+/**
+ * Parenthesis operator - the result of the network on img, from the cache when it is there
+ * @param img - matrix
+ * @return digit struct
+ */
+Digit InferenceCache::operator()(const Matrix &img)
+{
+    const uint64_t hash = hashImage(img.data(), img.size());
+    Digit digit;
+    if (_lookup(hash, digit))
+    {
+        return digit;
+    }
+    digit = _network(img);
+    _insert(hash, digit);
+    return digit;
+}
+
+/**
+ * Classifies images stored one after the other, the misses go through the network as one batch
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images
+ * @return digit struct of every image, in order
+ */
+std::vector<Digit> InferenceCache::classify(const float *images, int count)
+{
+    const int imgSize = imgDims.rows * imgDims.cols;
+    std::vector<Digit> digits(count);
+    std::vector<uint64_t> hashes(count);
+    std::vector<int> misses;
+    for (int j = 0; j < count; j++)
+    {
+        hashes[j] = hashImage(images + (size_t) j * imgSize, imgSize);
+        if (!_lookup(hashes[j], digits[j]))
+        {
+            misses.push_back(j);
+        }
+    }
+    if (misses.empty())
+    {
+        return digits;
+    }
+    std::vector<float> batch((size_t) misses.size() * imgSize);
+    for (size_t m = 0; m < misses.size(); m++)
+    {
+        const float *img = images + (size_t) misses[m] * imgSize;
+        std::copy(img, img + imgSize, batch.begin() + m * imgSize);
+    }
+    std::vector<Digit> computed = _network.classify(batch.data(), (int) misses.size());
+    for (size_t m = 0; m < misses.size(); m++)
+    {
+        digits[misses[m]] = computed[m];
+        _insert(hashes[misses[m]], computed[m]);
+    }
+    return digits;
+}
+
+/**
+ * Returns the counters summed over every shard
+ */
+CacheStats InferenceCache::getStats() const
+{
+    CacheStats total{ZERO, ZERO, ZERO, ZERO};
+    for (const Shard &shard : _shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        total.hits += shard.stats.hits;
+        total.misses += shard.stats.misses;
+        total.evictions += shard.stats.evictions;
+        total.entries += shard.order.size();
+    }
+    return total;
+}
+
+/**
+ * Drops every cached result, the counters are kept
+ */
+void InferenceCache::clear()
+{
+    for (Shard &shard : _shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.order.clear();
+        shard.index.clear();
+    }
+}
+
+/**
+ * Returns the shard of a hash
+ * @param hash image hash
+ */
+InferenceCache::Shard &InferenceCache::_shardOf(uint64_t hash)
+{
+    // the high half, the buckets of the shard's map are picked by the low bits
+    return _shards[(hash >> HASH_SHARD_SHIFT) % _shardCount];
+}
+
+/**
+ * Looks a hash up and counts a hit or a miss, a hit becomes the most recently used entry
+ * @param hash image hash
+ * @param digit set to the cached result on a hit
+ * @return true on a hit
+ */
+bool InferenceCache::_lookup(uint64_t hash, Digit &digit)
+{
+    Shard &shard = _shardOf(hash);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(hash);
+    if (found == shard.index.end())
+    {
+        shard.stats.misses++;
+        return false;
+    }
+    shard.stats.hits++;
+    shard.order.splice(shard.order.begin(), shard.order, found->second);
+    digit = found->second->second;
+    return true;
+}
+
+/**
+ * Stores a result as the most recently used entry, evicting the least recently used one when
+ * the shard is full
+ * @param hash image hash
+ * @param digit the result
+ */
+void InferenceCache::_insert(uint64_t hash, const Digit &digit)
+{
+    Shard &shard = _shardOf(hash);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(hash);
+    if (found != shard.index.end())
+    {
+        // another thread computed the same image meanwhile
+        shard.order.splice(shard.order.begin(), shard.order, found->second);
+        return;
+    }
+    if (shard.order.size() >= shard.capacity)
+    {
+        shard.index.erase(shard.order.back().first);
+        shard.order.pop_back();
+        shard.stats.evictions++;
+    }
+    shard.order.emplace_front(hash, digit);
+    shard.index.emplace(hash, shard.order.begin());
+}
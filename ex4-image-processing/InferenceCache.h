@@ -0,0 +1,128 @@
+// InferenceCache.h
+
+#ifndef INFERENCECACHE_H
+#define INFERENCECACHE_H
+
+#include "MlpNetwork.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * The cache is split into up to CACHE_SHARDS independently locked LRU lists, picked by the image
+ * hash, so concurrent lookups of different images rarely wait on each other.
+ */
+#define CACHE_SHARDS 16
+
+/**
+ * @struct CacheStats
+ * @brief Counters of an inference cache
+ */
+typedef struct CacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+} CacheStats;
+
+/**
+ * A bounded least recently used cache of results in front of a MlpNetwork. Images are keyed by a
+ * 64 bit hash of their pixels alone, two different images share a result only on a hash collision
+ * (about n² / 2^65 for n distinct images). Thread safe, the network runs outside of every lock.
+ */
+class InferenceCache
+{
+public:
+    /**
+     * Constructor - an empty cache, the network has to outlive it
+     * @param network the network answering the misses
+     * @param capacity most results kept, positive. Split as evenly as it goes across
+     * min(capacity, CACHE_SHARDS) shards, each evicting its own least recently used entry when full,
+     * so the total never exceeds capacity but a shard may evict while others still have room.
+     */
+    InferenceCache(const MlpNetwork &network, size_t capacity);
+
+    InferenceCache(const InferenceCache &) = delete;
+    InferenceCache &operator=(const InferenceCache &) = delete;
+
+    /**
+     * Parenthesis operator - the result of the network on img, from the cache when it is there
+     * @param img - matrix
+     * @return digit struct
+     */
+    Digit operator()(const Matrix &img);
+
+    /**
+     * Classifies images stored one after the other, the misses go through the network as one batch
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images
+     * @return digit struct of every image, in order
+     */
+    std::vector<Digit> classify(const float *images, int count);
+
+    /**
+     * Returns the counters summed over every shard
+     */
+    CacheStats getStats() const;
+
+    /**
+     * Drops every cached result, the counters are kept
+     */
+    void clear();
+
+    /**
+     * 64 bit hash of the bits of an image
+     * @param image pointer to the floats
+     * @param size amount of floats
+     * @return the hash
+     */
+    static uint64_t hashImage(const float *image, int size);
+
+private:
+    typedef std::pair<uint64_t, Digit> Entry;
+
+    /**
+     * One independently locked part of the cache, the list runs from the most to the least
+     * recently used entry
+     */
+    struct Shard
+    {
+        mutable std::mutex lock;
+        std::list<Entry> order;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        CacheStats stats;
+        size_t capacity;
+    };
+
+    const MlpNetwork &_network;
+    size_t _shardCount;
+    Shard _shards[CACHE_SHARDS];
+
+    /**
+     * Returns the shard of a hash
+     * @param hash image hash
+     */
+    Shard &_shardOf(uint64_t hash);
+
+    /**
+     * Looks a hash up and counts a hit or a miss, a hit becomes the most recently used entry
+     * @param hash image hash
+     * @param digit set to the cached result on a hit
+     * @return true on a hit
+     */
+    bool _lookup(uint64_t hash, Digit &digit);
+
+    /**
+     * Stores a result as the most recently used entry, evicting the least recently used one when
+     * the shard is full
+     * @param hash image hash
+     * @param digit the result
+     */
+    void _insert(uint64_t hash, const Digit &digit);
+};
+
+#endif //INFERENCECACHE_H
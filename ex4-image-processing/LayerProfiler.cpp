@@ -0,0 +1,154 @@
+#include "LayerProfiler.h"
+#define LAYER_ERROR_MSG "Error: invalid layer index"
+#define PERCENTILE_MEDIAN 0.5
+#define PERCENTILE_TAIL 0.99
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Histogram bucket of a latency, exact below 2^HISTOGRAM_SUB_BITS ns then log-linear
+ * @param nanoseconds the latency
+ * @return bucket index
+ */
+static int bucketOf(uint64_t nanoseconds)
+{
+    if (nanoseconds < (ONE << HISTOGRAM_SUB_BITS))
+    {
+        return (int) nanoseconds;
+    }
+    const int exponent = 63 - __builtin_clzll(nanoseconds);
+    const int shift = exponent - HISTOGRAM_SUB_BITS;
+    const int sub = (int) ((nanoseconds >> shift) & ((ONE << HISTOGRAM_SUB_BITS) - ONE));
+    return ((shift + ONE) << HISTOGRAM_SUB_BITS) + sub;
+}
+
+/**
+ * Largest latency that falls into a bucket
+ * @param bucket bucket index
+ * @return the latency in ns
+ */
+static uint64_t bucketUpperBound(int bucket)
+{
+    if (bucket < (ONE << HISTOGRAM_SUB_BITS))
+    {
+        return (uint64_t) bucket;
+    }
+    const int shift = (bucket >> HISTOGRAM_SUB_BITS) - ONE;
+    const uint64_t sub = (uint64_t) (bucket & ((ONE << HISTOGRAM_SUB_BITS) - ONE));
+    const uint64_t first = ((uint64_t) ONE << (shift + HISTOGRAM_SUB_BITS)) + (sub << shift);
+    return first + ((uint64_t) ONE << shift) - ONE;
+}
+
+/**
+ * Records one call of a layer
+ * @param layer layer index
+ * @param nanoseconds wall time of the call
+ * @param images amount of images in the call
+ * @param flops floating point operations of the call
+ * @param bytes bytes of weights, biases, inputs and outputs the call touched
+ * @param allocations Matrix buffers allocated during the call (by any thread)
+ */
+void LayerProfiler::record(int layer, uint64_t nanoseconds, uint64_t images, uint64_t flops, uint64_t bytes,
+                           uint64_t allocations)
+{
+    if (layer < ZERO)
+    {
+        std::cerr << LAYER_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::lock_guard<std::mutex> guard(_lock);
+    while ((int) _layers.size() <= layer)
+    {
+        _layers.push_back({ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, std::vector<uint64_t>(HISTOGRAM_BUCKETS, ZERO)});
+    }
+    LayerRecord &record = _layers[layer];
+    record.calls++;
+    record.images += images;
+    record.nanoseconds += nanoseconds;
+    record.flops += flops;
+    record.bytes += bytes;
+    record.allocations += allocations;
+    record.histogram[bucketOf(nanoseconds)]++;
+}
+
+/**
+ * Forgets everything recorded so far
+ */
+void LayerProfiler::reset()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _layers.clear();
+}
+
+/**
+ * Writes the per layer report as a JSON object
+ * @param out output stream
+ */
+void LayerProfiler::dumpJson(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    out << "{\"layers\": [";
+    for (size_t i = 0; i < _layers.size(); i++)
+    {
+        const LayerRecord &record = _layers[i];
+        const double seconds = (double) record.nanoseconds * 1e-9;
+        out << ((i == ZERO) ? "" : ", ") << "{\"layer\": " << i << ", \"calls\": " << record.calls
+            << ", \"images\": " << record.images << ", \"total_ns\": " << record.nanoseconds
+            << ", \"p50_ns\": " << _percentile(record, PERCENTILE_MEDIAN)
+            << ", \"p99_ns\": " << _percentile(record, PERCENTILE_TAIL) << ", \"flops\": " << record.flops
+            << ", \"bytes\": " << record.bytes << ", \"allocations\": " << record.allocations
+            << ", \"gflops_per_s\": " << ((seconds > ZERO) ? (double) record.flops * 1e-9 / seconds : ZERO)
+            << "}";
+    }
+    out << "]}" << std::endl;
+}
+
+/**
+ * Writes the per layer report as CSV, a header line then one line per layer
+ * @param out output stream
+ */
+void LayerProfiler::dumpCsv(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    out << "layer,calls,images,total_ns,p50_ns,p99_ns,flops,bytes,allocations,gflops_per_s" << std::endl;
+    for (size_t i = 0; i < _layers.size(); i++)
+    {
+        const LayerRecord &record = _layers[i];
+        const double seconds = (double) record.nanoseconds * 1e-9;
+        out << i << ',' << record.calls << ',' << record.images << ',' << record.nanoseconds << ','
+            << _percentile(record, PERCENTILE_MEDIAN) << ',' << _percentile(record, PERCENTILE_TAIL) << ','
+            << record.flops << ',' << record.bytes << ',' << record.allocations << ','
+            << ((seconds > ZERO) ? (double) record.flops * 1e-9 / seconds : ZERO) << std::endl;
+    }
+}
+
+/**
+ * Returns the process wide profiler the MLP_PROFILED hooks report to
+ */
+LayerProfiler &LayerProfiler::global()
+{
+    // never destroyed, layers may still report while static objects are torn down
+    static LayerProfiler *profiler = new LayerProfiler();
+    return *profiler;
+}
+
+/**
+ * Latency below which a fraction of the calls of a layer finished
+ * @param record the layer
+ * @param fraction in (0, 1]
+ * @return upper bound of the histogram bucket holding that percentile, in ns
+ */
+uint64_t LayerProfiler::_percentile(const LayerRecord &record, double fraction)
+{
+    const double target = fraction * (double) record.calls;
+    uint64_t seen = ZERO;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += record.histogram[bucket];
+        if (seen > ZERO && (double) seen >= target)
+        {
+            return bucketUpperBound(bucket);
+        }
+    }
+    return ZERO;
+}
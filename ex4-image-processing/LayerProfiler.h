@@ -0,0 +1,129 @@
+// LayerProfiler.h
+
+#ifndef LAYERPROFILER_H
+#define LAYERPROFILER_H
+
+#include "Dense.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/*
+ * Per layer profiling of the forward passes, off unless the build sets -DMLP_PROFILE=1. When it is
+ * off MLP_PROFILED(...) expands to the layer call alone and no profiling code is compiled in.
+ */
+#ifndef MLP_PROFILE
+#define MLP_PROFILE 0
+#endif
+
+/*
+ * Latency histogram resolution: values below 2^HISTOGRAM_SUB_BITS ns get a bucket each, larger ones
+ * share 2^HISTOGRAM_SUB_BITS buckets per power of two, percentiles are within 1 / 16 of the truth.
+ */
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+/**
+ * Collects the wall time, FLOPs, bytes touched and Matrix allocations of every layer call and reports
+ * them per layer, with p50 / p99 latencies from a log-linear histogram. Thread safe.
+ */
+class LayerProfiler
+{
+public:
+    /**
+     * Records one call of a layer
+     * @param layer layer index
+     * @param nanoseconds wall time of the call
+     * @param images amount of images in the call
+     * @param flops floating point operations of the call
+     * @param bytes bytes of weights, biases, inputs and outputs the call touched
+     * @param allocations Matrix buffers allocated during the call (by any thread)
+     */
+    void record(int layer, uint64_t nanoseconds, uint64_t images, uint64_t flops, uint64_t bytes,
+                uint64_t allocations);
+
+    /**
+     * Forgets everything recorded so far
+     */
+    void reset();
+
+    /**
+     * Writes the per layer report as a JSON object
+     * @param out output stream
+     */
+    void dumpJson(std::ostream& out) const;
+
+    /**
+     * Writes the per layer report as CSV, a header line then one line per layer
+     * @param out output stream
+     */
+    void dumpCsv(std::ostream& out) const;
+
+    /**
+     * Returns the process wide profiler the MLP_PROFILED hooks report to
+     */
+    static LayerProfiler& global();
+
+private:
+    /**
+     * Totals and latency histogram of one layer
+     */
+    struct LayerRecord
+    {
+        uint64_t calls;
+        uint64_t images;
+        uint64_t nanoseconds;
+        uint64_t flops;
+        uint64_t bytes;
+        uint64_t allocations;
+        std::vector<uint64_t> histogram;
+    };
+
+    mutable std::mutex _lock;
+    std::vector<LayerRecord> _layers;
+
+    /**
+     * Latency below which a fraction of the calls of a layer finished
+     * @param record the layer
+     * @param fraction in (0, 1]
+     * @return upper bound of the histogram bucket holding that percentile, in ns
+     */
+    static uint64_t _percentile(const LayerRecord& record, double fraction);
+};
+
+/**
+ * Runs a layer call and reports it to LayerProfiler::global()
+ * @param index layer index
+ * @param layer the layer, for the FLOP and byte counts
+ * @param input the input of the call, one image per column
+ * @param call runs the layer and returns its output
+ * @return the output of the call
+ */
+template<class F>
+Matrix profileLayer(int index, const Dense& layer, const Matrix& input, F call)
+{
+    const uint64_t rows = (uint64_t) layer.getWeights().getRows();
+    const uint64_t cols = (uint64_t) layer.getWeights().getCols();
+    // batches hold one image per column, or one per row for Dense::applyRows
+    const uint64_t images = (uint64_t) ((input.getRows() == (int) cols) ? input.getCols() : input.getRows());
+    const uint64_t allocations = defaultMatrixPool().getStats().allocationCount;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Matrix output = call();
+    const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    // a multiply and an add per weight and image, then the bias and the activation per output
+    const uint64_t flops = (2 * rows * cols + 2 * rows) * images;
+    const uint64_t bytes = (rows * cols + rows + (cols + rows) * images) * sizeof(float);
+    LayerProfiler::global().record(index, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            elapsed).count(), images, flops, bytes, defaultMatrixPool().getStats().allocationCount - allocations);
+    return output;
+}
+
+#if MLP_PROFILE
+#define MLP_PROFILED(index, layer, input, call) profileLayer((index), (layer), (input), [&]() { return (call); })
+#else
+#define MLP_PROFILED(index, layer, input, call) (call)
+#endif
+
+#endif //LAYERPROFILER_H
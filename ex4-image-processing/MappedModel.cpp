@@ -0,0 +1,223 @@
+#include "MappedModel.h"
+#include "MlpNetwork.h"
+#include "MlpGraph.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define WRITE_FILE_ERROR "Error: could not write the model file"
+#define MODEL_FORMAT_ERROR "Error: invalid model file"
+#define LAYER_ERROR_MSG "Error: invalid layer index"
+#define MAGIC_LENGTH 4
+#define ZERO 0
+
+/**
+ * Rounds an offset up to the next section boundary
+ * @param offset byte offset
+ * @return aligned offset
+ */
+static uint64_t alignSection(uint64_t offset)
+{
+    return (offset + MODEL_ALIGNMENT - 1) / MODEL_ALIGNMENT * MODEL_ALIGNMENT;
+}
+
+/**
+ * Checks that a section of count floats is aligned and inside a file of length bytes
+ * @param offset section offset
+ * @param count amount of floats
+ * @param length file length
+ * @return true if valid
+ */
+static bool validSection(uint64_t offset, uint64_t count, size_t length)
+{
+    return offset % MODEL_ALIGNMENT == ZERO && offset <= length && count * sizeof(float) <= length - offset;
+}
+
+/**
+ * Terminates with the invalid model message
+ */
+static void formatError()
+{
+    std::cerr << MODEL_FORMAT_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Constructor - maps and validates a model file
+ * @param path path of the model file
+ */
+MappedModel::MappedModel(const std::string &path) : _mapping(nullptr), _length(ZERO), _layers(nullptr),
+                                                    _layerCount(ZERO)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < ZERO || fstat(fd, &info) != ZERO)
+    {
+        std::cerr << READ_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    _length = (size_t) info.st_size;
+    if (_length < sizeof(ModelFileHeader))
+    {
+        close(fd);
+        formatError();
+    }
+    // private and writable: the pages stay shared with other processes until somebody writes a view
+    _mapping = mmap(nullptr, _length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, ZERO);
+    close(fd);
+    if (_mapping == MAP_FAILED)
+    {
+        std::cerr << READ_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const ModelFileHeader *header = (const ModelFileHeader *) _mapping;
+    if (std::memcmp(header->magic, MODEL_MAGIC, MAGIC_LENGTH) != ZERO || header->version != MODEL_VERSION ||
+        header->layerCount == ZERO ||
+        header->layerCount > (_length - sizeof(ModelFileHeader)) / sizeof(ModelLayerEntry))
+    {
+        formatError();
+    }
+    _layerCount = (int) header->layerCount;
+    _layers = (const ModelLayerEntry *) (header + 1);
+    for (int i = 0; i < _layerCount; i++)
+    {
+        const ModelLayerEntry &layer = _layers[i];
+        if (layer.rows <= ZERO || layer.cols <= ZERO || (layer.activation != Relu && layer.activation != Softmax) ||
+            !validSection(layer.weightsOffset, (uint64_t) layer.rows * layer.cols, _length) ||
+            !validSection(layer.biasOffset, (uint64_t) layer.rows, _length))
+        {
+            formatError();
+        }
+    }
+}
+
+/**
+ * destructor, unmaps the file
+ */
+MappedModel::~MappedModel()
+{
+    munmap(_mapping, _length);
+}
+
+/**
+ * getter - returns the amount of layers
+ */
+int MappedModel::getLayerCount() const
+{
+    return _layerCount;
+}
+
+/**
+ * Returns a view of the weights of layer i
+ * @param i layer index
+ */
+Matrix MappedModel::getWeights(int i) const
+{
+    const ModelLayerEntry &layer = _layer(i);
+    return Matrix(layer.rows, layer.cols, (float *) ((char *) _mapping + layer.weightsOffset));
+}
+
+/**
+ * Returns a view of the bias of layer i
+ * @param i layer index
+ */
+Matrix MappedModel::getBias(int i) const
+{
+    const ModelLayerEntry &layer = _layer(i);
+    return Matrix(layer.rows, 1, (float *) ((char *) _mapping + layer.biasOffset));
+}
+
+/**
+ * Returns the activation type of layer i
+ * @param i layer index
+ */
+ActivationType MappedModel::getActivation(int i) const
+{
+    return (ActivationType) _layer(i).activation;
+}
+
+/**
+ * Writes a chain of layers as a model file
+ * @param path path of the model file
+ * @param network the network, anything with getLayerCount() and getLayer(i)
+ */
+template<class Network>
+static void writeLayers(const std::string &path, const Network &network)
+{
+    ModelFileHeader header{};
+    std::memcpy(header.magic, MODEL_MAGIC, MAGIC_LENGTH);
+    header.version = MODEL_VERSION;
+    header.layerCount = (uint32_t) network.getLayerCount();
+
+    std::vector<ModelLayerEntry> layers(header.layerCount);
+    uint64_t offset = alignSection(sizeof(ModelFileHeader) + layers.size() * sizeof(ModelLayerEntry));
+    for (int i = 0; i < network.getLayerCount(); i++)
+    {
+        const Dense &dense = network.getLayer(i);
+        layers[i].rows = dense.getWeights().getRows();
+        layers[i].cols = dense.getWeights().getCols();
+        layers[i].activation = dense.getActivation().getActivationType();
+        layers[i].weightsOffset = offset;
+        offset = alignSection(offset + dense.getWeights().size() * sizeof(float));
+        layers[i].biasOffset = offset;
+        offset = alignSection(offset + dense.getBias().size() * sizeof(float));
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write((const char *) &header, sizeof(header));
+    output.write((const char *) layers.data(), (std::streamsize) (layers.size() * sizeof(ModelLayerEntry)));
+    const char padding[MODEL_ALIGNMENT] = {};
+    for (int i = 0; i < network.getLayerCount(); i++)
+    {
+        const Dense &dense = network.getLayer(i);
+        output.write(padding, (std::streamsize) (layers[i].weightsOffset - (uint64_t) output.tellp()));
+        output.write((const char *) dense.getWeights().data(),
+                     (std::streamsize) (dense.getWeights().size() * sizeof(float)));
+        output.write(padding, (std::streamsize) (layers[i].biasOffset - (uint64_t) output.tellp()));
+        output.write((const char *) dense.getBias().data(), (std::streamsize) (dense.getBias().size() * sizeof(float)));
+    }
+    if (!output.good())
+    {
+        std::cerr << WRITE_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Writes the layers of a network as a model file
+ * @param path path of the model file
+ * @param network the network
+ */
+void MappedModel::write(const std::string &path, const MlpNetwork &network)
+{
+    writeLayers(path, network);
+}
+
+/**
+ * Writes the layers of a graph as a model file
+ * @param path path of the model file
+ * @param network the graph
+ */
+void MappedModel::write(const std::string &path, const MlpGraph &network)
+{
+    writeLayers(path, network);
+}
+
+/**
+ * Returns the entry of layer i, terminates on an invalid index
+ * @param i layer index
+ */
+const ModelLayerEntry &MappedModel::_layer(int i) const
+{
+    if (i < ZERO || i >= _layerCount)
+    {
+        std::cerr << LAYER_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return _layers[i];
+}
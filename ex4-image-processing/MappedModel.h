@@ -0,0 +1,127 @@
+// MappedModel.h
+
+#ifndef MAPPEDMODEL_H
+#define MAPPEDMODEL_H
+
+#include "Matrix.h"
+#include "Activation.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MlpNetwork;
+class MlpGraph;
+
+/*
+ * Single file model format, integers and floats in the byte order of the host that wrote it, so the
+ * weights can be mapped as they are (little endian on x86 and ARM; a file written on a host of the
+ * other order fails the version check):
+ *   ModelFileHeader
+ *   ModelLayerEntry × layerCount
+ *   per layer the rows × cols weights and the rows × 1 bias as raw floats, every section starting
+ *   at a multiple of MODEL_ALIGNMENT bytes
+ */
+#define MODEL_MAGIC "MLPM"
+#define MODEL_VERSION 1
+#define MODEL_ALIGNMENT 64
+
+/**
+ * @struct ModelFileHeader
+ * @brief Header at the start of a model file
+ */
+typedef struct ModelFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t layerCount;
+    uint32_t reserved;
+} ModelFileHeader;
+
+/**
+ * @struct ModelLayerEntry
+ * @brief Shape, activation and section offsets of one layer
+ */
+typedef struct ModelLayerEntry
+{
+    int32_t rows;
+    int32_t cols;
+    int32_t activation;
+    int32_t reserved;
+    uint64_t weightsOffset;
+    uint64_t biasOffset;
+} ModelLayerEntry;
+
+/**
+ * A model file mapped into memory. The weights are handed out as Matrix views straight into the
+ * mapping, so loading costs no copy and processes mapping the same file share its pages. The
+ * mapping is private, a write through a view never reaches the file.
+ * The MappedModel has to outlive every view taken from it.
+ */
+class MappedModel
+{
+public:
+    /**
+     * Constructor - maps and validates a model file
+     * @param path path of the model file
+     */
+    explicit MappedModel(const std::string &path);
+
+    /**
+     * destructor, unmaps the file
+     */
+    ~MappedModel();
+
+    MappedModel(const MappedModel &) = delete;
+    MappedModel &operator=(const MappedModel &) = delete;
+
+    /**
+     * getter - returns the amount of layers
+     */
+    int getLayerCount() const;
+
+    /**
+     * Returns a view of the weights of layer i
+     * @param i layer index
+     */
+    Matrix getWeights(int i) const;
+
+    /**
+     * Returns a view of the bias of layer i
+     * @param i layer index
+     */
+    Matrix getBias(int i) const;
+
+    /**
+     * Returns the activation type of layer i
+     * @param i layer index
+     */
+    ActivationType getActivation(int i) const;
+
+    /**
+     * Writes the layers of a network as a model file
+     * @param path path of the model file
+     * @param network the network
+     */
+    static void write(const std::string &path, const MlpNetwork &network);
+
+    /**
+     * Writes the layers of a graph as a model file
+     * @param path path of the model file
+     * @param network the graph
+     */
+    static void write(const std::string &path, const MlpGraph &network);
+
+private:
+    void *_mapping;
+    size_t _length;
+    const ModelLayerEntry *_layers;
+    int _layerCount;
+
+    /**
+     * Returns the entry of layer i, terminates on an invalid index
+     * @param i layer index
+     */
+    const ModelLayerEntry &_layer(int i) const;
+};
+
+#endif //MAPPEDMODEL_H
@@ -1,351 +1,462 @@
-#include "Matrix.h"
-#define MATRIX_DIM_ERROR_MSG "Error: matrix dimensions is not valid."
-#define DIM_ERROR_MSG "Error: invalid dimensions"
-#define READ_FILE_ERROR "Error: there is a problem with the file!"
-#define OUTOFBOUND_ERROR "Error: index out of bound"
-#define EOF_FILE_ERROR "Error: EOF error"
-#define SPACE "  "
-#define ASTERISK "**"
-#define ONE 1
-#define ZERO 0
-#define FLOAT_ZERO 0.0f
-#define FLOAT_ONE 0.1f
-
-/**
- * Constructs Matrix rows × cols, inits all elements to 0
- * @param rows positive number
- * @param cols positive number
- */
-Matrix::Matrix(int rows, int cols)
-{
-    if(rows <= 0 || cols <= 0)
-    {
-        std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    _rowsNum = rows;
-    _colsNum = cols;
-    _matrix = new float[_rowsNum * _colsNum];
-    for (int i = 0; i < _rowsNum*_colsNum; ++i)
-    {
-        _matrix[i] = FLOAT_ZERO;
-    }
-
-}
-
-/**
- * Constructs 1×1 Matrix Inits the single element to 0
- */
-Matrix::Matrix():Matrix(ONE, ONE)
-{
-}
-
-
-/**
- * Constructs matrix from another Matrix m
- * @param m another Matrix
- */
-Matrix::Matrix(const Matrix &m) : _rowsNum(m.getRows()), _colsNum(m.getCols())
-{
-    if( _rowsNum <= ZERO || _colsNum <= ZERO )
-    {
-        std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    _matrix = new float[m.getRows() *  m.getCols()];
-    for(int i = 0; i < m.getRows() * m.getCols(); i++)
-    {
-        (*this)[i] = m[i];
-    }
-}
-
-/**
- * destructor, free the memory of a matrix
- */
-Matrix::~Matrix()
-{
-    delete[] _matrix;
-}
-
-/**
- * getter- returns the amount of rows as int
- */
-int Matrix::getRows() const
-{
-    return _rowsNum;
-}
-
-/**
- * getter -returns the amount of cols as int
- * @return
- */
-int Matrix::getCols() const
-{
-    return _colsNum;
-}
-
-/**
- * Prints matrix elements, no return value.
- */
-void Matrix::plainPrint() const
-{
-    for(int i = 0; i < this->_rowsNum; i++)
-    {
-        for (int j = 0; j < this->_colsNum; j++)
-        {
-            std::cout << (*this)(i, j) << " " ;
-        }
-        std::cout << std::endl;
-    }
-}
-
-/**
- * Transforms a matrix into a column vector.
- * @return
- */
-Matrix& Matrix::vectorize()
-{
-    this->_rowsNum = _rowsNum * _colsNum;
-    this->_colsNum = ONE;
-    return *this;
-}
-
-/**
- * Assignment operator
- * @param rhs
- * @return
- */
-Matrix& Matrix::operator=(const Matrix& rhs)
-{
-    if(this == &rhs)
-    {
-        return  *this;
-    }
-    delete[] _matrix;
-    _rowsNum = rhs.getRows();
-    _colsNum = rhs.getCols();
-    _matrix = new float[_rowsNum * _colsNum];
-    for(int i = 0; i < (_rowsNum * _colsNum) ; i++)
-    {
-        _matrix[i] = rhs[i];
-    }
-    return *this;
-}
-
-/**
- * Matrix multiplication
- * @param rhs matrix
- * @return The result matrix
- */
-Matrix Matrix::operator*(const Matrix &rhs) const
-{
-    if(this->getCols() == rhs.getRows() )
-    {
-        Matrix resultMat =  Matrix(getRows(), rhs.getCols());
-        for(int i = 0; i < getRows(); i++)
-        {
-            for (int j = 0; j < rhs.getCols(); j++)
-            {
-                float sum = ZERO;
-                for (int k = 0; k < _colsNum ; k++)
-                {
-                    sum += _matrix[i * _colsNum + k] * rhs[k * rhs.getCols() + j];
-                }
-                resultMat[i * rhs.getCols() + j] = sum;
-            }
-        }
-        return resultMat;
-    }
-    else
-    {
-        std::cerr << DIM_ERROR_MSG << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-
-/**
- * Scalar multiplication on the right
- * @param c scalar
- * @return The result matrix
- */
-Matrix Matrix::operator*(const float c) const
-{
-    Matrix result = Matrix( getRows(), getCols());
-    for(int i = 0; i < getRows() * getCols() ; i++)
-    {
-        result[i] = _matrix[i] * c;
-    }
-    return result;
-}
-
-/**
- * Scalar multiplication on the left
- * @param c scalar
- * @param rhs matrix
- * @return The result matrix
- */
-Matrix operator*( float c, const Matrix &rhs)
-{
-    Matrix result = Matrix(rhs._rowsNum, rhs._colsNum);
-    for(int i = 0; i < rhs._rowsNum * rhs._colsNum ; i++)
-    {
-            result._matrix[i] = c * rhs._matrix[i] ;
-    }
-    return result;
-}
-
-/**
- * Matrix addition operator
- * @param rhs matrix
- * @return The result matrix
- */
-Matrix Matrix::operator+(const Matrix &rhs) const
-{
-    if(this->getCols() == rhs.getCols() && this->getRows() == rhs.getRows())
-    {
-        Matrix resultMat =  Matrix(getRows(), getCols());
-        for(int i = 0; i < getRows(); i++)
-        {
-            for (int j = 0; j < getCols(); j++)
-            {
-                resultMat[i * getCols() + j] = _matrix[i * getCols() + j] +
-                                                                 (rhs[i * getCols() + j]);
-            }
-        }
-        return resultMat;
-    }
-    else
-    {
-        std::cerr << DIM_ERROR_MSG << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-/**
-* Matrix addition accumulation
-* @param rhs matrix
-* @return The result matrix
-*/
-Matrix& Matrix::operator+=(const Matrix &rhs)
-{
-    *this = *this + rhs;
-    return (*this);
-}
-
-/**
- * Parenthesis indexing
- * @param i int rows index
- * @param j int col index
- * @return the value in this index in the matrix
- */
-float& Matrix::operator()(const int i, const int j)
-{
-    if(i >= _rowsNum || j >= _colsNum || i < 0 || j < 0)
-    {
-        std::cerr << OUTOFBOUND_ERROR << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    return _matrix[(i * getCols() ) + j];
-}
-
-/**
- * Brackets indexing
- * @param i index in matrix
- * @return the value in this index in the matrix
- */
-float& Matrix::operator[](const int i) {
-    if(i >= _rowsNum * _colsNum || i < ZERO )
-    {
-        std::cerr << OUTOFBOUND_ERROR << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    return _matrix[i];
-}
-
-/**
- * Parenthesis indexing for const
- * @param i int rows index
- * @param j int col index
- * @return the value in this index in the matrix
- */
-float Matrix::operator()(const int i, const int j) const
-{
-    if(i >= _rowsNum || j >= _colsNum || i < ZERO || j < ZERO)
-    {
-        std::cerr << OUTOFBOUND_ERROR << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    return _matrix[(i * _colsNum ) + j];
-}
-
-
-/**
- * Brackets indexing  for const
- * @param i index in matrix
- * @return the value in this index in the matrix
- */
-float Matrix::operator[](const int i) const
-{
-    if(i >= _rowsNum * _colsNum || i < ZERO )
-    {
-        std::cerr << OUTOFBOUND_ERROR << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    return _matrix[i];
-}
-
-/**
- * Fills matrix elements has to read input stream fully otherwise, that’s an error
- * @param in Input stream
- * @param m matrix
- * @return Input stream
- */
-std::istream& operator>>(std::istream &input, Matrix &m)
-{
-    for (int i = 0; i < m.getRows() * m.getCols(); i++)
-    {
-        input.read((char*) &(m[i]), sizeof(float));
-        if(!input.good())
-        {
-            std::cerr << READ_FILE_ERROR << std::endl;
-            exit(EXIT_FAILURE);
-        }
-    }
-    if(input.peek() != EOF)
-    {
-        std::cerr << EOF_FILE_ERROR << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    return input;
-}
-
-/**
- * export of matrix, prints the matrix according to the instruction
- * @param out Output stream
- * @param m matrix
- * @return Output stream
- */
-std::ostream &operator<<(std::ostream &output, const Matrix &m)
-{
-    for (int i = ZERO; i < m.getRows(); ++i)
-    {
-        for (int j = 0; j < m.getCols(); ++j)
-        {
-            if(m[i * m.getCols() + j ] <= FLOAT_ONE)
-            {
-                output << SPACE;
-            }
-            else
-            {
-                output << ASTERISK;
-            }
-        }
-        output << std::endl;
-    }
-    return output;
-}
-
-
-
-
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "Gemm.h"
+#include "VectorOps.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#define MATRIX_DIM_ERROR_MSG "Error: matrix dimensions is not valid."
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define OUTOFBOUND_ERROR "Error: index out of bound"
+#define EOF_FILE_ERROR "Error: EOF error"
+#define SPACE "  "
+#define ASTERISK "**"
+#define ONE 1
+#define ZERO 0
+#define FLOAT_ZERO 0.0f
+#define FLOAT_ONE 0.1f
+
+/**
+ * The allocator of new buffers, nullptr stands for defaultMatrixPool()
+ */
+static std::atomic<MatrixAllocator*> currentAllocator(nullptr);
+
+/**
+ * Constructs Matrix rows × cols, inits all elements to 0
+ * @param rows positive number
+ * @param cols positive number
+ */
+Matrix::Matrix(int rows, int cols)
+{
+    if(rows <= 0 || cols <= 0)
+    {
+        std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    _rowsNum = rows;
+    _colsNum = cols;
+    _allocate(_rowsNum * _colsNum);
+    std::fill(_matrix, _matrix + _rowsNum * _colsNum, FLOAT_ZERO);
+
+}
+
+/**
+ * Constructs 1×1 Matrix Inits the single element to 0
+ */
+Matrix::Matrix():Matrix(ONE, ONE)
+{
+}
+
+/**
+ * Constructs a rows × cols view over external row major memory, the view does not own or
+ * free it and the memory has to outlive the view. Copies of a view own their elements.
+ * @param rows positive number
+ * @param cols positive number
+ * @param data pointer to rows × cols floats
+ */
+Matrix::Matrix(int rows, int cols, float *data) : _rowsNum(rows), _colsNum(cols), _matrix(data),
+                                                  _allocator(nullptr)
+{
+    if(rows <= ZERO || cols <= ZERO || data == nullptr)
+    {
+        std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * Constructs matrix from another Matrix m
+ * @param m another Matrix
+ */
+Matrix::Matrix(const Matrix &m) : _rowsNum(m.getRows()), _colsNum(m.getCols())
+{
+    if( _rowsNum <= ZERO || _colsNum <= ZERO )
+    {
+        std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    _allocate(m.getRows() * m.getCols());
+    std::copy(m._matrix, m._matrix + m.getRows() * m.getCols(), _matrix);
+}
+
+/**
+ * Constructs matrix from the elements of a view, whatever its strides. A transposed view
+ * goes through the blocked transpose kernel.
+ * @param v a view
+ */
+Matrix::Matrix(const ConstMatrixView &v) : _rowsNum(v.getRows()), _colsNum(v.getCols())
+{
+    _allocate(_rowsNum * _colsNum);
+    if(v.isRowMajor())
+    {
+        for(int i = 0; i < _rowsNum; i++)
+        {
+            const float *row = &v(i, ZERO);
+            std::copy(row, row + _colsNum, _matrix + i * _colsNum);
+        }
+        return;
+    }
+    ::transpose(v.transposed(), view());
+}
+
+/**
+ * Constructs matrix by taking over the buffer of another Matrix m, m is left empty
+ * @param m another Matrix
+ */
+Matrix::Matrix(Matrix &&m) noexcept : _rowsNum(m._rowsNum), _colsNum(m._colsNum), _matrix(m._matrix),
+                                      _allocator(m._allocator)
+{
+    m._rowsNum = ZERO;
+    m._colsNum = ZERO;
+    m._matrix = nullptr;
+    m._allocator = nullptr;
+}
+
+/**
+ * destructor, free the memory of a matrix
+ */
+Matrix::~Matrix()
+{
+    _release();
+}
+
+/**
+ * getter- returns the amount of rows as int
+ */
+int Matrix::getRows() const
+{
+    return _rowsNum;
+}
+
+/**
+ * getter -returns the amount of cols as int
+ * @return
+ */
+int Matrix::getCols() const
+{
+    return _colsNum;
+}
+
+/**
+ * Prints matrix elements, no return value. The text is formatted into one buffer with the flags,
+ * precision and locale of std::cout, so it reads as printing every element to std::cout would, and
+ * written at once.
+ */
+void Matrix::plainPrint() const
+{
+    std::ostringstream text;
+    text.copyfmt(std::cout);
+    text.tie(nullptr);
+    for(int i = 0; i < this->_rowsNum; i++)
+    {
+        const float *values = row(i);
+        for (int j = 0; j < this->_colsNum; j++)
+        {
+            text << values[j] << " ";
+        }
+        text << '\n';
+    }
+    // a field width applies to the first element only, as it would have on std::cout
+    std::cout.width(ZERO);
+    const std::string printed = text.str();
+    std::cout.write(printed.data(), (std::streamsize) printed.size());
+    std::cout.flush();
+}
+
+/**
+ * Transforms a matrix into a column vector.
+ * @return
+ */
+Matrix& Matrix::vectorize()
+{
+    this->_rowsNum = _rowsNum * _colsNum;
+    this->_colsNum = ONE;
+    return *this;
+}
+
+/**
+ * Returns the transpose as a new matrix, built by the blocked transpose kernel. For a
+ * transpose without a copy take view().transposed().
+ */
+Matrix Matrix::transpose() const
+{
+    return Matrix(view().transposed());
+}
+
+/**
+ * Assignment operator
+ * @param rhs
+ * @return
+ */
+Matrix& Matrix::operator=(const Matrix& rhs)
+{
+    if(this == &rhs)
+    {
+        return  *this;
+    }
+    // a view never writes through to the memory it was built on, it becomes an owning matrix
+    if(isView() || _rowsNum * _colsNum != rhs.getRows() * rhs.getCols())
+    {
+        _release();
+        _allocate(rhs.getRows() * rhs.getCols());
+    }
+    _rowsNum = rhs.getRows();
+    _colsNum = rhs.getCols();
+    std::copy(rhs._matrix, rhs._matrix + _rowsNum * _colsNum, _matrix);
+    return *this;
+}
+
+/**
+ * Move assignment operator, exchanges buffers with rhs
+ * @param rhs
+ * @return
+ */
+Matrix& Matrix::operator=(Matrix &&rhs) noexcept
+{
+    std::swap(_rowsNum, rhs._rowsNum);
+    std::swap(_colsNum, rhs._colsNum);
+    std::swap(_matrix, rhs._matrix);
+    std::swap(_allocator, rhs._allocator);
+    return *this;
+}
+
+/**
+ * Reports operands of mismatching dimensions and terminates
+ */
+void exprDimError()
+{
+    std::cerr << DIM_ERROR_MSG << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Reports an out of bound index into an expression and terminates
+ */
+void exprOutOfBound()
+{
+    std::cerr << OUTOFBOUND_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Matrix multiplication
+ * @param a matrix
+ * @param b matrix
+ */
+ProductExpr::ProductExpr(const Matrix &a, const Matrix &b) : _a(a), _b(b)
+{
+    if(a.getCols() != b.getRows())
+    {
+        exprDimError();
+    }
+}
+
+/**
+ * Writes the product to dst
+ * @param dst getRows() × getCols() floats, must not overlap the operands
+ */
+void ProductExpr::evalInto(float *dst) const
+{
+    gemm(_a.getRows(), _b.getCols(), _a.getCols(), _a.data(), _a.getCols(), _b.data(), _b.getCols(), dst,
+         _b.getCols());
+}
+
+/**
+ * Returns the allocator for the buffer the product is assigned to: the page allocator when it is
+ * split across threads and the default pool is installed, so each thread first touches its own
+ * tiles (a repeated shape reuses the pages of the last one), otherwise the current allocator
+ */
+MatrixAllocator &ProductExpr::resultAllocator() const
+{
+    // a single column product is a GEMV on the calling thread, see gemm
+    MatrixAllocator &current = Matrix::getAllocator();
+    if(&current == &defaultMatrixPool() && getCols() != ONE && gemmRunsParallel(getRows(), getCols(), _a.getCols()))
+    {
+        return pageMatrixAllocator();
+    }
+    return current;
+}
+
+/**
+ * Matrix multiplication straight into the destination
+ * @param e the expression
+ * @param dst destination
+ */
+void evaluate(const ProductExpr &e, float *dst)
+{
+    e.evalInto(dst);
+}
+
+/**
+ * Matrix multiplication and addition, GEMM then a SIMD accumulation
+ * @param e the expression
+ * @param dst destination
+ */
+void evaluate(const SumExpr<ProductExpr, Matrix> &e, float *dst)
+{
+    e.left().evalInto(dst);
+    vecAdd(dst, e.right().data(), dst, e.right().size());
+}
+
+/**
+ * Matrix addition
+ * @param e the expression
+ * @param dst destination
+ */
+void evaluate(const SumExpr<Matrix, Matrix> &e, float *dst)
+{
+    vecAdd(e.left().data(), e.right().data(), dst, e.left().size());
+}
+
+/**
+ * Scalar multiplication
+ * @param e the expression
+ * @param dst destination
+ */
+void evaluate(const ScaleExpr<Matrix> &e, float *dst)
+{
+    vecScale(e.operand().data(), e.scalar(), dst, e.operand().size());
+}
+
+/**
+ * Scalar multiplication and addition, the product is rounded before the addition like the
+ * separate operations would
+ * @param e the expression
+ * @param dst destination
+ */
+void evaluate(const SumExpr<ScaleExpr<Matrix>, Matrix> &e, float *dst)
+{
+    vecScaleAdd(e.left().operand().data(), e.left().scalar(), e.right().data(), dst, e.right().size());
+}
+
+/**
+* Matrix addition accumulation
+* @param rhs matrix
+* @return The result matrix
+*/
+Matrix& Matrix::operator+=(const Matrix &rhs)
+{
+    if(this->getCols() != rhs.getCols() || this->getRows() != rhs.getRows())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    vecAdd(_matrix, rhs._matrix, _matrix, getRows() * getCols());
+    return (*this);
+}
+
+/**
+ * Installs the allocator used for the buffers of matrices created from now on, buffers that
+ * already exist are released to the allocator they came from
+ * @param allocator the allocator, nullptr restores defaultMatrixPool()
+ */
+void Matrix::setAllocator(MatrixAllocator *allocator)
+{
+    currentAllocator.store(allocator);
+}
+
+/**
+ * Returns the allocator used for new buffers
+ */
+MatrixAllocator &Matrix::getAllocator()
+{
+    MatrixAllocator *allocator = currentAllocator.load();
+    return (allocator != nullptr) ? *allocator : defaultMatrixPool();
+}
+
+/**
+ * Points _matrix at a fresh uninitialized buffer of count floats from the current allocator
+ * @param count amount of floats
+ */
+void Matrix::_allocate(int count)
+{
+    _allocate(count, getAllocator());
+}
+
+/**
+ * Points _matrix at a fresh uninitialized buffer of count floats from the given allocator
+ * @param count amount of floats
+ * @param allocator where the buffer comes from and is released to
+ */
+void Matrix::_allocate(int count, MatrixAllocator &allocator)
+{
+    _allocator = &allocator;
+    _matrix = _allocator->allocate((size_t) count);
+}
+
+/**
+ * Returns the buffer to the allocator it came from, views are left alone
+ */
+void Matrix::_release()
+{
+    if(_allocator != nullptr)
+    {
+        _allocator->deallocate(_matrix, (size_t) (_rowsNum * _colsNum));
+    }
+    _allocator = nullptr;
+    _matrix = nullptr;
+}
+
+/**
+ * Reports an out of bound index and terminates
+ */
+void Matrix::_outOfBound()
+{
+    std::cerr << OUTOFBOUND_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Fills matrix elements has to read input stream fully otherwise, that’s an error
+ * @param in Input stream
+ * @param m matrix
+ * @return Input stream
+ */
+std::istream& operator>>(std::istream &input, Matrix &m)
+{
+    input.read((char*) m.data(), (std::streamsize) (m.size() * sizeof(float)));
+    if(!input.good())
+    {
+        std::cerr << READ_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if(input.peek() != EOF)
+    {
+        std::cerr << EOF_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return input;
+}
+
+/**
+ * export of matrix, prints the matrix according to the instruction. The picture is built in one
+ * buffer and written at once.
+ * @param out Output stream
+ * @param m matrix
+ * @return Output stream
+ */
+std::ostream &operator<<(std::ostream &output, const Matrix &m)
+{
+    std::string text;
+    text.reserve((size_t) m.getRows() * (m.getCols() * 2 + 1));
+    for (int i = ZERO; i < m.getRows(); ++i)
+    {
+        const float *values = m.row(i);
+        for (int j = 0; j < m.getCols(); ++j)
+        {
+            text.append((values[j] <= FLOAT_ONE) ? SPACE : ASTERISK);
+        }
+        text.push_back('\n');
+    }
+    output.write(text.data(), (std::streamsize) text.size());
+    output.flush();
+    return output;
+}
+
+
+
+
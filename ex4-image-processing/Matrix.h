@@ -3,7 +3,21 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "MatrixAllocator.h"
 #include <iostream>
+
+/*
+ * Bounds checking of the indexing operators. On by default, compiled away in release builds
+ * (NDEBUG), can be forced either way with -DMATRIX_BOUNDS_CHECK=0/1.
+ */
+#ifndef MATRIX_BOUNDS_CHECK
+#ifdef NDEBUG
+#define MATRIX_BOUNDS_CHECK 0
+#else
+#define MATRIX_BOUNDS_CHECK 1
+#endif
+#endif
+
 /**
  * @struct MatrixDims
  * @brief Matrix dimensions container
@@ -13,10 +27,65 @@ typedef struct MatrixDims
     int rows, cols;
 } MatrixDims;
 
+class Matrix;
+
+/**
+ * Base of every matrix valued expression (see MatrixExpr.h). An expression E provides getRows(),
+ * getCols() and coeff(i), the row major element i of its value. The read only members of Matrix
+ * work on any expression too, they evaluate it as needed; Matrix hides them with its own.
+ */
+template<class E>
+class MatrixExpr
+{
+public:
+    /**
+     * Returns the concrete expression
+     */
+    const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+
+    /**
+     * Element (i, j) of the value
+     * @param i row
+     * @param j column
+     * @return the element
+     */
+    float operator()(int i, int j) const;
+
+    /**
+     * Element i of the value in row major order
+     * @param i index
+     * @return the element
+     */
+    float operator[](int i) const;
+
+    /**
+     * Evaluates the expression and prints it like Matrix::plainPrint
+     */
+    void plainPrint() const;
+
+    /**
+     * Evaluates the expression into a column vector
+     * @return the vector
+     */
+    Matrix vectorize() const;
+};
+
+template<class T>
+class BasicMatrixView;
+
+/**
+ * Writable and read only strided views, see MatrixView.h
+ */
+typedef BasicMatrixView<float> MatrixView;
+typedef BasicMatrixView<const float> ConstMatrixView;
+
 /**
  * A class repersenting a matrix
  */
-class Matrix
+class Matrix : public MatrixExpr<Matrix>
 {
 public:
     /**
@@ -31,12 +100,41 @@ public:
      */
     Matrix();
 
+    /**
+     * Constructs a rows × cols view over external row major memory, the view does not own or
+     * free it and the memory has to outlive the view. Copies of a view own their elements.
+     * @param rows positive number
+     * @param cols positive number
+     * @param data pointer to rows × cols floats
+     */
+    Matrix(int rows, int cols, float *data);
+
     /**
      * Constructs matrix from another Matrix m
      * @param m another Matrix
      */
     Matrix(const Matrix &m);
 
+    /**
+     * Constructs matrix by taking over the buffer of another Matrix m, m is left empty
+     * @param m another Matrix
+     */
+    Matrix(Matrix &&m) noexcept;
+
+    /**
+     * Constructs matrix from the value of an expression, evaluated in a single loop
+     * @param e a matrix expression such as W * x + b or c * (a + b)
+     */
+    template<class E>
+    Matrix(const MatrixExpr<E> &e);
+
+    /**
+     * Constructs matrix from the elements of a view, whatever its strides. A transposed view
+     * goes through the blocked transpose kernel.
+     * @param v a view
+     */
+    explicit Matrix(const ConstMatrixView &v);
+
     /**
      * destructor, free the memory of a matrix
      */
@@ -54,7 +152,8 @@ public:
     int getRows() const;
 
     /**
-     * Prints matrix elements, no return value.
+     * Prints matrix elements, no return value. The text is formatted into one buffer, with the
+     * precision std::cout would use, and written at once.
      */
     void plainPrint() const ;
 
@@ -64,6 +163,12 @@ public:
      */
     Matrix& vectorize();
 
+    /**
+     * Returns the transpose as a new matrix, built by the blocked transpose kernel. For a
+     * transpose without a copy take view().transposed().
+     */
+    Matrix transpose() const;
+
     /**
      * Assignment operator
      * @param rhs
@@ -72,40 +177,40 @@ public:
     Matrix& operator=(const Matrix &rhs);
 
     /**
-     * Matrix multiplication
-     * @param rhs matrix
-     * @return The result matrix
+     * Move assignment operator, exchanges buffers with rhs
+     * @param rhs
+     * @return
      */
-    Matrix operator*(const Matrix &rhs) const ;
+    Matrix& operator=(Matrix &&rhs) noexcept;
 
     /**
-     * Scalar multiplication on the right
-     * @param c scalar
-     * @return The result matrix
+     * Assignment from the value of an expression
+     * @param e a matrix expression
+     * @return
      */
-    Matrix operator*( float c) const ;
+    template<class E>
+    Matrix& operator=(const MatrixExpr<E> &e);
 
     /**
-     * Scalar multiplication on the left
-     * @param c scalar
+     * Matrix addition accumulation
      * @param rhs matrix
      * @return The result matrix
      */
-    friend Matrix operator*( float c, const Matrix &rhs);
+    Matrix& operator+=(const Matrix &rhs);
 
     /**
-     * Matrix addition operator
-     * @param rhs matrix
+     * Accumulation of the value of an expression, in place
+     * @param e a matrix expression
      * @return The result matrix
      */
-    Matrix operator+(const Matrix &rhs) const;
+    template<class E>
+    Matrix& operator+=(const MatrixExpr<E> &e);
 
     /**
-     * Matrix addition accumulation
-     * @param rhs matrix
-     * @return The result matrix
+     * Element i in row major order, the expression interface
+     * @param i index in matrix
      */
-    Matrix& operator+=(const Matrix &rhs);
+    float coeff(int i) const;
 
     /**
      * Parenthesis indexing
@@ -137,6 +242,64 @@ public:
      */
     float operator[]( const int i) const;
 
+    /**
+     * Unchecked access to the row major elements, for hot loops
+     * @return pointer to the first element
+     */
+    float* data();
+
+    /**
+     * Unchecked access to the row major elements for const, for hot loops
+     * @return pointer to the first element
+     */
+    const float* data() const;
+
+    /**
+     * Unchecked access to a single row
+     * @param i row index
+     * @return pointer to the first element of row i
+     */
+    float* row(int i);
+
+    /**
+     * Unchecked access to a single row for const
+     * @param i row index
+     * @return pointer to the first element of row i
+     */
+    const float* row(int i) const;
+
+    /**
+     * Returns a view of the whole matrix, valid while the matrix keeps its buffer
+     */
+    MatrixView view();
+
+    /**
+     * Returns a read only view of the whole matrix, valid while the matrix keeps its buffer
+     */
+    ConstMatrixView view() const;
+
+    /**
+     * getter - returns the amount of elements (rows × cols)
+     */
+    int size() const;
+
+    /**
+     * Returns true if this matrix is a view over external memory
+     */
+    bool isView() const;
+
+    /**
+     * Installs the allocator used for the buffers of matrices created from now on, buffers that
+     * already exist are released to the allocator they came from
+     * @param allocator the allocator, nullptr restores defaultMatrixPool()
+     */
+    static void setAllocator(MatrixAllocator *allocator);
+
+    /**
+     * Returns the allocator used for new buffers
+     */
+    static MatrixAllocator& getAllocator();
+
     /**
      * Fills matrix elements has to read input stream fully otherwise, that’s an error
      * @param in Input stream
@@ -146,7 +309,8 @@ public:
     friend std::istream &operator>>(std::istream &in, Matrix& m);
 
     /**
-     * export of matrix, prints the matrix according to the instruction
+     * export of matrix, prints the matrix according to the instruction. The picture is built in one
+     * buffer and written at once.
      * @param out Output stream
      * @param m matrix
      * @return Output stream
@@ -158,7 +322,118 @@ private:
     int _rowsNum;
     int _colsNum;
     float* _matrix;
+    MatrixAllocator* _allocator;
+
+    /**
+     * Points _matrix at a fresh uninitialized buffer of count floats from the current allocator
+     * @param count amount of floats
+     */
+    void _allocate(int count);
 
+    /**
+     * Points _matrix at a fresh uninitialized buffer of count floats from the given allocator
+     * @param count amount of floats
+     * @param allocator where the buffer comes from and is released to
+     */
+    void _allocate(int count, MatrixAllocator &allocator);
+
+    /**
+     * Returns the buffer to the allocator it came from, views are left alone
+     */
+    void _release();
+
+    /**
+     * Reports an out of bound index and terminates
+     */
+    static void _outOfBound();
 };
 
+/*
+ * The accessors are defined inline so that with MATRIX_BOUNDS_CHECK off they compile down to a plain load.
+ */
+
+inline float& Matrix::operator()(const int i, const int j)
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= _rowsNum || j >= _colsNum || i < 0 || j < 0)
+    {
+        _outOfBound();
+    }
+#endif
+    return _matrix[(i * _colsNum) + j];
+}
+
+inline float Matrix::operator()(const int i, const int j) const
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= _rowsNum || j >= _colsNum || i < 0 || j < 0)
+    {
+        _outOfBound();
+    }
+#endif
+    return _matrix[(i * _colsNum) + j];
+}
+
+inline float& Matrix::operator[](const int i)
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= _rowsNum * _colsNum || i < 0)
+    {
+        _outOfBound();
+    }
+#endif
+    return _matrix[i];
+}
+
+inline float Matrix::operator[](const int i) const
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= _rowsNum * _colsNum || i < 0)
+    {
+        _outOfBound();
+    }
+#endif
+    return _matrix[i];
+}
+
+inline float* Matrix::data()
+{
+    return _matrix;
+}
+
+inline const float* Matrix::data() const
+{
+    return _matrix;
+}
+
+inline float* Matrix::row(int i)
+{
+    return _matrix + i * _colsNum;
+}
+
+inline const float* Matrix::row(int i) const
+{
+    return _matrix + i * _colsNum;
+}
+
+inline int Matrix::size() const
+{
+    return _rowsNum * _colsNum;
+}
+
+inline bool Matrix::isView() const
+{
+    return _allocator == nullptr;
+}
+
+inline float Matrix::coeff(int i) const
+{
+    return _matrix[i];
+}
+
+// the arithmetic operators, they build lazily evaluated expressions
+#include "MatrixExpr.h"
+// strided views, defines view()
+#include "MatrixView.h"
+
 #endif //MATRIX_H
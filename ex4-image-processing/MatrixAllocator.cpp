@@ -0,0 +1,279 @@
+#include "MatrixAllocator.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#define ALLOCATION_ERROR "Error: out of memory"
+#define ZERO 0
+
+/**
+ * Size class of a request, the smallest power of two that holds it
+ * @param bytes requested bytes
+ * @return log2 of the block size
+ */
+static int sizeClass(size_t bytes)
+{
+    int sizeClass = POOL_MIN_CLASS;
+    while (((size_t) 1 << sizeClass) < bytes)
+    {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+/**
+ * Allocates an aligned block from the system, terminates when out of memory
+ * @param bytes block size
+ * @return the block
+ */
+static void *systemAllocate(size_t bytes)
+{
+    void *block = nullptr;
+    if (posix_memalign(&block, MATRIX_ALIGNMENT, bytes) != ZERO)
+    {
+        std::cerr << ALLOCATION_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return block;
+}
+
+PooledAllocator::PooledAllocator() : _stats{ZERO, ZERO, ZERO, ZERO, ZERO}
+{
+}
+
+/**
+ * destructor, returns every cached block to the system
+ */
+PooledAllocator::~PooledAllocator()
+{
+    trim();
+}
+
+/**
+ * Allocates an uninitialized MATRIX_ALIGNMENT aligned buffer
+ * @param count amount of floats, positive
+ * @return the buffer
+ */
+float *PooledAllocator::allocate(size_t count)
+{
+    size_t bytes = count * sizeof(float);
+    int blockClass = sizeClass(bytes);
+    size_t blockBytes = (blockClass <= POOL_MAX_CLASS) ? (size_t) 1 << blockClass : bytes;
+    void *block = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stats.allocationCount++;
+        _stats.bytesInUse += blockBytes;
+        if (_stats.bytesInUse > _stats.highWaterMark)
+        {
+            _stats.highWaterMark = _stats.bytesInUse;
+        }
+        if (blockClass <= POOL_MAX_CLASS && !_freeLists[blockClass].empty())
+        {
+            block = _freeLists[blockClass].back();
+            _freeLists[blockClass].pop_back();
+            _stats.poolHits++;
+            _stats.bytesCached -= blockBytes;
+        }
+    }
+    return (float *) ((block != nullptr) ? block : systemAllocate(blockBytes));
+}
+
+/**
+ * Releases a buffer returned by allocate
+ * @param buffer the buffer
+ * @param count the amount of floats it was allocated with
+ */
+void PooledAllocator::deallocate(float *buffer, size_t count)
+{
+    if (buffer == nullptr)
+    {
+        return;
+    }
+    size_t bytes = count * sizeof(float);
+    int blockClass = sizeClass(bytes);
+    size_t blockBytes = (blockClass <= POOL_MAX_CLASS) ? (size_t) 1 << blockClass : bytes;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stats.bytesInUse -= blockBytes;
+        if (blockClass <= POOL_MAX_CLASS)
+        {
+            _freeLists[blockClass].push_back(buffer);
+            _stats.bytesCached += blockBytes;
+            return;
+        }
+    }
+    free(buffer);
+}
+
+/**
+ * Returns a snapshot of the counters
+ */
+AllocatorStats PooledAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+/**
+ * Restarts allocationCount and poolHits from zero and the high water mark from the bytes in use
+ */
+void PooledAllocator::resetStats()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _stats.allocationCount = ZERO;
+    _stats.poolHits = ZERO;
+    _stats.highWaterMark = _stats.bytesInUse;
+}
+
+/**
+ * Returns every cached block to the system
+ */
+void PooledAllocator::trim()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    for (std::vector<void *> &freeList : _freeLists)
+    {
+        for (void *block : freeList)
+        {
+            free(block);
+        }
+        freeList.clear();
+    }
+    _stats.bytesCached = ZERO;
+}
+
+/**
+ * Returns the process wide pool used by Matrix unless another allocator was installed
+ */
+PooledAllocator &defaultMatrixPool()
+{
+    // never destroyed, matrices with static storage may still release buffers during exit
+    static PooledAllocator *pool = new PooledAllocator();
+    return *pool;
+}
+
+PageAllocator::PageAllocator() : _stats{ZERO, ZERO, ZERO, ZERO, ZERO}
+{
+}
+
+/**
+ * destructor, unmaps every cached block
+ */
+PageAllocator::~PageAllocator()
+{
+    trim();
+}
+
+/**
+ * Allocates an uninitialized (when fresh, zeroed and not yet faulted in) page aligned buffer
+ * @param count amount of floats, positive
+ * @return the buffer
+ */
+float *PageAllocator::allocate(size_t count)
+{
+    const size_t bytes = count * sizeof(float);
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stats.allocationCount++;
+        _stats.bytesInUse += bytes;
+        if (_stats.bytesInUse > _stats.highWaterMark)
+        {
+            _stats.highWaterMark = _stats.bytesInUse;
+        }
+        // the most recently released block of the size first, its pages are the likeliest to be resident
+        for (size_t i = _cached.size(); i > ZERO; i--)
+        {
+            if (_cached[i - 1].first == bytes)
+            {
+                void *block = _cached[i - 1].second;
+                _cached.erase(_cached.begin() + (std::ptrdiff_t) (i - 1));
+                _stats.poolHits++;
+                _stats.bytesCached -= bytes;
+                return (float *) block;
+            }
+        }
+    }
+    void *block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, ZERO);
+    if (block == MAP_FAILED)
+    {
+        std::cerr << ALLOCATION_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return (float *) block;
+}
+
+/**
+ * Releases a buffer returned by allocate, it is cached for the next buffer of its size
+ * @param buffer the buffer
+ * @param count the amount of floats it was allocated with
+ */
+void PageAllocator::deallocate(float *buffer, size_t count)
+{
+    if (buffer == nullptr)
+    {
+        return;
+    }
+    const size_t bytes = count * sizeof(float);
+    std::pair<size_t, void *> evicted(ZERO, nullptr);
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stats.bytesInUse -= bytes;
+        if (_cached.size() >= PAGE_CACHE_BLOCKS)
+        {
+            evicted = _cached.front();
+            _cached.erase(_cached.begin());
+            _stats.bytesCached -= evicted.first;
+        }
+        _cached.emplace_back(bytes, buffer);
+        _stats.bytesCached += bytes;
+    }
+    if (evicted.second != nullptr)
+    {
+        munmap(evicted.second, evicted.first);
+    }
+}
+
+/**
+ * Returns a snapshot of the counters, poolHits counts the buffers served from the cache
+ */
+AllocatorStats PageAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+/**
+ * Restarts allocationCount and poolHits from zero and the high water mark from the bytes in use
+ */
+void PageAllocator::resetStats()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _stats.allocationCount = ZERO;
+    _stats.poolHits = ZERO;
+    _stats.highWaterMark = _stats.bytesInUse;
+}
+
+/**
+ * Unmaps every cached block
+ */
+void PageAllocator::trim()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    for (const std::pair<size_t, void *> &block : _cached)
+    {
+        munmap(block.second, block.first);
+    }
+    _cached.clear();
+    _stats.bytesCached = ZERO;
+}
+
+/**
+ * Returns the process wide page allocator
+ */
+PageAllocator &pageMatrixAllocator()
+{
+    // never destroyed, for the same reason as the pool
+    static PageAllocator *allocator = new PageAllocator();
+    return *allocator;
+}
@@ -0,0 +1,185 @@
+// MatrixAllocator.h
+
+#ifndef MATRIXALLOCATOR_H
+#define MATRIXALLOCATOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+ * Every Matrix buffer starts on a MATRIX_ALIGNMENT boundary, enough for aligned loads of the
+ * widest vectors.
+ */
+#define MATRIX_ALIGNMENT 64
+
+/*
+ * Blocks up to 2^POOL_MAX_CLASS bytes are recycled, larger ones go straight to the system.
+ */
+#define POOL_MIN_CLASS 6
+#define POOL_MAX_CLASS 24
+
+/*
+ * Released mappings the page allocator keeps for buffers of the same size, the oldest is unmapped
+ * when one more comes back.
+ */
+#define PAGE_CACHE_BLOCKS 8
+
+/**
+ * @struct AllocatorStats
+ * @brief Counters of a matrix allocator
+ */
+typedef struct AllocatorStats
+{
+    size_t bytesInUse;
+    size_t highWaterMark;
+    size_t allocationCount;
+    size_t poolHits;
+    size_t bytesCached;
+} AllocatorStats;
+
+/**
+ * Interface of the allocators backing Matrix buffers
+ */
+class MatrixAllocator
+{
+public:
+    virtual ~MatrixAllocator() = default;
+
+    /**
+     * Allocates an uninitialized MATRIX_ALIGNMENT aligned buffer
+     * @param count amount of floats, positive
+     * @return the buffer
+     */
+    virtual float *allocate(size_t count) = 0;
+
+    /**
+     * Releases a buffer returned by allocate
+     * @param buffer the buffer
+     * @param count the amount of floats it was allocated with
+     */
+    virtual void deallocate(float *buffer, size_t count) = 0;
+};
+
+/**
+ * A thread safe allocator with power of two size classes. Released blocks are kept on a free list
+ * of their class and handed out again, so the intermediates of consecutive forward passes reuse
+ * the same memory instead of going to the global heap.
+ */
+class PooledAllocator : public MatrixAllocator
+{
+public:
+    PooledAllocator();
+
+    /**
+     * destructor, returns every cached block to the system
+     */
+    ~PooledAllocator() override;
+
+    PooledAllocator(const PooledAllocator &) = delete;
+    PooledAllocator &operator=(const PooledAllocator &) = delete;
+
+    /**
+     * Allocates an uninitialized MATRIX_ALIGNMENT aligned buffer
+     * @param count amount of floats, positive
+     * @return the buffer
+     */
+    float *allocate(size_t count) override;
+
+    /**
+     * Releases a buffer returned by allocate
+     * @param buffer the buffer
+     * @param count the amount of floats it was allocated with
+     */
+    void deallocate(float *buffer, size_t count) override;
+
+    /**
+     * Returns a snapshot of the counters
+     */
+    AllocatorStats getStats() const;
+
+    /**
+     * Restarts allocationCount and poolHits from zero and the high water mark from the bytes in use
+     */
+    void resetStats();
+
+    /**
+     * Returns every cached block to the system
+     */
+    void trim();
+
+private:
+    mutable std::mutex _lock;
+    std::vector<void *> _freeLists[POOL_MAX_CLASS + 1];
+    AllocatorStats _stats;
+};
+
+/**
+ * Hands out pages straight from the system (mmap). Nothing touches a fresh page before the caller
+ * does, so on NUMA machines every page lands on the node of the thread that writes it first. Used
+ * for the results of products split across the gemm threads.
+ * The last PAGE_CACHE_BLOCKS released mappings are kept and handed out again for a buffer of the
+ * same size, so a product that repeats skips mmap, munmap and the page faults. Its pages stay where
+ * the first product put them, and the same shape splits into the same tiles for the same threads.
+ */
+class PageAllocator : public MatrixAllocator
+{
+public:
+    PageAllocator();
+
+    /**
+     * destructor, unmaps every cached block
+     */
+    ~PageAllocator() override;
+
+    PageAllocator(const PageAllocator &) = delete;
+    PageAllocator &operator=(const PageAllocator &) = delete;
+
+    /**
+     * Allocates an uninitialized (when fresh, zeroed and not yet faulted in) page aligned buffer
+     * @param count amount of floats, positive
+     * @return the buffer
+     */
+    float *allocate(size_t count) override;
+
+    /**
+     * Releases a buffer returned by allocate, it is cached for the next buffer of its size
+     * @param buffer the buffer
+     * @param count the amount of floats it was allocated with
+     */
+    void deallocate(float *buffer, size_t count) override;
+
+    /**
+     * Returns a snapshot of the counters, poolHits counts the buffers served from the cache
+     */
+    AllocatorStats getStats() const;
+
+    /**
+     * Restarts allocationCount and poolHits from zero and the high water mark from the bytes in use
+     */
+    void resetStats();
+
+    /**
+     * Unmaps every cached block
+     */
+    void trim();
+
+private:
+    mutable std::mutex _lock;
+    // bytes and address of the cached mappings, oldest first
+    std::vector<std::pair<size_t, void *>> _cached;
+    AllocatorStats _stats;
+};
+
+/**
+ * Returns the process wide pool used by Matrix unless another allocator was installed
+ */
+PooledAllocator &defaultMatrixPool();
+
+/**
+ * Returns the process wide page allocator
+ */
+PageAllocator &pageMatrixAllocator();
+
+#endif //MATRIXALLOCATOR_H
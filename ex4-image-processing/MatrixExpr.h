@@ -0,0 +1,512 @@
+// MatrixExpr.h
+
+#ifndef MATRIXEXPR_H
+#define MATRIXEXPR_H
+
+#include "Matrix.h"
+#include <utility>
+#include <vector>
+
+/*
+ * Lazy Matrix arithmetic. a + b, c * a, a * c and a * b build small expression objects instead of
+ * matrices, the value is computed once, in a single loop and without temporaries, when the
+ * expression is assigned to a Matrix. Some shapes map onto dedicated kernels:
+ *   a + b, c * a, c * a + b     SIMD element-wise kernels
+ *   a * b                       blocked GEMM straight into the destination
+ *   a * b + e                   GEMM into the destination, then one accumulation sweep of e
+ * An expression can also be read directly: printed, indexed, plainPrint() and vectorize() evaluate
+ * it on the way. It refers to its Matrix operands, so it stays valid as long as they do. A Matrix
+ * operand that is a temporary (e.g. f() * a) would not outlive an expression kept with auto, so an
+ * rvalue Matrix operand makes the operator evaluate at once and return a Matrix instead: sums and
+ * scalings reuse the buffer of the temporary, products write a new one.
+ * An expression is read by one thread at a time: a product nested in an element-wise expression
+ * computes its value into a cache of its own on the first read.
+ */
+
+/**
+ * Reports operands of mismatching dimensions and terminates
+ */
+void exprDimError();
+
+/**
+ * Reports an out of bound index into an expression and terminates
+ */
+void exprOutOfBound();
+
+/**
+ * How an expression stores an operand, matrices by reference, expression nodes by value
+ */
+template<class E>
+struct ExprOperand
+{
+    typedef const E type;
+};
+
+template<>
+struct ExprOperand<Matrix>
+{
+    typedef const Matrix &type;
+};
+
+/**
+ * Element-wise sum of two expressions
+ */
+template<class L, class R>
+class SumExpr : public MatrixExpr<SumExpr<L, R>>
+{
+public:
+    SumExpr(const L &l, const R &r) : _l(l), _r(r)
+    {
+        if (l.getRows() != r.getRows() || l.getCols() != r.getCols())
+        {
+            exprDimError();
+        }
+    }
+
+    int getRows() const
+    {
+        return _l.getRows();
+    }
+
+    int getCols() const
+    {
+        return _l.getCols();
+    }
+
+    float coeff(int i) const
+    {
+        return _l.coeff(i) + _r.coeff(i);
+    }
+
+    const L &left() const
+    {
+        return _l;
+    }
+
+    const R &right() const
+    {
+        return _r;
+    }
+
+private:
+    typename ExprOperand<L>::type _l;
+    typename ExprOperand<R>::type _r;
+};
+
+/**
+ * An expression multiplied by a scalar
+ */
+template<class E>
+class ScaleExpr : public MatrixExpr<ScaleExpr<E>>
+{
+public:
+    ScaleExpr(const E &e, float c) : _e(e), _c(c)
+    {
+    }
+
+    int getRows() const
+    {
+        return _e.getRows();
+    }
+
+    int getCols() const
+    {
+        return _e.getCols();
+    }
+
+    float coeff(int i) const
+    {
+        return _e.coeff(i) * _c;
+    }
+
+    const E &operand() const
+    {
+        return _e;
+    }
+
+    float scalar() const
+    {
+        return _c;
+    }
+
+private:
+    typename ExprOperand<E>::type _e;
+    float _c;
+};
+
+/**
+ * Matrix product of two matrices. Assigned directly it runs the blocked GEMM into the destination,
+ * nested inside an element-wise expression or read element by element it computes the product once,
+ * on first access, into a cache that is not synchronized: the expression must not be read from two
+ * threads at once.
+ */
+class ProductExpr : public MatrixExpr<ProductExpr>
+{
+public:
+    ProductExpr(const Matrix &a, const Matrix &b);
+
+    int getRows() const
+    {
+        return _a.getRows();
+    }
+
+    int getCols() const
+    {
+        return _b.getCols();
+    }
+
+    float coeff(int i) const
+    {
+        if (_product.empty())
+        {
+            _product.resize((size_t) getRows() * getCols());
+            evalInto(_product.data());
+        }
+        return _product[i];
+    }
+
+    /**
+     * Writes the product to dst
+     * @param dst getRows() × getCols() floats, must not overlap the operands
+     */
+    void evalInto(float *dst) const;
+
+    /**
+     * Returns the allocator for the buffer the product is assigned to: the page allocator when it is
+     * split across threads and the default pool is installed, so each thread first touches its own
+     * tiles (a repeated shape reuses the pages of the last one), otherwise the current allocator
+     */
+    MatrixAllocator &resultAllocator() const;
+
+private:
+    const Matrix &_a;
+    const Matrix &_b;
+    mutable std::vector<float> _product;
+};
+
+/**
+ * Returns the allocator for the buffer an expression is assigned to, the current one
+ * @param e the expression
+ */
+template<class E>
+MatrixAllocator &resultAllocator(const MatrixExpr<E> &)
+{
+    return Matrix::getAllocator();
+}
+
+/**
+ * Returns the allocator for the buffer a product is assigned to
+ * @param e the expression
+ */
+inline MatrixAllocator &resultAllocator(const ProductExpr &e)
+{
+    return e.resultAllocator();
+}
+
+/**
+ * Returns the allocator for the buffer a product plus an expression is assigned to, the GEMM writes
+ * it first
+ * @param e the expression
+ */
+template<class R>
+MatrixAllocator &resultAllocator(const SumExpr<ProductExpr, R> &e)
+{
+    return e.left().resultAllocator();
+}
+
+/**
+ * Writes the value of an expression to dst, the generic single loop
+ * @param e the expression
+ * @param dst getRows() × getCols() floats
+ */
+template<class E>
+void evaluate(const MatrixExpr<E> &e, float *dst)
+{
+    const E &expr = e.self();
+    const int size = expr.getRows() * expr.getCols();
+    for (int i = 0; i < size; i++)
+    {
+        dst[i] = expr.coeff(i);
+    }
+}
+
+/**
+ * Writes a matrix product plus an expression to dst, GEMM followed by one accumulation sweep
+ * @param e the expression
+ * @param dst getRows() × getCols() floats
+ */
+template<class R>
+void evaluate(const SumExpr<ProductExpr, R> &e, float *dst)
+{
+    e.left().evalInto(dst);
+    const int size = e.getRows() * e.getCols();
+    for (int i = 0; i < size; i++)
+    {
+        dst[i] += e.right().coeff(i);
+    }
+}
+
+void evaluate(const ProductExpr &e, float *dst);
+
+void evaluate(const SumExpr<ProductExpr, Matrix> &e, float *dst);
+
+void evaluate(const SumExpr<Matrix, Matrix> &e, float *dst);
+
+void evaluate(const ScaleExpr<Matrix> &e, float *dst);
+
+void evaluate(const SumExpr<ScaleExpr<Matrix>, Matrix> &e, float *dst);
+
+/**
+ * Matrix addition operator
+ * @param l matrix expression
+ * @param r matrix expression
+ * @return The sum expression
+ */
+template<class L, class R>
+SumExpr<L, R> operator+(const MatrixExpr<L> &l, const MatrixExpr<R> &r)
+{
+    return SumExpr<L, R>(l.self(), r.self());
+}
+
+/**
+ * Scalar multiplication on the right
+ * @param e matrix expression
+ * @param c scalar
+ * @return The scaled expression
+ */
+template<class E>
+ScaleExpr<E> operator*(const MatrixExpr<E> &e, float c)
+{
+    return ScaleExpr<E>(e.self(), c);
+}
+
+/**
+ * Scalar multiplication on the left
+ * @param c scalar
+ * @param e matrix expression
+ * @return The scaled expression
+ */
+template<class E>
+ScaleExpr<E> operator*(float c, const MatrixExpr<E> &e)
+{
+    return ScaleExpr<E>(e.self(), c);
+}
+
+/**
+ * Matrix multiplication
+ * @param a matrix
+ * @param b matrix
+ * @return The product expression
+ */
+inline ProductExpr operator*(const Matrix &a, const Matrix &b)
+{
+    return ProductExpr(a, b);
+}
+
+/**
+ * Matrix addition with a temporary, accumulated into it at once
+ * @param l temporary matrix
+ * @param r matrix expression
+ * @return The result matrix
+ */
+template<class R>
+Matrix operator+(Matrix &&l, const MatrixExpr<R> &r)
+{
+    l += r;
+    return std::move(l);
+}
+
+/**
+ * Matrix addition with a temporary, accumulated into it at once
+ * @param l matrix expression
+ * @param r temporary matrix
+ * @return The result matrix
+ */
+template<class L>
+Matrix operator+(const MatrixExpr<L> &l, Matrix &&r)
+{
+    r += l;
+    return std::move(r);
+}
+
+/**
+ * Matrix addition of two temporaries, accumulated into the left one at once
+ * @param l temporary matrix
+ * @param r temporary matrix
+ * @return The result matrix
+ */
+inline Matrix operator+(Matrix &&l, Matrix &&r)
+{
+    l += r;
+    return std::move(l);
+}
+
+/**
+ * Scales a temporary in place
+ * @param m temporary matrix
+ * @param c scalar
+ * @return The result matrix
+ */
+inline Matrix scaledTemporary(Matrix &&m, float c)
+{
+    float *values = m.data();
+    for (int i = 0; i < m.size(); i++)
+    {
+        values[i] *= c;
+    }
+    return std::move(m);
+}
+
+/**
+ * Scalar multiplication of a temporary on the right, evaluated at once
+ * @param m temporary matrix
+ * @param c scalar
+ * @return The result matrix
+ */
+inline Matrix operator*(Matrix &&m, float c)
+{
+    return scaledTemporary(std::move(m), c);
+}
+
+/**
+ * Scalar multiplication of a temporary on the left, evaluated at once
+ * @param c scalar
+ * @param m temporary matrix
+ * @return The result matrix
+ */
+inline Matrix operator*(float c, Matrix &&m)
+{
+    return scaledTemporary(std::move(m), c);
+}
+
+/**
+ * Matrix multiplication with a temporary, evaluated at once
+ * @param a temporary matrix
+ * @param b matrix
+ * @return The result matrix
+ */
+inline Matrix operator*(Matrix &&a, const Matrix &b)
+{
+    return Matrix(ProductExpr(a, b));
+}
+
+/**
+ * Matrix multiplication with a temporary, evaluated at once
+ * @param a matrix
+ * @param b temporary matrix
+ * @return The result matrix
+ */
+inline Matrix operator*(const Matrix &a, Matrix &&b)
+{
+    return Matrix(ProductExpr(a, b));
+}
+
+/**
+ * Matrix multiplication of two temporaries, evaluated at once
+ * @param a temporary matrix
+ * @param b temporary matrix
+ * @return The result matrix
+ */
+inline Matrix operator*(Matrix &&a, Matrix &&b)
+{
+    return Matrix(ProductExpr(a, b));
+}
+
+/**
+ * Matrix multiplication of expressions, both operands are materialized first
+ * @param l matrix expression
+ * @param r matrix expression
+ * @return The result matrix
+ */
+template<class L, class R>
+Matrix operator*(const MatrixExpr<L> &l, const MatrixExpr<R> &r)
+{
+    Matrix a = l;
+    Matrix b = r;
+    return Matrix(ProductExpr(a, b));
+}
+
+/**
+ * Matrix export of an expression, prints its value as operator<< prints a Matrix
+ * @param out Output stream
+ * @param e matrix expression
+ * @return Output stream
+ */
+template<class E>
+std::ostream &operator<<(std::ostream &out, const MatrixExpr<E> &e)
+{
+    return out << Matrix(e);
+}
+
+template<class E>
+float MatrixExpr<E>::operator()(int i, int j) const
+{
+    const E &expr = self();
+#if MATRIX_BOUNDS_CHECK
+    if (i >= expr.getRows() || j >= expr.getCols() || i < 0 || j < 0)
+    {
+        exprOutOfBound();
+    }
+#endif
+    return expr.coeff(i * expr.getCols() + j);
+}
+
+template<class E>
+float MatrixExpr<E>::operator[](int i) const
+{
+    const E &expr = self();
+#if MATRIX_BOUNDS_CHECK
+    if (i >= expr.getRows() * expr.getCols() || i < 0)
+    {
+        exprOutOfBound();
+    }
+#endif
+    return expr.coeff(i);
+}
+
+template<class E>
+void MatrixExpr<E>::plainPrint() const
+{
+    Matrix(*this).plainPrint();
+}
+
+template<class E>
+Matrix MatrixExpr<E>::vectorize() const
+{
+    Matrix value = *this;
+    value.vectorize();
+    return value;
+}
+
+template<class E>
+Matrix::Matrix(const MatrixExpr<E> &e) : _rowsNum(e.self().getRows()), _colsNum(e.self().getCols())
+{
+    _allocate(_rowsNum * _colsNum, resultAllocator(e.self()));
+    evaluate(e.self(), _matrix);
+}
+
+template<class E>
+Matrix &Matrix::operator=(const MatrixExpr<E> &e)
+{
+    // evaluated aside, the expression may read this matrix
+    Matrix value = e;
+    return *this = std::move(value);
+}
+
+template<class E>
+Matrix &Matrix::operator+=(const MatrixExpr<E> &e)
+{
+    const E &expr = e.self();
+    if (expr.getRows() != _rowsNum || expr.getCols() != _colsNum)
+    {
+        exprDimError();
+    }
+    // every product inside the expression is computed on the first coeff, before any write
+    for (int i = 0; i < _rowsNum * _colsNum; i++)
+    {
+        _matrix[i] += expr.coeff(i);
+    }
+    return *this;
+}
+
+#endif //MATRIXEXPR_H
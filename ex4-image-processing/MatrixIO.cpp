@@ -0,0 +1,489 @@
+#include "MatrixIO.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define MATRIX_FORMAT_ERROR "Error: invalid matrix file"
+#define MAGIC_LENGTH 4
+#define FLOAT_BYTES 4
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT 12
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+#define LZ_HASH_MULTIPLIER 2654435761u
+#define LZ_SKIP_SHIFT 6
+#define LZ_NIBBLE 15
+#define LZ_EXTEND 255
+#define LZ_NIBBLE_SHIFT 4
+#define BYTE_SHIFT 8
+#define ZERO 0
+#define ONE 1
+
+/**
+ * Rounds an offset up to the next section boundary
+ * @param offset byte offset
+ * @return aligned offset
+ */
+static uint64_t alignSection(uint64_t offset)
+{
+    return (offset + MATRIX_FILE_ALIGNMENT - 1) / MATRIX_FILE_ALIGNMENT * MATRIX_FILE_ALIGNMENT;
+}
+
+/**
+ * Terminates with the invalid matrix file message
+ */
+static void formatError()
+{
+    std::cerr << MATRIX_FORMAT_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Terminates with the file error message
+ */
+static void fileError()
+{
+    std::cerr << READ_FILE_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Writes zero bytes until offset reaches the next section boundary
+ * @param output output stream
+ * @param offset bytes written so far, advanced
+ */
+static void writePadding(std::ostream &output, uint64_t &offset)
+{
+    static const char zeros[MATRIX_FILE_ALIGNMENT] = {};
+    const uint64_t aligned = alignSection(offset);
+    output.write(zeros, (std::streamsize) (aligned - offset));
+    offset = aligned;
+}
+
+/**
+ * Skips bytes until offset reaches the next section boundary
+ * @param input input stream
+ * @param offset bytes read so far, advanced
+ */
+static void skipPadding(std::istream &input, uint64_t &offset)
+{
+    const uint64_t aligned = alignSection(offset);
+    input.ignore((std::streamsize) (aligned - offset));
+    offset = aligned;
+}
+
+/**
+ * Reads exactly size bytes, terminates when the stream ends first
+ * @param input input stream
+ * @param dst output
+ * @param size amount of bytes
+ * @param offset bytes read so far, advanced
+ */
+static void readBytes(std::istream &input, void *dst, size_t size, uint64_t &offset)
+{
+    input.read((char *) dst, (std::streamsize) size);
+    if (!input.good())
+    {
+        fileError();
+    }
+    offset += size;
+}
+
+/**
+ * Returns the amount of bytes left in the stream, UINT64_MAX when it cannot seek
+ * @param input input stream
+ */
+static uint64_t remainingBytes(std::istream &input)
+{
+    const std::istream::pos_type position = input.tellg();
+    if (position == std::istream::pos_type(-1))
+    {
+        return UINT64_MAX;
+    }
+    input.seekg(ZERO, std::ios::end);
+    const std::istream::pos_type end = input.tellg();
+    input.seekg(position);
+    return (end < position) ? ZERO : (uint64_t) (end - position);
+}
+
+/**
+ * Splits count floats into their byte planes, byte b of float i goes to dst[b * count + i]
+ * @param src the floats
+ * @param count amount of floats
+ * @param dst count × 4 bytes
+ */
+static void shuffleBytes(const float *src, size_t count, uint8_t *dst)
+{
+    const uint8_t *bytes = (const uint8_t *) src;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t b = 0; b < FLOAT_BYTES; b++)
+        {
+            dst[b * count + i] = bytes[i * FLOAT_BYTES + b];
+        }
+    }
+}
+
+/**
+ * Joins the byte planes written by shuffleBytes back into floats
+ * @param src count × 4 bytes
+ * @param count amount of floats
+ * @param dst the floats
+ */
+static void unshuffleBytes(const uint8_t *src, size_t count, float *dst)
+{
+    uint8_t *bytes = (uint8_t *) dst;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t b = 0; b < FLOAT_BYTES; b++)
+        {
+            bytes[i * FLOAT_BYTES + b] = src[b * count + i];
+        }
+    }
+}
+
+/**
+ * Writes matrices as one matrix file, every payload in a single write
+ * @param output binary output stream
+ * @param matrices the matrices
+ * @param compression NoCompression, or LzCompression to compress every matrix it makes smaller
+ */
+void writeMatrices(std::ostream &output, const std::vector<Matrix> &matrices, MatrixCompression compression)
+{
+    MatrixFileHeader header{};
+    std::memcpy(header.magic, MATRIX_MAGIC, MAGIC_LENGTH);
+    header.version = MATRIX_VERSION;
+    header.count = (uint32_t) matrices.size();
+    output.write((const char *) &header, sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    std::vector<uint8_t> shuffled;
+    std::vector<uint8_t> packed;
+    for (const Matrix &m : matrices)
+    {
+        const size_t rawBytes = (size_t) m.size() * sizeof(float);
+        MatrixEntry entry{};
+        entry.rows = m.getRows();
+        entry.cols = m.getCols();
+        entry.compression = NoCompression;
+        entry.payloadBytes = rawBytes;
+        const char *payload = (const char *) m.data();
+        if (compression == LzCompression)
+        {
+            shuffled.resize(rawBytes);
+            packed.resize(lzCompressBound(rawBytes));
+            shuffleBytes(m.data(), (size_t) m.size(), shuffled.data());
+            const size_t packedBytes = lzCompress(shuffled.data(), rawBytes, packed.data());
+            if (packedBytes < rawBytes)
+            {
+                entry.compression = LzCompression;
+                entry.payloadBytes = packedBytes;
+                payload = (const char *) packed.data();
+            }
+        }
+        writePadding(output, offset);
+        output.write((const char *) &entry, sizeof(entry));
+        offset += sizeof(entry);
+        writePadding(output, offset);
+        output.write(payload, (std::streamsize) entry.payloadBytes);
+        offset += entry.payloadBytes;
+    }
+    if (!output.good())
+    {
+        fileError();
+    }
+}
+
+/**
+ * Writes a single matrix as a matrix file
+ * @param output binary output stream
+ * @param m the matrix
+ * @param compression NoCompression or LzCompression
+ */
+void writeMatrix(std::ostream &output, const Matrix &m, MatrixCompression compression)
+{
+    // a view of the elements, the list holds no copy of them
+    std::vector<Matrix> matrices;
+    matrices.emplace_back(m.getRows(), m.getCols(), const_cast<float *>(m.data()));
+    writeMatrices(output, matrices, compression);
+}
+
+/**
+ * Reads every matrix of a matrix file, terminates when the file is invalid. Every header is checked
+ * against the bytes left in a seekable stream before its matrix is allocated, so a damaged file fails
+ * with the format error instead of allocating what its header claims.
+ * @param input binary input stream, positioned at the start of the file
+ * @return the matrices, in order
+ */
+std::vector<Matrix> readMatrices(std::istream &input)
+{
+    MatrixFileHeader header{};
+    uint64_t offset = ZERO;
+    readBytes(input, &header, sizeof(header), offset);
+    if (std::memcmp(header.magic, MATRIX_MAGIC, MAGIC_LENGTH) != ZERO || header.version != MATRIX_VERSION)
+    {
+        formatError();
+    }
+
+    std::vector<Matrix> matrices;
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> shuffled;
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        MatrixEntry entry{};
+        skipPadding(input, offset);
+        readBytes(input, &entry, sizeof(entry), offset);
+        if (entry.rows <= ZERO || entry.cols <= ZERO || (int64_t) entry.rows * entry.cols > INT_MAX)
+        {
+            formatError();
+        }
+        const uint64_t rawBytes = (uint64_t) entry.rows * entry.cols * sizeof(float);
+        // a raw payload is exactly the floats, a compressed one smaller but at most LZ_EXTEND times so
+        const bool raw = entry.compression == NoCompression && entry.payloadBytes == rawBytes;
+        const bool compressed = entry.compression == LzCompression && entry.payloadBytes < rawBytes &&
+                                entry.payloadBytes >= rawBytes / LZ_EXTEND;
+        if (!raw && !compressed)
+        {
+            formatError();
+        }
+        skipPadding(input, offset);
+        if (entry.payloadBytes > remainingBytes(input))
+        {
+            fileError();
+        }
+        Matrix m(entry.rows, entry.cols);
+        if (raw)
+        {
+            readBytes(input, m.data(), rawBytes, offset);
+        }
+        else
+        {
+            packed.resize(entry.payloadBytes);
+            shuffled.resize(rawBytes);
+            readBytes(input, packed.data(), packed.size(), offset);
+            if (!lzDecompress(packed.data(), packed.size(), shuffled.data(), rawBytes))
+            {
+                formatError();
+            }
+            unshuffleBytes(shuffled.data(), (size_t) m.size(), m.data());
+        }
+        matrices.push_back(std::move(m));
+    }
+    return matrices;
+}
+
+/**
+ * Reads a matrix file holding a single matrix, terminates when the file is invalid
+ * @param input binary input stream, positioned at the start of the file
+ * @return the matrix
+ */
+Matrix readMatrix(std::istream &input)
+{
+    std::vector<Matrix> matrices = readMatrices(input);
+    if (matrices.size() != ONE)
+    {
+        formatError();
+    }
+    return std::move(matrices.front());
+}
+
+/**
+ * Returns the largest size lzCompress can produce from size bytes
+ * @param size amount of input bytes
+ */
+size_t lzCompressBound(size_t size)
+{
+    return size + size / LZ_EXTEND + LZ_MATCH_LIMIT + ONE;
+}
+
+/**
+ * Loads 4 bytes, the unit matches are found by
+ * @param p first byte
+ */
+static uint32_t load32(const uint8_t *p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * Writes the extension bytes of a length that did not fit its 4 bit token field
+ * @param dst output, advanced
+ * @param length the length minus 15
+ */
+static void writeLength(uint8_t *&dst, size_t length)
+{
+    while (length >= LZ_EXTEND)
+    {
+        *dst++ = LZ_EXTEND;
+        length -= LZ_EXTEND;
+    }
+    *dst++ = (uint8_t) length;
+}
+
+/**
+ * Writes one sequence: token, literals and, unless matchLength is 0, the match
+ * @param dst output, advanced
+ * @param literals first literal byte
+ * @param literalLength amount of literals
+ * @param offset distance back to the match
+ * @param matchLength match length, at least 4, or 0 for the final literals
+ */
+static void writeSequence(uint8_t *&dst, const uint8_t *literals, size_t literalLength, size_t offset,
+                          size_t matchLength)
+{
+    uint8_t *token = dst++;
+    *token = (uint8_t) (std::min(literalLength, (size_t) LZ_NIBBLE) << LZ_NIBBLE_SHIFT);
+    if (literalLength >= LZ_NIBBLE)
+    {
+        writeLength(dst, literalLength - LZ_NIBBLE);
+    }
+    std::memcpy(dst, literals, literalLength);
+    dst += literalLength;
+    if (matchLength == ZERO)
+    {
+        return;
+    }
+    *dst++ = (uint8_t) offset;
+    *dst++ = (uint8_t) (offset >> BYTE_SHIFT);
+    const size_t length = matchLength - LZ_MIN_MATCH;
+    *token |= (uint8_t) std::min(length, (size_t) LZ_NIBBLE);
+    if (length >= LZ_NIBBLE)
+    {
+        writeLength(dst, length - LZ_NIBBLE);
+    }
+}
+
+/**
+ * LZ compresses a buffer in the LZ4 block layout: sequences of a token, literals and a match of at
+ * least 4 bytes up to 65535 bytes back, the last sequence holding only literals
+ * @param src input bytes
+ * @param size amount of input bytes
+ * @param dst output, lzCompressBound(size) bytes
+ * @return amount of bytes written to dst
+ */
+size_t lzCompress(const uint8_t *src, size_t size, uint8_t *dst)
+{
+    uint8_t *const start = dst;
+    size_t anchor = ZERO;
+    if (size > LZ_MATCH_LIMIT)
+    {
+        // the last position of every table slot, matches are only searched up to LZ_MATCH_LIMIT bytes
+        // before the end and never run into the final LZ_LAST_LITERALS bytes, like LZ4 does
+        std::vector<uint32_t> table((size_t) ONE << LZ_HASH_BITS, ZERO);
+        const size_t searchEnd = size - LZ_MATCH_LIMIT;
+        const size_t matchEnd = size - LZ_LAST_LITERALS;
+        size_t i = ONE;
+        while (i < searchEnd)
+        {
+            const uint32_t sequence = load32(src + i);
+            uint32_t &slot = table[(sequence * LZ_HASH_MULTIPLIER) >> (32 - LZ_HASH_BITS)];
+            const size_t candidate = slot;
+            slot = (uint32_t) i;
+            if (i - candidate > LZ_MAX_OFFSET || load32(src + candidate) != sequence)
+            {
+                // skip ahead faster the longer nothing matched, incompressible data goes quickly
+                i += ONE + ((i - anchor) >> LZ_SKIP_SHIFT);
+                continue;
+            }
+            size_t length = LZ_MIN_MATCH;
+            while (i + length < matchEnd && src[candidate + length] == src[i + length])
+            {
+                length++;
+            }
+            writeSequence(dst, src + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+    }
+    writeSequence(dst, src + anchor, size - anchor, ZERO, ZERO);
+    return (size_t) (dst - start);
+}
+
+/**
+ * Reads the extension bytes of a length whose 4 bit token field was full
+ * @param src input, advanced
+ * @param end end of the input
+ * @param length the length, increased
+ * @return false if the input ends first
+ */
+static bool readLength(const uint8_t *&src, const uint8_t *end, size_t &length)
+{
+    uint8_t byte;
+    do
+    {
+        if (src == end)
+        {
+            return false;
+        }
+        byte = *src++;
+        length += byte;
+    } while (byte == LZ_EXTEND);
+    return true;
+}
+
+/**
+ * Decompresses a buffer written by lzCompress, never reads or writes out of bounds
+ * @param src compressed bytes
+ * @param srcSize amount of compressed bytes
+ * @param dst output
+ * @param dstSize expected amount of decompressed bytes
+ * @return true if src is valid and decompresses to exactly dstSize bytes
+ */
+bool lzDecompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+{
+    const uint8_t *const srcEnd = src + srcSize;
+    uint8_t *const start = dst;
+    uint8_t *const dstEnd = dst + dstSize;
+    while (src < srcEnd)
+    {
+        const uint8_t token = *src++;
+        size_t literalLength = token >> LZ_NIBBLE_SHIFT;
+        if ((literalLength == LZ_NIBBLE && !readLength(src, srcEnd, literalLength)) ||
+            literalLength > (size_t) (srcEnd - src) || literalLength > (size_t) (dstEnd - dst))
+        {
+            return false;
+        }
+        std::memcpy(dst, src, literalLength);
+        src += literalLength;
+        dst += literalLength;
+        if (src == srcEnd)
+        {
+            break;
+        }
+        if (srcEnd - src < 2)
+        {
+            return false;
+        }
+        const size_t offset = src[0] | ((size_t) src[1] << BYTE_SHIFT);
+        src += 2;
+        size_t length = token & LZ_NIBBLE;
+        if ((length == LZ_NIBBLE && !readLength(src, srcEnd, length)) || offset == ZERO ||
+            offset > (size_t) (dst - start))
+        {
+            return false;
+        }
+        length += LZ_MIN_MATCH;
+        if (length > (size_t) (dstEnd - dst))
+        {
+            return false;
+        }
+        const uint8_t *match = dst - offset;
+        if (offset >= length)
+        {
+            std::memcpy(dst, match, length);
+        }
+        else
+        {
+            // an overlapping match repeats the last offset bytes, copied forward byte by byte
+            for (size_t k = 0; k < length; k++)
+            {
+                dst[k] = match[k];
+            }
+        }
+        dst += length;
+    }
+    return dst == dstEnd;
+}
@@ -0,0 +1,119 @@
+// MatrixIO.h
+
+#ifndef MATRIXIO_H
+#define MATRIXIO_H
+
+#include "Matrix.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Binary matrix file format, all integers little endian:
+ *   MatrixFileHeader
+ *   per matrix a MatrixEntry and its payload, both starting at a multiple of MATRIX_FILE_ALIGNMENT bytes
+ *   from the start of the file
+ * A raw payload is the rows × cols floats in row major order. A compressed payload holds the same
+ * floats byte shuffled (all first bytes, then all second bytes, ...) and then LZ compressed, the
+ * shuffle lines up the sign and exponent bytes, which repeat a lot in activations. A matrix is
+ * only stored compressed when that saves space.
+ */
+#define MATRIX_MAGIC "MTXB"
+#define MATRIX_VERSION 1
+#define MATRIX_FILE_ALIGNMENT 64
+
+/**
+ * @enum MatrixCompression
+ * @brief How the payload of a matrix is stored
+ */
+enum MatrixCompression
+{
+    NoCompression,
+    LzCompression
+};
+
+/**
+ * @struct MatrixFileHeader
+ * @brief Header at the start of a matrix file
+ */
+typedef struct MatrixFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} MatrixFileHeader;
+
+/**
+ * @struct MatrixEntry
+ * @brief Shape and payload size of one matrix
+ */
+typedef struct MatrixEntry
+{
+    int32_t rows;
+    int32_t cols;
+    int32_t compression;
+    int32_t reserved;
+    uint64_t payloadBytes;
+} MatrixEntry;
+
+/**
+ * Writes matrices as one matrix file, every payload in a single write
+ * @param output binary output stream
+ * @param matrices the matrices
+ * @param compression NoCompression, or LzCompression to compress every matrix it makes smaller
+ */
+void writeMatrices(std::ostream &output, const std::vector<Matrix> &matrices,
+                   MatrixCompression compression = NoCompression);
+
+/**
+ * Writes a single matrix as a matrix file
+ * @param output binary output stream
+ * @param m the matrix
+ * @param compression NoCompression or LzCompression
+ */
+void writeMatrix(std::ostream &output, const Matrix &m, MatrixCompression compression = NoCompression);
+
+/**
+ * Reads every matrix of a matrix file, terminates when the file is invalid. Every header is checked
+ * against the bytes left in a seekable stream before its matrix is allocated, so a damaged file fails
+ * with the format error instead of allocating what its header claims.
+ * @param input binary input stream, positioned at the start of the file
+ * @return the matrices, in order
+ */
+std::vector<Matrix> readMatrices(std::istream &input);
+
+/**
+ * Reads a matrix file holding a single matrix, terminates when the file is invalid
+ * @param input binary input stream, positioned at the start of the file
+ * @return the matrix
+ */
+Matrix readMatrix(std::istream &input);
+
+/**
+ * Returns the largest size lzCompress can produce from size bytes
+ * @param size amount of input bytes
+ */
+size_t lzCompressBound(size_t size);
+
+/**
+ * LZ compresses a buffer in the LZ4 block layout: sequences of a token, literals and a match of at
+ * least 4 bytes up to 65535 bytes back, the last sequence holding only literals
+ * @param src input bytes
+ * @param size amount of input bytes
+ * @param dst output, lzCompressBound(size) bytes
+ * @return amount of bytes written to dst
+ */
+size_t lzCompress(const uint8_t *src, size_t size, uint8_t *dst);
+
+/**
+ * Decompresses a buffer written by lzCompress, never reads or writes out of bounds
+ * @param src compressed bytes
+ * @param srcSize amount of compressed bytes
+ * @param dst output
+ * @param dstSize expected amount of decompressed bytes
+ * @return true if src is valid and decompresses to exactly dstSize bytes
+ */
+bool lzDecompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+#endif //MATRIXIO_H
@@ -0,0 +1,216 @@
+#include "MatrixView.h"
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VIEW_X86 1
+#include <immintrin.h>
+#endif
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define MATRIX_DIM_ERROR_MSG "Error: matrix dimensions is not valid."
+#define OUTOFBOUND_ERROR "Error: index out of bound"
+#define HALF 2
+// side of the register transposed tiles inside a leaf, one AVX register per row
+#define TRANSPOSE_TILE 8
+
+/**
+ * Reports a view of invalid dimensions and terminates
+ */
+void viewDimError()
+{
+    std::cerr << MATRIX_DIM_ERROR_MSG << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Reports an out of bound index of a view and terminates
+ */
+void viewOutOfBound()
+{
+    std::cerr << OUTOFBOUND_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Splits a side in two, on a multiple of TRANSPOSE_BLOCK while the side holds several tiles, so the
+ * leaves are whole tiles wherever possible
+ * @param length side length, more than TRANSPOSE_BLOCK
+ * @return length of the first part
+ */
+static int splitSide(int length)
+{
+    int half = length / HALF / TRANSPOSE_BLOCK * TRANSPOSE_BLOCK;
+    return (half > 0) ? half : length / HALF;
+}
+
+/**
+ * A kernel transposing one TRANSPOSE_TILE × TRANSPOSE_TILE tile between row major operands
+ */
+typedef void (*TileKernel)(const float *src, ptrdiff_t rss, float *dst, ptrdiff_t rsd);
+
+/**
+ * Transposes a tile element by element
+ * @param src pointer to the tile in src
+ * @param rss distance between two rows of src
+ * @param dst pointer to the tile in dst
+ * @param rsd distance between two rows of dst
+ */
+static void scalarTile(const float *src, ptrdiff_t rss, float *dst, ptrdiff_t rsd)
+{
+    for (int i = 0; i < TRANSPOSE_TILE; i++)
+    {
+        for (int j = 0; j < TRANSPOSE_TILE; j++)
+        {
+            dst[j * rsd + i] = src[i * rss + j];
+        }
+    }
+}
+
+#ifdef VIEW_X86
+/**
+ * Transposes a tile in registers: eight row loads, three rounds of shuffles, eight row stores
+ * @param src pointer to the tile in src
+ * @param rss distance between two rows of src
+ * @param dst pointer to the tile in dst
+ * @param rsd distance between two rows of dst
+ */
+__attribute__((target("avx"))) static void avxTile(const float *src, ptrdiff_t rss, float *dst, ptrdiff_t rsd)
+{
+    __m256 r[TRANSPOSE_TILE];
+    for (int i = 0; i < TRANSPOSE_TILE; i++)
+    {
+        r[i] = _mm256_loadu_ps(src + i * rss);
+    }
+    // interleave pairs of rows, then pairs of pairs, then swap the 128 bit halves
+    __m256 t[TRANSPOSE_TILE];
+    for (int i = 0; i < TRANSPOSE_TILE; i += 2)
+    {
+        t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < TRANSPOSE_TILE; i += 4)
+    {
+        r[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (int j = 0; j < TRANSPOSE_TILE / 2; j++)
+    {
+        _mm256_storeu_ps(dst + j * rsd, _mm256_permute2f128_ps(r[j], r[j + 4], 0x20));
+        _mm256_storeu_ps(dst + (j + 4) * rsd, _mm256_permute2f128_ps(r[j], r[j + 4], 0x31));
+    }
+}
+#endif
+
+/**
+ * Queries cpuid and picks the tile kernel
+ * @return the kernel
+ */
+static TileKernel selectTile()
+{
+#ifdef VIEW_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx"))
+    {
+        return avxTile;
+    }
+#endif
+    return scalarTile;
+}
+
+/**
+ * Transposes one leaf, at most TRANSPOSE_BLOCK × TRANSPOSE_BLOCK, dst(j, i) = src(i, j)
+ * @param rows rows of src
+ * @param cols cols of src
+ * @param src pointer to src
+ * @param rss distance between two rows of src
+ * @param css distance between two cols of src
+ * @param dst pointer to dst
+ * @param rsd distance between two rows of dst
+ * @param csd distance between two cols of dst
+ * @param tile the tile kernel
+ */
+static void transposeLeaf(int rows, int cols, const float *src, ptrdiff_t rss, ptrdiff_t css, float *dst,
+                          ptrdiff_t rsd, ptrdiff_t csd, TileKernel tile)
+{
+    int i = 0;
+    int tiledCols = 0;
+    if (css == 1 && csd == 1)
+    {
+        // the common case of two row major operands, whole tiles go through registers
+        tiledCols = cols - cols % TRANSPOSE_TILE;
+        const int tiledRows = rows - rows % TRANSPOSE_TILE;
+        // down the source columns, the tiles side by side in dst complete its cache lines in turn
+        for (int j = 0; j < tiledCols; j += TRANSPOSE_TILE)
+        {
+            for (int r = 0; r < tiledRows; r += TRANSPOSE_TILE)
+            {
+                tile(src + r * rss + j, rss, dst + j * rsd + r, rsd);
+            }
+        }
+        i = tiledRows;
+    }
+    // the columns right of the tiles, then the rows below them
+    for (int r = 0; r < i; r++)
+    {
+        for (int j = tiledCols; j < cols; j++)
+        {
+            dst[j * rsd + r * csd] = src[r * rss + j * css];
+        }
+    }
+    for (; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            dst[j * rsd + i * csd] = src[i * rss + j * css];
+        }
+    }
+}
+
+/**
+ * Cache oblivious transpose, halves the longer side until the pieces are leaves
+ * @param rows rows of src
+ * @param cols cols of src
+ * @param src pointer to src
+ * @param rss distance between two rows of src
+ * @param css distance between two cols of src
+ * @param dst pointer to dst
+ * @param rsd distance between two rows of dst
+ * @param csd distance between two cols of dst
+ * @param tile the tile kernel
+ */
+static void transposeRecursive(int rows, int cols, const float *src, ptrdiff_t rss, ptrdiff_t css, float *dst,
+                               ptrdiff_t rsd, ptrdiff_t csd, TileKernel tile)
+{
+    if (rows <= TRANSPOSE_BLOCK && cols <= TRANSPOSE_BLOCK)
+    {
+        transposeLeaf(rows, cols, src, rss, css, dst, rsd, csd, tile);
+        return;
+    }
+    if (rows >= cols)
+    {
+        int top = splitSide(rows);
+        transposeRecursive(top, cols, src, rss, css, dst, rsd, csd, tile);
+        transposeRecursive(rows - top, cols, src + top * rss, rss, css, dst + top * csd, rsd, csd, tile);
+        return;
+    }
+    int left = splitSide(cols);
+    transposeRecursive(rows, left, src, rss, css, dst, rsd, csd, tile);
+    transposeRecursive(rows, cols - left, src + left * css, rss, css, dst + left * rsd, rsd, csd, tile);
+}
+
+/**
+ * Copies src^T into dst, recursively halving the longer side so that at every cache level the
+ * tiles being read and written fit, without tuning for any of them
+ * @param src rows × cols view
+ * @param dst cols × rows view, must not overlap src
+ */
+void transpose(const ConstMatrixView &src, const MatrixView &dst)
+{
+    if (dst.getRows() != src.getCols() || dst.getCols() != src.getRows())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    static const TileKernel tile = selectTile();
+    transposeRecursive(src.getRows(), src.getCols(), src.data(), src.getRowStride(), src.getColStride(),
+                       dst.data(), dst.getRowStride(), dst.getColStride(), tile);
+}
@@ -0,0 +1,202 @@
+// MatrixView.h
+
+#ifndef MATRIXVIEW_H
+#define MATRIXVIEW_H
+
+#include "Matrix.h"
+#include <cstddef>
+
+/*
+ * Leaf size of the recursive transpose, a TRANSPOSE_BLOCK × TRANSPOSE_BLOCK tile of the source and
+ * of the destination (4 KB each) stay in L1 together. May be overridden at build time.
+ */
+#ifndef TRANSPOSE_BLOCK
+#define TRANSPOSE_BLOCK 32
+#endif
+
+/**
+ * Reports a view of invalid dimensions and terminates
+ */
+void viewDimError();
+
+/**
+ * Reports an out of bound index of a view and terminates
+ */
+void viewOutOfBound();
+
+/**
+ * A non-owning rows × cols window onto floats owned by someone else, element (i, j) lives at
+ * data[i * rowStride + j * colStride]. Rows, columns, sub-blocks and transposes of a view are views
+ * of the same memory, taking one never copies. MatrixView writes through, ConstMatrixView does not;
+ * a MatrixView converts to a ConstMatrixView. The memory has to outlive every view of it.
+ */
+template<class T>
+class BasicMatrixView
+{
+public:
+    /**
+     * Constructs a view over strided memory
+     * @param data pointer to element (0, 0)
+     * @param rows positive number
+     * @param cols positive number
+     * @param rowStride distance between two rows
+     * @param colStride distance between two cols
+     */
+    BasicMatrixView(T *data, int rows, int cols, int rowStride, int colStride) : _data(data), _rowsNum(rows),
+                                                                                 _colsNum(cols),
+                                                                                 _rowStride(rowStride),
+                                                                                 _colStride(colStride)
+    {
+        if (rows <= 0 || cols <= 0 || data == nullptr)
+        {
+            viewDimError();
+        }
+    }
+
+    /**
+     * Constructs a read only view from a writable one
+     * @param other the view
+     */
+    template<class U>
+    BasicMatrixView(const BasicMatrixView<U> &other) : _data(other.data()), _rowsNum(other.getRows()),
+                                                       _colsNum(other.getCols()),
+                                                       _rowStride(other.getRowStride()),
+                                                       _colStride(other.getColStride())
+    {
+    }
+
+    /**
+     * getter - returns the amount of rows
+     */
+    int getRows() const
+    {
+        return _rowsNum;
+    }
+
+    /**
+     * getter - returns the amount of cols
+     */
+    int getCols() const
+    {
+        return _colsNum;
+    }
+
+    /**
+     * getter - returns the distance between two rows
+     */
+    int getRowStride() const
+    {
+        return _rowStride;
+    }
+
+    /**
+     * getter - returns the distance between two cols
+     */
+    int getColStride() const
+    {
+        return _colStride;
+    }
+
+    /**
+     * Returns a pointer to element (0, 0)
+     */
+    T *data() const
+    {
+        return _data;
+    }
+
+    /**
+     * Returns true if every row is contiguous (a column stride of 1), the layout the row major
+     * kernels read without a copy
+     */
+    bool isRowMajor() const
+    {
+        return _colStride == 1;
+    }
+
+    /**
+     * Parenthesis indexing
+     * @param i int rows index
+     * @param j int col index
+     * @return the element
+     */
+    T &operator()(int i, int j) const
+    {
+#if MATRIX_BOUNDS_CHECK
+        if (i >= _rowsNum || j >= _colsNum || i < 0 || j < 0)
+        {
+            viewOutOfBound();
+        }
+#endif
+        return _data[(ptrdiff_t) i * _rowStride + (ptrdiff_t) j * _colStride];
+    }
+
+    /**
+     * Returns row i as a 1 × cols view
+     * @param i row index
+     */
+    BasicMatrixView row(int i) const
+    {
+        return block(i, 0, 1, _colsNum);
+    }
+
+    /**
+     * Returns column j as a rows × 1 view
+     * @param j col index
+     */
+    BasicMatrixView col(int j) const
+    {
+        return block(0, j, _rowsNum, 1);
+    }
+
+    /**
+     * Returns the rows × cols sub-block whose first element is (i, j)
+     * @param i first row
+     * @param j first col
+     * @param rows positive number
+     * @param cols positive number
+     */
+    BasicMatrixView block(int i, int j, int rows, int cols) const
+    {
+        if (i < 0 || j < 0 || rows <= 0 || cols <= 0 || rows > _rowsNum - i || cols > _colsNum - j)
+        {
+            viewOutOfBound();
+        }
+        return BasicMatrixView(&(*this)(i, j), rows, cols, _rowStride, _colStride);
+    }
+
+    /**
+     * Returns the transpose, a cols × rows view of the same memory with the strides swapped
+     */
+    BasicMatrixView transposed() const
+    {
+        return BasicMatrixView(_data, _colsNum, _rowsNum, _colStride, _rowStride);
+    }
+
+private:
+    T *_data;
+    int _rowsNum;
+    int _colsNum;
+    int _rowStride;
+    int _colStride;
+};
+
+/**
+ * Copies src^T into dst, recursively halving the longer side so that at every cache level the
+ * tiles being read and written fit, without tuning for any of them
+ * @param src rows × cols view
+ * @param dst cols × rows view, must not overlap src
+ */
+void transpose(const ConstMatrixView &src, const MatrixView &dst);
+
+inline MatrixView Matrix::view()
+{
+    return MatrixView(_matrix, _rowsNum, _colsNum, _colsNum, 1);
+}
+
+inline ConstMatrixView Matrix::view() const
+{
+    return ConstMatrixView(_matrix, _rowsNum, _colsNum, _colsNum, 1);
+}
+
+#endif //MATRIXVIEW_H
@@ -0,0 +1,163 @@
+#include "MlpGraph.h"
+#include "MlpNetwork.h"
+#include <algorithm>
+#include <utility>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define LAYER_ERROR_MSG "Error: invalid layer index"
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Constructor - chains the given layers, terminates when the shapes of two consecutive layers
+ * do not match
+ * @param layers the layers, in order, at least one
+ */
+MlpGraph::MlpGraph(std::vector<Dense> layers) : _layers(std::move(layers)), _maxWidth(ZERO)
+{
+    _plan();
+}
+
+/**
+ * Constructor - builds every layer of a model file, of any depth, on views into the mapping.
+ * The model has to outlive the graph.
+ * @param model the model
+ */
+MlpGraph::MlpGraph(const MappedModel &model) : _maxWidth(ZERO)
+{
+    _layers.reserve(model.getLayerCount());
+    for (int i = 0; i < model.getLayerCount(); i++)
+    {
+        _layers.emplace_back(model.getWeights(i), model.getBias(i), model.getActivation(i));
+    }
+    _plan();
+}
+
+/**
+ * getter - returns the amount of layers
+ */
+int MlpGraph::getLayerCount() const
+{
+    return (int) _layers.size();
+}
+
+/**
+ * getter - returns layer number i, 0 is the input layer
+ * @param i layer index
+ */
+const Dense &MlpGraph::getLayer(int i) const
+{
+    if (i < ZERO || i >= getLayerCount())
+    {
+        std::cerr << LAYER_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return _layers[i];
+}
+
+/**
+ * getter - returns the amount of inputs of the first layer
+ */
+int MlpGraph::getInputSize() const
+{
+    return _layers.front().getWeights().getCols();
+}
+
+/**
+ * getter - returns the amount of outputs of the last layer
+ */
+int MlpGraph::getOutputSize() const
+{
+    return _layers.back().getWeights().getRows();
+}
+
+/**
+ * Applies every layer on a single input
+ * @param input pointer to getInputSize() floats
+ * @param output pointer to getOutputSize() floats, overwritten
+ */
+void MlpGraph::forward(const float *input, float *output) const
+{
+    // one arena per thread, grown to the widest graph the thread has run and then reused
+    static thread_local std::vector<float> arena;
+    if (arena.size() < (size_t) 2 * _maxWidth)
+    {
+        arena.resize((size_t) 2 * _maxWidth);
+    }
+    float *ping = arena.data();
+    float *pong = arena.data() + _maxWidth;
+    const int last = getLayerCount() - ONE;
+    for (int i = 0; i < last; i++)
+    {
+        _layers[i].apply(input, ping);
+        input = ping;
+        std::swap(ping, pong);
+    }
+    _layers[last].apply(input, output);
+}
+
+/**
+ * Parenthesis operator - Applies the entire graph on input
+ * @param img - matrix of getInputSize() elements
+ * @return digit struct of the most probable output
+ */
+Digit MlpGraph::operator()(const Matrix &img) const
+{
+    if (img.size() != getInputSize())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    static thread_local std::vector<float> output;
+    if (output.size() < (size_t) getOutputSize())
+    {
+        output.resize(getOutputSize());
+    }
+    forward(img.data(), output.data());
+    return MlpNetwork::toDigit(output.data(), getOutputSize(), ONE);
+}
+
+/**
+ * Applies the entire graph on inputs stored one after the other, every layer runs as one GEMM
+ * @param images pointer to count * getInputSize() contiguous floats
+ * @param count amount of inputs
+ * @return digit struct of every input, in order
+ */
+std::vector<Digit> MlpGraph::classify(const float *images, int count) const
+{
+    // the inputs already are a batch with one input per row, the first layer reads them in place
+    Matrix activations = Matrix(count, getInputSize(), const_cast<float *>(images));
+    for (const Dense &layer : _layers)
+    {
+        activations = layer.applyRows(activations);
+    }
+    std::vector<Digit> digits;
+    digits.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        digits.push_back(MlpNetwork::toDigit(activations.row(i), activations.getCols(), ONE));
+    }
+    return digits;
+}
+
+/**
+ * Checks the layer chain and plans the activation arena, terminates on mismatching shapes
+ */
+void MlpGraph::_plan()
+{
+    if (_layers.empty())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < _layers.size(); i++)
+    {
+        const Matrix &w = _layers[i].getWeights();
+        if (_layers[i].getBias().size() != w.getRows() ||
+            (i > ZERO && w.getCols() != _layers[i - ONE].getWeights().getRows()))
+        {
+            std::cerr << DIM_ERROR_MSG << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        _maxWidth = std::max(_maxWidth, w.getRows());
+    }
+}
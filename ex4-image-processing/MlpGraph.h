@@ -0,0 +1,87 @@
+// MlpGraph.h
+
+#ifndef MLPGRAPH_H
+#define MLPGRAPH_H
+
+#include "Dense.h"
+#include "Digit.h"
+#include "MappedModel.h"
+#include <vector>
+
+/**
+ * A network of any depth and width, a chain of Dense layers where the outputs of every layer are
+ * the inputs of the next. The activation sizes are planned at construction: a single input forward
+ * pass ping-pongs between two halves of a per-thread arena sized for the widest layer, so once a
+ * thread has run the graph its forward passes perform no heap allocation.
+ */
+class MlpGraph
+{
+public:
+    /**
+     * Constructor - chains the given layers, terminates when the shapes of two consecutive layers
+     * do not match
+     * @param layers the layers, in order, at least one
+     */
+    explicit MlpGraph(std::vector<Dense> layers);
+
+    /**
+     * Constructor - builds every layer of a model file, of any depth, on views into the mapping.
+     * The model has to outlive the graph.
+     * @param model the model
+     */
+    explicit MlpGraph(const MappedModel &model);
+
+    /**
+     * getter - returns the amount of layers
+     */
+    int getLayerCount() const;
+
+    /**
+     * getter - returns layer number i, 0 is the input layer
+     * @param i layer index
+     */
+    const Dense &getLayer(int i) const;
+
+    /**
+     * getter - returns the amount of inputs of the first layer
+     */
+    int getInputSize() const;
+
+    /**
+     * getter - returns the amount of outputs of the last layer
+     */
+    int getOutputSize() const;
+
+    /**
+     * Applies every layer on a single input
+     * @param input pointer to getInputSize() floats
+     * @param output pointer to getOutputSize() floats, overwritten
+     */
+    void forward(const float *input, float *output) const;
+
+    /**
+     * Parenthesis operator - Applies the entire graph on input
+     * @param img - matrix of getInputSize() elements
+     * @return digit struct of the most probable output
+     */
+    Digit operator()(const Matrix &img) const;
+
+    /**
+     * Applies the entire graph on inputs stored one after the other, every layer runs as one GEMM
+     * @param images pointer to count * getInputSize() contiguous floats
+     * @param count amount of inputs
+     * @return digit struct of every input, in order
+     */
+    std::vector<Digit> classify(const float *images, int count) const;
+
+private:
+    std::vector<Dense> _layers;
+    int _maxWidth;
+
+    /**
+     * Checks the layer chain and plans the activation arena, terminates on mismatching shapes
+     */
+    void _plan();
+};
+
+#endif //MLPGRAPH_H
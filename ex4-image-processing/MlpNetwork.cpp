@@ -1,26 +1,75 @@
 #include "MlpNetwork.h"
+#include "LayerProfiler.h"
+#include "VectorOps.h"
+#include <algorithm>
+#include <cstring>
 #define ONE 1
 #define ZERO 0
 #define TWO 2
 #define THREE 3
+#define PARALLEL_IMAGES 64
+#define LAYER_ERROR_MSG "Error: invalid layer index"
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define WRITE_FILE_ERROR "Error: could not write the results"
+#define MODEL_SHAPE_ERROR "Error: model does not match the network shape"
+
+/**
+ * Checks that a mapped model has the layer shapes of this network, terminates otherwise
+ * @param model the model
+ * @return the model
+ */
+static const MappedModel &checkedModel(const MappedModel &model)
+{
+    bool valid = model.getLayerCount() == MLP_SIZE;
+    for (int i = 0; valid && i < MLP_SIZE; i++)
+    {
+        valid = model.getWeights(i).getRows() == weightsDims[i].rows &&
+                model.getWeights(i).getCols() == weightsDims[i].cols &&
+                model.getBias(i).getRows() == biasDims[i].rows;
+    }
+    if (!valid)
+    {
+        std::cerr << MODEL_SHAPE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return model;
+}
 /**
  *
  * @param weights
  * @param biases
  */
-MlpNetwork::MlpNetwork(Matrix weights[MLP_SIZE], Matrix biases[MLP_SIZE]): _weights(weights), _biases(biases),
-                                                            _firstDense(Dense(_weights[ZERO], _biases[ZERO],
+MlpNetwork::MlpNetwork(Matrix weights[MLP_SIZE], Matrix biases[MLP_SIZE]):
+                                                            _firstDense(Dense(weights[ZERO], biases[ZERO],
                                                                     Relu)),
-                                                            _secondDense(Dense(_weights[ONE], _biases[ONE],
+                                                            _secondDense(Dense(weights[ONE], biases[ONE],
                                                                     Relu)),
-                                                            _thirdDense(Dense(_weights[TWO], _biases[TWO],
+                                                            _thirdDense(Dense(weights[TWO], biases[TWO],
                                                                     Relu)),
-                                                            _fourthDense( Dense(_weights[THREE], _biases[THREE],
+                                                            _fourthDense( Dense(weights[THREE], biases[THREE],
                                                                     Softmax))
 
 {
 }
 
+/**
+ * Constructor - builds the network on views into a mapped model file, the row major weights are not
+ * copied. Single images read them in place and a batch packs one layout of each layer on first use.
+ * Mapped layers always run dense, constructing the network reads none of the weight pages.
+ * The model has to outlive the network.
+ * @param model a model of MLP_SIZE layers shaped like weightsDims and biasDims
+ */
+MlpNetwork::MlpNetwork(const MappedModel &model) : _firstDense(checkedModel(model).getWeights(ZERO),
+                                                               model.getBias(ZERO), model.getActivation(ZERO)),
+                                                   _secondDense(model.getWeights(ONE), model.getBias(ONE),
+                                                                model.getActivation(ONE)),
+                                                   _thirdDense(model.getWeights(TWO), model.getBias(TWO),
+                                                               model.getActivation(TWO)),
+                                                   _fourthDense(model.getWeights(THREE), model.getBias(THREE),
+                                                                model.getActivation(THREE))
+{
+}
+
 /**
  * Parenthesis operator - Applies the entire network on input
  * @param img - matrix
@@ -28,17 +77,284 @@ MlpNetwork::MlpNetwork(Matrix weights[MLP_SIZE], Matrix biases[MLP_SIZE]): _weig
  */
 Digit MlpNetwork::operator()(const Matrix &img) const
 {
-    Matrix activateFirstDense =  _firstDense(img);
-    Matrix activateSecondDense = _secondDense(activateFirstDense);
-    Matrix activateThirdDense = _thirdDense(activateSecondDense);
-    Matrix result = _fourthDense(activateThirdDense);
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, img, _firstDense(img));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense, _secondDense(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense, _thirdDense(activateSecondDense));
+    Matrix result = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense(activateThirdDense));
+    return toDigit(result.data(), result.getRows(), ONE);
+}
+
+/**
+ * Applies the entire network on a batch of images, every layer runs as one GEMM
+ * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+ * @return digit struct of every image, in column order
+ */
+std::vector<Digit> MlpNetwork::classify(const Matrix &images) const
+{
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, images, _firstDense(images));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense, _secondDense(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense, _thirdDense(activateSecondDense));
+    Matrix result = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense(activateThirdDense));
+    std::vector<Digit> digits;
+    digits.reserve(result.getCols());
+    for (int j = 0; j < result.getCols(); j++)
+    {
+        digits.push_back(toDigit(result.data() + j, result.getRows(), result.getCols()));
+    }
+    return digits;
+}
+
+/**
+ * Applies the entire network on a batch of images stored one after the other
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images
+ * @return digit struct of every image, in order
+ */
+std::vector<Digit> MlpNetwork::classify(const float *images, int count) const
+{
+    // the images already are a batch with one input per row, the layers read them in place
+    Matrix batch = Matrix(count, imgDims.rows * imgDims.cols, const_cast<float *>(images));
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, batch, _firstDense.applyRows(batch));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense,
+                                              _secondDense.applyRows(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense,
+                                             _thirdDense.applyRows(activateSecondDense));
+    Matrix result = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense.applyRows(activateThirdDense));
+    std::vector<Digit> digits;
+    digits.reserve(result.getRows());
+    for (int i = 0; i < result.getRows(); i++)
+    {
+        digits.push_back(toDigit(result.row(i), result.getCols(), ONE));
+    }
+    return digits;
+}
+
+/**
+ * Checks that a stream holds images of the network input size, terminates otherwise
+ * @param images the stream
+ */
+static void checkStream(const ImageStream &images)
+{
+    if (images.getImageSize() != imgDims.rows * imgDims.cols)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Writes the results of a chunk as DIGIT_RECORD_SIZE byte records with a single write
+ * @param digits the results
+ * @param out output stream
+ */
+static void writeDigits(const std::vector<Digit> &digits, std::ostream &out)
+{
+    static thread_local std::vector<char> records;
+    records.resize(digits.size() * DIGIT_RECORD_SIZE);
+    char *record = records.data();
+    for (const Digit &digit : digits)
+    {
+        record[ZERO] = (char) digit.value;
+        std::memcpy(record + ONE, &digit.probability, sizeof(float));
+        record += DIGIT_RECORD_SIZE;
+    }
+    if (!out.write(records.data(), (std::streamsize) records.size()))
+    {
+        std::cerr << WRITE_FILE_ERROR << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Classifies every image of a stream chunk by chunk, the next chunk is read while the current one
+ * is classified as one batch. Results are written to out as DIGIT_RECORD_SIZE byte records, one
+ * write per chunk.
+ * @param images stream of imgDims.rows * imgDims.cols float images
+ * @param out output stream of the records
+ * @return amount of images classified
+ */
+long MlpNetwork::classify(ImageStream &images, std::ostream &out) const
+{
+    checkStream(images);
+    long total = ZERO;
+    const float *chunk = nullptr;
+    for (int count = images.next(chunk); count > ZERO; count = images.next(chunk))
+    {
+        writeDigits(classify(chunk, count), out);
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * Classifies every image of a stream chunk by chunk, sub-batches of a chunk are classified in
+ * parallel while the next chunk is read
+ * @param images stream of imgDims.rows * imgDims.cols float images
+ * @param out output stream of the records
+ * @param pool threads to use
+ * @return amount of images classified
+ */
+long MlpNetwork::classify(ImageStream &images, std::ostream &out, ThreadPool &pool) const
+{
+    checkStream(images);
+    long total = ZERO;
+    const float *chunk = nullptr;
+    for (int count = images.next(chunk); count > ZERO; count = images.next(chunk))
+    {
+        writeDigits(classify(chunk, count, pool), out);
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * Applies the entire network on input and returns only the most probable digit, the last layer
+ * stops at its logits since softmax does not change their order
+ * @param img - matrix
+ * @return the digit
+ */
+unsigned int MlpNetwork::predict(const Matrix &img) const
+{
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, img, _firstDense(img));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense, _secondDense(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense, _thirdDense(activateSecondDense));
+    Matrix logits = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense.logits(activateThirdDense));
+    return (unsigned int) vecArgmax(logits.data(), logits.getRows());
+}
+
+/**
+ * Applies the entire network on a batch of images and returns only the most probable digits
+ * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+ * @return the digit of every image, in column order
+ */
+std::vector<unsigned int> MlpNetwork::predictBatch(const Matrix &images) const
+{
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, images, _firstDense(images));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense, _secondDense(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense, _thirdDense(activateSecondDense));
+    Matrix logits = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense.logits(activateThirdDense));
+    std::vector<unsigned int> digits(logits.getCols(), ZERO);
+    for (int i = ONE; i < logits.getRows(); i++)
+    {
+        const float *row = logits.row(i);
+        for (int j = 0; j < logits.getCols(); j++)
+        {
+            digits[j] = (row[j] > logits.row(digits[j])[j]) ? i : digits[j];
+        }
+    }
+    return digits;
+}
+
+/**
+ * Parenthesis operator - Applies the entire network on input, the first layer is split by rows
+ * across the pool
+ * @param img - matrix
+ * @param pool threads to use
+ * @return digit struct
+ */
+Digit MlpNetwork::operator()(const Matrix &img, ThreadPool &pool) const
+{
+    Matrix activateFirstDense = MLP_PROFILED(ZERO, _firstDense, img, _firstDense(img, pool));
+    Matrix activateSecondDense = MLP_PROFILED(ONE, _secondDense, activateFirstDense, _secondDense(activateFirstDense));
+    Matrix activateThirdDense = MLP_PROFILED(TWO, _thirdDense, activateSecondDense, _thirdDense(activateSecondDense));
+    Matrix result = MLP_PROFILED(THREE, _fourthDense, activateThirdDense,
+                                 _fourthDense(activateThirdDense));
+    return toDigit(result.data(), result.getRows(), ONE);
+}
+
+/**
+ * Applies the entire network on a batch of images, sub-batches are classified in parallel
+ * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+ * @param pool threads to use
+ * @return digit struct of every image, in column order
+ */
+std::vector<Digit> MlpNetwork::classify(const Matrix &images, ThreadPool &pool) const
+{
+    std::vector<Digit> digits(images.getCols());
+    pool.parallelFor(ZERO, images.getCols(), PARALLEL_IMAGES, [this, &images, &digits](int first, int last)
+    {
+        Matrix batch = Matrix(images.getRows(), last - first);
+        for (int i = 0; i < images.getRows(); i++)
+        {
+            std::copy(images.row(i) + first, images.row(i) + last, batch.row(i));
+        }
+        std::vector<Digit> part = classify(batch);
+        std::copy(part.begin(), part.end(), digits.begin() + first);
+    });
+    return digits;
+}
+
+/**
+ * Applies the entire network on a batch of images stored one after the other, sub-batches are
+ * classified in parallel
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images
+ * @param pool threads to use
+ * @return digit struct of every image, in order
+ */
+std::vector<Digit> MlpNetwork::classify(const float *images, int count, ThreadPool &pool) const
+{
+    const int imgSize = imgDims.rows * imgDims.cols;
+    std::vector<Digit> digits(count);
+    pool.parallelFor(ZERO, count, PARALLEL_IMAGES, [this, images, imgSize, &digits](int first, int last)
+    {
+        std::vector<Digit> part = classify(images + first * imgSize, last - first);
+        std::copy(part.begin(), part.end(), digits.begin() + first);
+    });
+    return digits;
+}
+
+/**
+ * getter - returns the amount of layers
+ */
+int MlpNetwork::getLayerCount() const
+{
+    return MLP_SIZE;
+}
+
+/**
+ * getter - returns layer number i, 0 is the input layer
+ * @param i layer index
+ */
+const Dense &MlpNetwork::getLayer(int i) const
+{
+    switch (i)
+    {
+        case ZERO:
+            return _firstDense;
+        case ONE:
+            return _secondDense;
+        case TWO:
+            return _thirdDense;
+        case THREE:
+            return _fourthDense;
+        default:
+            std::cerr << LAYER_ERROR_MSG << std::endl;
+            exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Picks the most probable digit out of a probability column
+ * @param probabilities pointer to the first probability
+ * @param count amount of probabilities
+ * @param stride distance between two probabilities
+ * @return digit struct
+ */
+Digit MlpNetwork::toDigit(const float *probabilities, int count, int stride)
+{
     unsigned int index = ZERO;
     float max = ZERO;
-    for (int i = 0; i < result.getRows(); i++)
+    for (int i = 0; i < count; i++)
     {
-            if(max < result[i])
+            if(max < probabilities[i * stride])
             {
-                max = result[i];
+                max = probabilities[i * stride];
                 index = i;
             }
     }
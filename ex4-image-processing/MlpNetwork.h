@@ -6,12 +6,20 @@
 #include "Matrix.h"
 #include "Digit.h"
 #include "Dense.h"
+#include "MappedModel.h"
+#include "ImageStream.h"
+#include <vector>
 
 #define MLP_SIZE 4
 
-const MatrixDims imgDims = {28, 28};
-const MatrixDims weightsDims[] = {{128, 784}, {64, 128}, {20, 64}, {10, 20}};
-const MatrixDims biasDims[]    = {{128, 1}, {64, 1}, {20, 1},  {10, 1}};
+/*
+ * Bytes per result written by the streaming classify, the digit then its probability as a native float.
+ */
+#define DIGIT_RECORD_SIZE 5
+
+constexpr MatrixDims imgDims = {28, 28};
+constexpr MatrixDims weightsDims[] = {{128, 784}, {64, 128}, {20, 64}, {10, 20}};
+constexpr MatrixDims biasDims[]    = {{128, 1}, {64, 1}, {20, 1},  {10, 1}};
 
 /**
  * A class representing the mlp network
@@ -26,6 +34,15 @@ public:
      */
     MlpNetwork(Matrix weights[MLP_SIZE], Matrix biases[MLP_SIZE]);
 
+    /**
+     * Constructor - builds the network on views into a mapped model file, the row major weights are not
+     * copied. Single images read them in place and a batch packs one layout of each layer on first use.
+     * Mapped layers always run dense, constructing the network reads none of the weight pages.
+     * The model has to outlive the network.
+     * @param model a model of MLP_SIZE layers shaped like weightsDims and biasDims
+     */
+    explicit MlpNetwork(const MappedModel& model);
+
     /**
      * Parenthesis operator - Applies the entire network on input
      * @param img - matrix
@@ -33,11 +50,106 @@ public:
      */
     Digit operator()(const Matrix& img) const;
 
+    /**
+     * Applies the entire network on a batch of images, every layer runs as one GEMM
+     * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+     * @return digit struct of every image, in column order
+     */
+    std::vector<Digit> classify(const Matrix& images) const;
+
+    /**
+     * Applies the entire network on a batch of images stored one after the other
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images
+     * @return digit struct of every image, in order
+     */
+    std::vector<Digit> classify(const float* images, int count) const;
+
+    /**
+     * Classifies every image of a stream chunk by chunk, the next chunk is read while the current one
+     * is classified as one batch. Results are written to out as DIGIT_RECORD_SIZE byte records, one
+     * write per chunk.
+     * @param images stream of imgDims.rows * imgDims.cols float images
+     * @param out output stream of the records
+     * @return amount of images classified
+     */
+    long classify(ImageStream& images, std::ostream& out) const;
+
+    /**
+     * Classifies every image of a stream chunk by chunk, sub-batches of a chunk are classified in
+     * parallel while the next chunk is read
+     * @param images stream of imgDims.rows * imgDims.cols float images
+     * @param out output stream of the records
+     * @param pool threads to use
+     * @return amount of images classified
+     */
+    long classify(ImageStream& images, std::ostream& out, ThreadPool& pool) const;
+
+    /**
+     * Applies the entire network on input and returns only the most probable digit, the last layer
+     * stops at its logits since softmax does not change their order
+     * @param img - matrix
+     * @return the digit
+     */
+    unsigned int predict(const Matrix& img) const;
+
+    /**
+     * Applies the entire network on a batch of images and returns only the most probable digits
+     * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+     * @return the digit of every image, in column order
+     */
+    std::vector<unsigned int> predictBatch(const Matrix& images) const;
+
+    /**
+     * Parenthesis operator - Applies the entire network on input, the first layer is split by rows
+     * across the pool
+     * @param img - matrix
+     * @param pool threads to use
+     * @return digit struct
+     */
+    Digit operator()(const Matrix& img, ThreadPool& pool) const;
+
+    /**
+     * Applies the entire network on a batch of images, sub-batches are classified in parallel
+     * @param images matrix of imgDims.rows * imgDims.cols rows, one image per column
+     * @param pool threads to use
+     * @return digit struct of every image, in column order
+     */
+    std::vector<Digit> classify(const Matrix& images, ThreadPool& pool) const;
+
+    /**
+     * Applies the entire network on a batch of images stored one after the other, sub-batches are
+     * classified in parallel
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images
+     * @param pool threads to use
+     * @return digit struct of every image, in order
+     */
+    std::vector<Digit> classify(const float* images, int count, ThreadPool& pool) const;
+
+    /**
+     * getter - returns the amount of layers
+     */
+    int getLayerCount() const;
+
+    /**
+     * getter - returns layer number i, 0 is the input layer
+     * @param i layer index
+     */
+    const Dense& getLayer(int i) const;
+
+    /**
+     * Picks the most probable digit out of a probability column
+     * @param probabilities pointer to the first probability
+     * @param count amount of probabilities
+     * @param stride distance between two probabilities
+     * @return digit struct
+     */
+    static Digit toDigit(const float* probabilities, int count, int stride);
 
 
 private:
-    Matrix* _weights;
-    Matrix* _biases;
+
     Dense _firstDense;
     Dense _secondDense;
     Dense _thirdDense;
@@ -0,0 +1,497 @@
+#include "MlpTrainer.h"
+#include "Gemm.h"
+#include "VectorOps.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <utility>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define LAYER_ERROR_MSG "Error: invalid layer index"
+#define LABEL_ERROR_MSG "Error: invalid label"
+#define ACTIVATION_ERROR_MSG "Error: only ReLU hidden layers and a softmax output can be trained"
+#define OPTIONS_ERROR_MSG "Error: invalid training options"
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define LABEL_FORMAT_ERROR "Error: invalid label file"
+#define IDX1_HEADER 8
+#define HE_GAIN 2.0f
+#define ONE 1
+#define ZERO 0
+#define FLOAT_ZERO 0.0f
+#define FLOAT_ONE 1.0f
+
+/**
+ * Reports an error and terminates
+ * @param message the error message
+ */
+static void trainingError(const char *message)
+{
+    std::cerr << message << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Reads a big endian 32 bit word, the byte order of idx files
+ * @param bytes 4 bytes
+ * @return the word
+ */
+static uint32_t bigEndian(const unsigned char *bytes)
+{
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+/**
+ * Constructor - a new network, He initialized weights and zero biases
+ * @param widths amount of inputs then the outputs of every layer, e.g. {784, 128, 64, 20, 10}
+ * @param seed seed of the initialization
+ */
+MlpTrainer::MlpTrainer(const std::vector<int> &widths, uint32_t seed) : _steps(ZERO)
+{
+    if (widths.size() < 2 || *std::min_element(widths.begin(), widths.end()) <= ZERO)
+    {
+        trainingError(DIM_ERROR_MSG);
+    }
+    std::mt19937 random(seed);
+    for (size_t l = 0; l + ONE < widths.size(); l++)
+    {
+        // He initialization keeps the variance of the activations steady through ReLU layers
+        std::normal_distribution<float> normal(FLOAT_ZERO, std::sqrt(HE_GAIN / (float) widths[l]));
+        Matrix w(widths[l + ONE], widths[l]);
+        for (int i = 0; i < w.size(); i++)
+        {
+            w[i] = normal(random);
+        }
+        _addLayer(std::move(w), Matrix(widths[l + ONE], ONE));
+    }
+}
+
+/**
+ * Constructor - continues training the layers of a graph, which are copied. The hidden layers
+ * have to be ReLU and the last one softmax.
+ * @param graph the graph
+ */
+MlpTrainer::MlpTrainer(const MlpGraph &graph) : _steps(ZERO)
+{
+    for (int i = 0; i < graph.getLayerCount(); i++)
+    {
+        const Dense &dense = graph.getLayer(i);
+        ActivationType expected = (i + ONE == graph.getLayerCount()) ? Softmax : Relu;
+        if (dense.getActivation().getActivationType() != expected)
+        {
+            trainingError(ACTIVATION_ERROR_MSG);
+        }
+        _addLayer(Matrix(dense.getWeights()), Matrix(dense.getBias()));
+    }
+}
+
+/**
+ * getter - returns the amount of layers
+ */
+int MlpTrainer::getLayerCount() const
+{
+    return (int) _layers.size();
+}
+
+/**
+ * getter - returns the weights of layer i, outputs × inputs
+ * @param i layer index
+ */
+const Matrix &MlpTrainer::getWeights(int i) const
+{
+    _checkLayer(i);
+    return _layers[i].w;
+}
+
+/**
+ * getter - returns the bias of layer i, outputs × 1
+ * @param i layer index
+ */
+const Matrix &MlpTrainer::getBias(int i) const
+{
+    _checkLayer(i);
+    return _layers[i].bias;
+}
+
+/**
+ * getter - returns the gradient of the loss by the weights of layer i, as left by the last
+ * mini-batch of train or by gradients
+ * @param i layer index
+ */
+const Matrix &MlpTrainer::getWeightsGradient(int i) const
+{
+    _checkLayer(i);
+    return _layers[i].gradW;
+}
+
+/**
+ * getter - returns the gradient of the loss by the bias of layer i, as left by the last
+ * mini-batch of train or by gradients
+ * @param i layer index
+ */
+const Matrix &MlpTrainer::getBiasGradient(int i) const
+{
+    _checkLayer(i);
+    return _layers[i].gradBias;
+}
+
+/**
+ * Trains on a set of labeled images, every epoch visits them in a new random order
+ * @param images pointer to count * inputs contiguous floats
+ * @param labels count labels, each in [0, outputs)
+ * @param count amount of images, positive
+ * @param options hyper parameters
+ * @return mean loss and accuracy on the mini-batches of every epoch
+ */
+TrainingReport MlpTrainer::train(const float *images, const int *labels, int count, const TrainingOptions &options)
+{
+    const int inputs = _layers.front().w.getCols();
+    if (count <= ZERO || options.batchSize <= ZERO || options.epochs <= ZERO || options.learningRate <= FLOAT_ZERO)
+    {
+        trainingError(OPTIONS_ERROR_MSG);
+    }
+    _checkLabels(labels, count);
+    _prepare(options.batchSize);
+    Matrix batch(options.batchSize, inputs);
+    std::vector<int> batchLabels(options.batchSize);
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), ZERO);
+    std::mt19937 random(options.seed);
+
+    TrainingReport report;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int epoch = 0; epoch < options.epochs; epoch++)
+    {
+        std::shuffle(order.begin(), order.end(), random);
+        double loss = FLOAT_ZERO;
+        int correct = ZERO;
+        for (int first = 0; first < count; first += options.batchSize)
+        {
+            const int rows = std::min(options.batchSize, count - first);
+            for (int r = 0; r < rows; r++)
+            {
+                const float *image = images + (size_t) order[first + r] * inputs;
+                std::copy(image, image + inputs, batch.row(r));
+                batchLabels[r] = labels[order[first + r]];
+            }
+            const ConstMatrixView x = batch.view().block(ZERO, ZERO, rows, inputs);
+            _forward(x, rows);
+            loss += _loss(batchLabels.data(), rows, correct);
+            _backward(x, rows);
+            _step(options);
+        }
+        report.loss.push_back((float) (loss / count));
+        report.accuracy.push_back((float) correct / (float) count);
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+/**
+ * Runs the forward and backward pass of one mini-batch without updating anything, the gradients
+ * are read with getWeightsGradient and getBiasGradient
+ * @param images pointer to count * inputs contiguous floats
+ * @param labels count labels, each in [0, outputs)
+ * @param count amount of images, positive
+ * @return the mean loss of the images
+ */
+double MlpTrainer::gradients(const float *images, const int *labels, int count)
+{
+    if (count <= ZERO)
+    {
+        trainingError(OPTIONS_ERROR_MSG);
+    }
+    _checkLabels(labels, count);
+    _prepare(count);
+    const int inputs = _layers.front().w.getCols();
+    const ConstMatrixView x = ConstMatrixView(images, count, inputs, inputs, ONE);
+    int correct = ZERO;
+    _forward(x, count);
+    const double loss = _loss(labels, count, correct);
+    _backward(x, count);
+    return loss / count;
+}
+
+/**
+ * Returns the current layers as Dense layers
+ */
+std::vector<Dense> MlpTrainer::toLayers() const
+{
+    std::vector<Dense> layers;
+    layers.reserve(_layers.size());
+    for (size_t l = 0; l < _layers.size(); l++)
+    {
+        layers.emplace_back(_layers[l].w, _layers[l].bias, (l + ONE == _layers.size()) ? Softmax : Relu);
+    }
+    return layers;
+}
+
+/**
+ * Checks a layer index, terminates when it is out of range
+ * @param i layer index
+ */
+void MlpTrainer::_checkLayer(int i) const
+{
+    if (i < ZERO || i >= getLayerCount())
+    {
+        trainingError(LAYER_ERROR_MSG);
+    }
+}
+
+/**
+ * Checks every label against the amount of outputs, terminates on the first invalid one
+ * @param labels count labels
+ * @param count amount of labels
+ */
+void MlpTrainer::_checkLabels(const int *labels, int count) const
+{
+    const int outputs = _layers.back().w.getRows();
+    for (int i = 0; i < count; i++)
+    {
+        if (labels[i] < ZERO || labels[i] >= outputs)
+        {
+            trainingError(LABEL_ERROR_MSG);
+        }
+    }
+}
+
+/**
+ * Appends a layer with zero gradients and optimizer state
+ * @param w weights, outputs × inputs
+ * @param bias bias, outputs × 1
+ */
+void MlpTrainer::_addLayer(Matrix w, Matrix bias)
+{
+    if (bias.getRows() != w.getRows() || bias.getCols() != ONE ||
+        (!_layers.empty() && w.getCols() != _layers.back().w.getRows()))
+    {
+        trainingError(DIM_ERROR_MSG);
+    }
+    Layer layer;
+    layer.gradW = Matrix(w.getRows(), w.getCols());
+    layer.gradBias = Matrix(w.getRows(), ONE);
+    layer.momentW = Matrix(w.getRows(), w.getCols());
+    layer.momentBias = Matrix(w.getRows(), ONE);
+    layer.secondW = Matrix(w.getRows(), w.getCols());
+    layer.secondBias = Matrix(w.getRows(), ONE);
+    layer.w = std::move(w);
+    layer.bias = std::move(bias);
+    _layers.push_back(std::move(layer));
+}
+
+/**
+ * Sizes the mini-batch buffers of every layer, the optimizer state is kept across calls
+ * @param batchSize rows of the buffers
+ */
+void MlpTrainer::_prepare(int batchSize)
+{
+    for (Layer &layer : _layers)
+    {
+        if (layer.z.getRows() != batchSize || layer.z.getCols() != layer.w.getRows())
+        {
+            layer.z = Matrix(batchSize, layer.w.getRows());
+            layer.a = Matrix(batchSize, layer.w.getRows());
+            layer.delta = Matrix(batchSize, layer.w.getRows());
+        }
+    }
+}
+
+/**
+ * Forward pass of rows images, keeps z and a of every layer
+ * @param x rows × inputs images
+ * @param rows images in the batch
+ */
+void MlpTrainer::_forward(const ConstMatrixView &x, int rows)
+{
+    ConstMatrixView input = x;
+    for (size_t l = 0; l < _layers.size(); l++)
+    {
+        Layer &layer = _layers[l];
+        const int outputs = layer.w.getRows();
+        // Z = A * W^T, the transpose is a view the GEMM packs from in place
+        gemm(input, layer.w.view().transposed(), layer.z.view().block(ZERO, ZERO, rows, outputs));
+        for (int r = 0; r < rows; r++)
+        {
+            vecAdd(layer.z.row(r), layer.bias.data(), layer.z.row(r), outputs);
+        }
+        if (l + ONE == _layers.size())
+        {
+            for (int r = 0; r < rows; r++)
+            {
+                vecSoftmax(layer.z.row(r), layer.a.row(r), outputs);
+            }
+        }
+        else
+        {
+            vecRelu(layer.z.data(), layer.a.data(), rows * outputs);
+        }
+        input = layer.a.view().block(ZERO, ZERO, rows, outputs);
+    }
+}
+
+/**
+ * Softmax cross entropy of the output layer, sets its delta
+ * @param labels rows labels
+ * @param rows images in the batch
+ * @param correct increased by the amount of images classified correctly
+ * @return the summed loss
+ */
+double MlpTrainer::_loss(const int *labels, int rows, int &correct)
+{
+    Layer &layer = _layers.back();
+    const int outputs = layer.w.getRows();
+    // the mean over the batch, the gradient of every image is scaled by 1 / rows
+    const float scale = FLOAT_ONE / (float) rows;
+    double loss = FLOAT_ZERO;
+    for (int r = 0; r < rows; r++)
+    {
+        const float *p = layer.a.row(r);
+        float *delta = layer.delta.row(r);
+        // log softmax straight from z, exact even where the probability underflows
+        vecLogSoftmax(layer.z.row(r), delta, outputs);
+        loss -= delta[labels[r]];
+        correct += (vecArgmax(p, outputs) == labels[r]) ? ONE : ZERO;
+        // d(cross entropy(softmax(z))) / dz = p - onehot(label)
+        vecScale(p, scale, delta, outputs);
+        delta[labels[r]] -= scale;
+    }
+    return loss;
+}
+
+/**
+ * Backward pass, the gradients of every layer from the delta of the output layer
+ * @param x rows × inputs images
+ * @param rows images in the batch
+ */
+void MlpTrainer::_backward(const ConstMatrixView &x, int rows)
+{
+    for (int l = (int) _layers.size() - ONE; l >= ZERO; l--)
+    {
+        Layer &layer = _layers[l];
+        const int outputs = layer.w.getRows();
+        const int inputs = layer.w.getCols();
+        const ConstMatrixView delta = layer.delta.view().block(ZERO, ZERO, rows, outputs);
+        const ConstMatrixView input = (l == ZERO) ? x : ConstMatrixView(_layers[l - ONE].a.view())
+                                                            .block(ZERO, ZERO, rows, inputs);
+        // dW = dZ^T * A and db = the column sums of dZ
+        gemm(delta.transposed(), input, layer.gradW.view());
+        std::fill(layer.gradBias.data(), layer.gradBias.data() + outputs, FLOAT_ZERO);
+        for (int r = 0; r < rows; r++)
+        {
+            vecAdd(layer.gradBias.data(), layer.delta.row(r), layer.gradBias.data(), outputs);
+        }
+        if (l == ZERO)
+        {
+            break;
+        }
+        // dA = dZ * W, then through the ReLU of the layer below: dZ = dA where z > 0
+        Layer &below = _layers[l - ONE];
+        gemm(delta, layer.w.view(), below.delta.view().block(ZERO, ZERO, rows, inputs));
+        float *belowDelta = below.delta.data();
+        const float *belowZ = below.z.data();
+        for (int i = 0; i < rows * inputs; i++)
+        {
+            belowDelta[i] = (belowZ[i] > FLOAT_ZERO) ? belowDelta[i] : FLOAT_ZERO;
+        }
+    }
+}
+
+/**
+ * SGD with momentum: v = momentum * v - rate * g, w += v
+ * @param w parameters
+ * @param g gradients
+ * @param velocity the velocity
+ * @param n amount of parameters
+ * @param options hyper parameters
+ */
+static void sgdUpdate(float *w, const float *g, float *velocity, int n, const TrainingOptions &options)
+{
+    for (int i = 0; i < n; i++)
+    {
+        velocity[i] = options.momentum * velocity[i] - options.learningRate * g[i];
+        w[i] += velocity[i];
+    }
+}
+
+/**
+ * Adam, with the bias corrections of both moments folded into the step size
+ * @param w parameters
+ * @param g gradients
+ * @param moment the first moments
+ * @param second the second moments
+ * @param n amount of parameters
+ * @param options hyper parameters
+ * @param stepSize rate * sqrt(1 - beta2^t) / (1 - beta1^t)
+ */
+static void adamUpdate(float *w, const float *g, float *moment, float *second, int n, const TrainingOptions &options,
+                       float stepSize)
+{
+    for (int i = 0; i < n; i++)
+    {
+        moment[i] = options.beta1 * moment[i] + (FLOAT_ONE - options.beta1) * g[i];
+        second[i] = options.beta2 * second[i] + (FLOAT_ONE - options.beta2) * g[i] * g[i];
+        w[i] -= stepSize * moment[i] / (std::sqrt(second[i]) + options.epsilon);
+    }
+}
+
+/**
+ * Applies one optimizer step to every layer
+ * @param options hyper parameters
+ */
+void MlpTrainer::_step(const TrainingOptions &options)
+{
+    _steps++;
+    const float stepSize = options.learningRate * std::sqrt(FLOAT_ONE - std::pow(options.beta2, (float) _steps)) /
+                           (FLOAT_ONE - std::pow(options.beta1, (float) _steps));
+    for (Layer &layer : _layers)
+    {
+        if (options.optimizer == Adam)
+        {
+            adamUpdate(layer.w.data(), layer.gradW.data(), layer.momentW.data(), layer.secondW.data(),
+                       layer.w.size(), options, stepSize);
+            adamUpdate(layer.bias.data(), layer.gradBias.data(), layer.momentBias.data(), layer.secondBias.data(),
+                       layer.bias.size(), options, stepSize);
+        }
+        else
+        {
+            sgdUpdate(layer.w.data(), layer.gradW.data(), layer.momentW.data(), layer.w.size(), options);
+            sgdUpdate(layer.bias.data(), layer.gradBias.data(), layer.momentBias.data(), layer.bias.size(), options);
+        }
+    }
+}
+
+/**
+ * Reads an MNIST idx1-ubyte label file, terminates when it cannot be read
+ * @param path path of the label file
+ * @return the labels
+ */
+std::vector<int> readIdxLabels(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    unsigned char header[IDX1_HEADER];
+    if (!file.read((char *) header, sizeof(header)))
+    {
+        trainingError(READ_FILE_ERROR);
+    }
+    if (bigEndian(header) != IDX1_MAGIC)
+    {
+        trainingError(LABEL_FORMAT_ERROR);
+    }
+    // the count has to match what follows the header before anything is allocated for it
+    const uint32_t count = bigEndian(header + sizeof(uint32_t));
+    const std::streampos labelsStart = file.tellg();
+    file.seekg(ZERO, std::ios::end);
+    const std::streamoff available = file.tellg() - labelsStart;
+    file.seekg(labelsStart);
+    if (!file || available != (std::streamoff) count)
+    {
+        trainingError(LABEL_FORMAT_ERROR);
+    }
+    std::vector<unsigned char> bytes(count);
+    if (!file.read((char *) bytes.data(), (std::streamsize) bytes.size()))
+    {
+        trainingError(READ_FILE_ERROR);
+    }
+    return std::vector<int>(bytes.begin(), bytes.end());
+}
@@ -0,0 +1,226 @@
+// MlpTrainer.h
+
+#ifndef MLPTRAINER_H
+#define MLPTRAINER_H
+
+#include "Dense.h"
+#include "MlpGraph.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * First word of an MNIST idx1-ubyte label file: unsigned bytes, 1 dimension.
+ */
+#define IDX1_MAGIC 0x00000801
+
+/**
+ * @enum Optimizer
+ * @brief Update rule applied to the weights after every mini-batch
+ */
+enum Optimizer
+{
+    Sgd,
+    Adam
+};
+
+/**
+ * @struct TrainingOptions
+ * @brief Hyper parameters of MlpTrainer::train
+ */
+typedef struct TrainingOptions
+{
+    Optimizer optimizer = Adam;
+    int epochs = 5;
+    int batchSize = 64;
+    float learningRate = 0.001f;
+    // Sgd only, 0 for plain SGD
+    float momentum = 0.9f;
+    // Adam only
+    float beta1 = 0.9f;
+    float beta2 = 0.999f;
+    float epsilon = 1e-8f;
+    // seed of the shuffle of every epoch
+    uint32_t seed = 1;
+} TrainingOptions;
+
+/**
+ * @struct TrainingReport
+ * @brief Progress of MlpTrainer::train, one entry per epoch
+ */
+typedef struct TrainingReport
+{
+    std::vector<float> loss;
+    std::vector<float> accuracy;
+    double seconds;
+} TrainingReport;
+
+/**
+ * Trains a chain of dense layers, ReLU on every hidden layer and softmax on the output, by mini-batch
+ * SGD or Adam on the cross entropy loss. A mini-batch runs as one row per image through the blocked
+ * GEMM kernels on strided views, forward (Z = A * W^T + b) and backward (dW = dZ^T * A, dA = dZ * W),
+ * so large batches are split across the gemm threads (see setGemmThreads). The activations of the
+ * forward pass are kept for the backward pass in buffers sized once per call of train.
+ * The trained layers are handed out as Dense layers, ready for MlpGraph or MappedModel::write.
+ */
+class MlpTrainer
+{
+public:
+    /**
+     * Constructor - a new network, He initialized weights and zero biases
+     * @param widths amount of inputs then the outputs of every layer, e.g. {784, 128, 64, 20, 10}
+     * @param seed seed of the initialization
+     */
+    MlpTrainer(const std::vector<int> &widths, uint32_t seed);
+
+    /**
+     * Constructor - continues training the layers of a graph, which are copied. The hidden layers
+     * have to be ReLU and the last one softmax.
+     * @param graph the graph
+     */
+    explicit MlpTrainer(const MlpGraph &graph);
+
+    /**
+     * getter - returns the amount of layers
+     */
+    int getLayerCount() const;
+
+    /**
+     * getter - returns the weights of layer i, outputs × inputs
+     * @param i layer index
+     */
+    const Matrix &getWeights(int i) const;
+
+    /**
+     * getter - returns the bias of layer i, outputs × 1
+     * @param i layer index
+     */
+    const Matrix &getBias(int i) const;
+
+    /**
+     * Trains on a set of labeled images, every epoch visits them in a new random order
+     * @param images pointer to count * inputs contiguous floats
+     * @param labels count labels, each in [0, outputs)
+     * @param count amount of images, positive
+     * @param options hyper parameters
+     * @return mean loss and accuracy on the mini-batches of every epoch
+     */
+    TrainingReport train(const float *images, const int *labels, int count, const TrainingOptions &options);
+
+    /**
+     * getter - returns the gradient of the loss by the weights of layer i, as left by the last
+     * mini-batch of train or by gradients
+     * @param i layer index
+     */
+    const Matrix &getWeightsGradient(int i) const;
+
+    /**
+     * getter - returns the gradient of the loss by the bias of layer i, as left by the last
+     * mini-batch of train or by gradients
+     * @param i layer index
+     */
+    const Matrix &getBiasGradient(int i) const;
+
+    /**
+     * Runs the forward and backward pass of one mini-batch without updating anything, the gradients
+     * are read with getWeightsGradient and getBiasGradient
+     * @param images pointer to count * inputs contiguous floats
+     * @param labels count labels, each in [0, outputs)
+     * @param count amount of images, positive
+     * @return the mean loss of the images
+     */
+    double gradients(const float *images, const int *labels, int count);
+
+    /**
+     * Returns the current layers as Dense layers
+     */
+    std::vector<Dense> toLayers() const;
+
+private:
+    /**
+     * Parameters, optimizer state and mini-batch buffers of one layer
+     */
+    struct Layer
+    {
+        Matrix w;
+        Matrix bias;
+        // batch × outputs: pre-activations, activations and the gradient of the loss by z
+        Matrix z;
+        Matrix a;
+        Matrix delta;
+        Matrix gradW;
+        Matrix gradBias;
+        // first and second moments (Adam) or the velocity (Sgd, first moment only)
+        Matrix momentW;
+        Matrix momentBias;
+        Matrix secondW;
+        Matrix secondBias;
+    };
+
+    std::vector<Layer> _layers;
+    int _steps;
+
+    /**
+     * Checks a layer index, terminates when it is out of range
+     * @param i layer index
+     */
+    void _checkLayer(int i) const;
+
+    /**
+     * Checks every label against the amount of outputs, terminates on the first invalid one
+     * @param labels count labels
+     * @param count amount of labels
+     */
+    void _checkLabels(const int *labels, int count) const;
+
+    /**
+     * Appends a layer with zero gradients and optimizer state
+     * @param w weights, outputs × inputs
+     * @param bias bias, outputs × 1
+     */
+    void _addLayer(Matrix w, Matrix bias);
+
+    /**
+     * Sizes the mini-batch buffers of every layer, the optimizer state is kept across calls
+     * @param batchSize rows of the buffers
+     */
+    void _prepare(int batchSize);
+
+    /**
+     * Forward pass of rows images, keeps z and a of every layer
+     * @param x rows × inputs images
+     * @param rows images in the batch
+     */
+    void _forward(const ConstMatrixView &x, int rows);
+
+    /**
+     * Softmax cross entropy of the output layer, sets its delta
+     * @param labels rows labels
+     * @param rows images in the batch
+     * @param correct increased by the amount of images classified correctly
+     * @return the summed loss
+     */
+    double _loss(const int *labels, int rows, int &correct);
+
+    /**
+     * Backward pass, the gradients of every layer from the delta of the output layer
+     * @param x rows × inputs images
+     * @param rows images in the batch
+     */
+    void _backward(const ConstMatrixView &x, int rows);
+
+    /**
+     * Applies one optimizer step to every layer
+     * @param options hyper parameters
+     */
+    void _step(const TrainingOptions &options);
+};
+
+/**
+ * Reads an MNIST idx1-ubyte label file, terminates when it cannot be read
+ * @param path path of the label file
+ * @return the labels
+ */
+std::vector<int> readIdxLabels(const std::string &path);
+
+#endif //MLPTRAINER_H
@@ -0,0 +1,214 @@
+#include "QuantizedDense.h"
+#include "VectorOps.h"
+#include <cmath>
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define QUANTIZED_X86 1
+#include <immintrin.h>
+#endif
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define INT8_LIMIT 127
+#define FLOAT_ZERO 0.0f
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Symmetric scale mapping [-max|v|, max|v|] onto [-127, 127]
+ * @param v values
+ * @param n amount of values
+ * @return the scale, 1 for an all zero input
+ */
+static float symmetricScale(const float *v, int n)
+{
+    float maxAbs = FLOAT_ZERO;
+    for (int i = 0; i < n; i++)
+    {
+        maxAbs = std::fmax(maxAbs, std::fabs(v[i]));
+    }
+    return (maxAbs > FLOAT_ZERO) ? maxAbs / INT8_LIMIT : ONE;
+}
+
+/**
+ * Quantizes n floats to int8 with round to nearest
+ * @param v values
+ * @param scale quantization scale
+ * @param q destination
+ * @param n amount of values
+ */
+static void quantize(const float *v, float scale, int8_t *q, int n)
+{
+    const float inverse = ONE / scale;
+    for (int i = 0; i < n; i++)
+    {
+        long rounded = std::lrint(v[i] * inverse);
+        rounded = (rounded > INT8_LIMIT) ? INT8_LIMIT : rounded;
+        rounded = (rounded < -INT8_LIMIT) ? -INT8_LIMIT : rounded;
+        q[i] = (int8_t) rounded;
+    }
+}
+
+static int32_t scalarDotInt8(const int8_t *a, const int8_t *b, int n)
+{
+    int32_t sum = ZERO;
+    for (int i = 0; i < n; i++)
+    {
+        sum += (int32_t) a[i] * (int32_t) b[i];
+    }
+    return sum;
+}
+
+#ifdef QUANTIZED_X86
+
+__attribute__((target("avx2"))) static int32_t avx2DotInt8(const int8_t *a, const int8_t *b, int n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half) + scalarDotInt8(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) static int32_t vnniDotInt8(const int8_t *a,
+                                                                                  const int8_t *b, int n)
+{
+    __m512i acc = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m512i va = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *) (a + i)));
+        __m512i vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *) (b + i)));
+        acc = _mm512_dpwssd_epi32(acc, va, vb);
+    }
+    int32_t lanes[16];
+    _mm512_storeu_si512(lanes, acc);
+    int32_t sum = scalarDotInt8(a + i, b + i, n - i);
+    for (int32_t lane : lanes)
+    {
+        sum += lane;
+    }
+    return sum;
+}
+
+#endif //QUANTIZED_X86
+
+/**
+ * Queries cpuid and picks the widest supported int8 dot product
+ * @return the kernel
+ */
+static int32_t (*selectDot())(const int8_t *, const int8_t *, int)
+{
+#ifdef QUANTIZED_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw"))
+    {
+        return vnniDotInt8;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return avx2DotInt8;
+    }
+#endif
+    return scalarDotInt8;
+}
+
+/**
+ * Dot product of two int8 vectors with int32 accumulation, dispatched to AVX-512 VNNI, AVX2 or
+ * scalar code at runtime. All variants give the same exact result.
+ * @param a first vector
+ * @param b second vector
+ * @param n amount of elements
+ * @return the dot product
+ */
+int32_t dotInt8(const int8_t *a, const int8_t *b, int n)
+{
+    static int32_t (*const dot)(const int8_t *, const int8_t *, int) = selectDot();
+    return dot(a, b, n);
+}
+
+/**
+ * Constructor - calibrates the weight scale and quantizes the weights of a float layer
+ * @param dense the float layer
+ */
+QuantizedDense::QuantizedDense(const Dense &dense) : _rowsNum(dense.getWeights().getRows()),
+                                                     _colsNum(dense.getWeights().getCols()),
+                                                     _weightScale(symmetricScale(dense.getWeights().data(),
+                                                                                 dense.getWeights().size())),
+                                                     _w(dense.getWeights().size()),
+                                                     _bias(dense.getBias().data(),
+                                                           dense.getBias().data() + dense.getBias().size()),
+                                                     _activationType(dense.getActivation().getActivationType())
+{
+    quantize(dense.getWeights().data(), _weightScale, _w.data(), dense.getWeights().size());
+}
+
+/**
+ * getter - returns the scale of the weights, w ≈ scale * q
+ */
+float QuantizedDense::getWeightScale() const
+{
+    return _weightScale;
+}
+
+/**
+ * getter - returns the amount of output rows
+ */
+int QuantizedDense::getRows() const
+{
+    return _rowsNum;
+}
+
+/**
+ * getter - returns the amount of input cols
+ */
+int QuantizedDense::getCols() const
+{
+    return _colsNum;
+}
+
+/**
+ * Applies the layer on a single input vector
+ * @param x pointer to getCols() floats
+ * @param y pointer to getRows() floats, overwritten with the activated outputs
+ */
+void QuantizedDense::apply(const float *x, float *y) const
+{
+    static thread_local std::vector<int8_t> quantizedX;
+    quantizedX.resize(_colsNum);
+    const float inputScale = symmetricScale(x, _colsNum);
+    quantize(x, inputScale, quantizedX.data(), _colsNum);
+
+    const float outputScale = _weightScale * inputScale;
+    for (int i = 0; i < _rowsNum; i++)
+    {
+        int32_t dot = dotInt8(_w.data() + i * _colsNum, quantizedX.data(), _colsNum);
+        float z = (float) dot * outputScale + _bias[i];
+        y[i] = (_activationType == Relu && z < FLOAT_ZERO) ? FLOAT_ZERO : z;
+    }
+    if (_activationType == Softmax)
+    {
+        vecSoftmax(y, y, _rowsNum);
+    }
+}
+
+/**
+ * Parenthesis operator - Applies the layer on a single input vector
+ * @param m matrix of getCols() × 1
+ * @return result matrix of getRows() × 1
+ */
+Matrix QuantizedDense::operator()(const Matrix &m) const
+{
+    if (m.getRows() != _colsNum || m.getCols() != ONE)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    Matrix result = Matrix(_rowsNum, ONE);
+    apply(m.data(), result.data());
+    return result;
+}
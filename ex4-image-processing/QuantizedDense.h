@@ -0,0 +1,72 @@
+// QuantizedDense.h
+
+#ifndef QUANTIZEDDENSE_H
+#define QUANTIZEDDENSE_H
+
+#include "Dense.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * An int8 copy of a Dense layer. The weights are quantized once with a symmetric per-layer scale,
+ * the input vector is quantized on every call with its own scale, the dot products accumulate in
+ * int32 and the result is dequantized before the bias and the activation.
+ */
+class QuantizedDense
+{
+public:
+    /**
+     * Constructor - calibrates the weight scale and quantizes the weights of a float layer
+     * @param dense the float layer
+     */
+    explicit QuantizedDense(const Dense &dense);
+
+    /**
+     * getter - returns the scale of the weights, w ≈ scale * q
+     */
+    float getWeightScale() const;
+
+    /**
+     * getter - returns the amount of output rows
+     */
+    int getRows() const;
+
+    /**
+     * getter - returns the amount of input cols
+     */
+    int getCols() const;
+
+    /**
+     * Applies the layer on a single input vector
+     * @param x pointer to getCols() floats
+     * @param y pointer to getRows() floats, overwritten with the activated outputs
+     */
+    void apply(const float *x, float *y) const;
+
+    /**
+     * Parenthesis operator - Applies the layer on a single input vector
+     * @param m matrix of getCols() × 1
+     * @return result matrix of getRows() × 1
+     */
+    Matrix operator()(const Matrix &m) const;
+
+private:
+    int _rowsNum;
+    int _colsNum;
+    float _weightScale;
+    std::vector<int8_t> _w;
+    std::vector<float> _bias;
+    ActivationType _activationType;
+};
+
+/**
+ * Dot product of two int8 vectors with int32 accumulation, dispatched to AVX-512 VNNI, AVX2 or
+ * scalar code at runtime. All variants give the same exact result.
+ * @param a first vector
+ * @param b second vector
+ * @param n amount of elements
+ * @return the dot product
+ */
+int32_t dotInt8(const int8_t *a, const int8_t *b, int n);
+
+#endif //QUANTIZEDDENSE_H
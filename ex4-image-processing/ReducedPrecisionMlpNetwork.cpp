@@ -0,0 +1,103 @@
+#include "ReducedPrecisionMlpNetwork.h"
+#include <algorithm>
+#include <cmath>
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define FLOAT_ZERO 0.0f
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Parenthesis operator - Applies the entire network on input
+ * @param img - matrix
+ * @return digit struct
+ */
+template<class Layer>
+Digit ReducedPrecisionMlpNetwork<Layer>::operator()(const Matrix &img) const
+{
+    if (img.size() != _layers.front().getCols())
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return _classifyOne(img.data());
+}
+
+/**
+ * Applies the entire network on images stored one after the other
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images
+ * @return digit struct of every image, in order
+ */
+template<class Layer>
+std::vector<Digit> ReducedPrecisionMlpNetwork<Layer>::classify(const float *images, int count) const
+{
+    const int imgSize = _layers.front().getCols();
+    std::vector<Digit> digits;
+    digits.reserve(count);
+    for (int j = 0; j < count; j++)
+    {
+        digits.push_back(_classifyOne(images + j * imgSize));
+    }
+    return digits;
+}
+
+/**
+ * Classifies images with both networks and compares the results
+ * @param network the float network
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images, none gives an empty report
+ * @return the accuracy report
+ */
+template<class Layer>
+QuantizationReport ReducedPrecisionMlpNetwork<Layer>::compareWith(const MlpNetwork &network, const float *images,
+                                                                  int count) const
+{
+    QuantizationReport report{count, ZERO, FLOAT_ZERO, FLOAT_ZERO};
+    if (count <= ZERO)
+    {
+        // the float network rejects an empty batch, there is nothing to compare
+        report.images = ZERO;
+        return report;
+    }
+    std::vector<Digit> expected = network.classify(images, count);
+    std::vector<Digit> actual = classify(images, count);
+    double errorSum = ZERO;
+    for (int j = 0; j < count; j++)
+    {
+        if (expected[j].value == actual[j].value)
+        {
+            report.agreeing++;
+        }
+        float error = std::fabs(expected[j].probability - actual[j].probability);
+        report.maxProbabilityError = std::max(report.maxProbabilityError, error);
+        errorSum += error;
+    }
+    report.meanProbabilityError = (float) (errorSum / count);
+    return report;
+}
+
+/**
+ * Applies all layers on a single image
+ * @param img pointer to imgDims.rows * imgDims.cols floats
+ * @return digit struct
+ */
+template<class Layer>
+Digit ReducedPrecisionMlpNetwork<Layer>::_classifyOne(const float *img) const
+{
+    static thread_local std::vector<float> ping;
+    static thread_local std::vector<float> pong;
+    ping.resize(_maxWidth);
+    pong.resize(_maxWidth);
+    const float *input = img;
+    float *output = ping.data();
+    for (const Layer &layer : _layers)
+    {
+        layer.apply(input, output);
+        input = output;
+        output = (output == ping.data()) ? pong.data() : ping.data();
+    }
+    return MlpNetwork::toDigit(input, _layers.back().getRows(), ONE);
+}
+
+template class ReducedPrecisionMlpNetwork<QuantizedDense>;
+template class ReducedPrecisionMlpNetwork<HalfDense>;
@@ -0,0 +1,100 @@
+// ReducedPrecisionMlpNetwork.h
+
+#ifndef REDUCEDPRECISIONMLPNETWORK_H
+#define REDUCEDPRECISIONMLPNETWORK_H
+
+#include "MlpNetwork.h"
+#include "HalfDense.h"
+#include "QuantizedDense.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @struct QuantizationReport
+ * @brief Accuracy of a reduced precision (int8 or 16 bit) network measured against the float network
+ * it was built from
+ */
+typedef struct QuantizationReport
+{
+    int images;
+    int agreeing;
+    float maxProbabilityError;
+    float meanProbabilityError;
+} QuantizationReport;
+
+/**
+ * A copy of a MlpNetwork with every layer converted to a reduced precision Layer. A Layer is built
+ * from a Dense (and any further constructor arguments) and provides getRows(), getCols() and
+ * apply(x, y). Instantiated for QuantizedDense and HalfDense, see the typedefs below.
+ */
+template<class Layer>
+class ReducedPrecisionMlpNetwork
+{
+public:
+    /**
+     * Constructor - converts every layer of a float network
+     * @param network the float network
+     * @param layerArgs passed on to the constructor of every Layer after the Dense
+     */
+    template<class... Args>
+    explicit ReducedPrecisionMlpNetwork(const MlpNetwork &network, Args... layerArgs) : _maxWidth(0)
+    {
+        for (int i = 0; i < network.getLayerCount(); i++)
+        {
+            _layers.emplace_back(network.getLayer(i), layerArgs...);
+            _maxWidth = std::max(_maxWidth, std::max(_layers.back().getRows(), _layers.back().getCols()));
+        }
+    }
+
+    /**
+     * Parenthesis operator - Applies the entire network on input
+     * @param img - matrix
+     * @return digit struct
+     */
+    Digit operator()(const Matrix &img) const;
+
+    /**
+     * Applies the entire network on images stored one after the other
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images
+     * @return digit struct of every image, in order
+     */
+    std::vector<Digit> classify(const float *images, int count) const;
+
+    /**
+     * Classifies images with both networks and compares the results
+     * @param network the float network
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images, none gives an empty report
+     * @return the accuracy report
+     */
+    QuantizationReport compareWith(const MlpNetwork &network, const float *images, int count) const;
+
+private:
+    std::vector<Layer> _layers;
+    int _maxWidth;
+
+    /**
+     * Applies all layers on a single image
+     * @param img pointer to imgDims.rows * imgDims.cols floats
+     * @return digit struct
+     */
+    Digit _classifyOne(const float *img) const;
+};
+
+/**
+ * An int8 copy of a MlpNetwork, a quarter of the weight bytes of the float network
+ */
+typedef ReducedPrecisionMlpNetwork<QuantizedDense> QuantizedMlpNetwork;
+
+/**
+ * A copy of a MlpNetwork with fp16 or bf16 weights, half the weight bytes of the float network. The
+ * constructor takes the HalfFormat after the network.
+ */
+typedef ReducedPrecisionMlpNetwork<HalfDense> HalfMlpNetwork;
+
+// the members are compiled once in ReducedPrecisionMlpNetwork.cpp for the two layers
+extern template class ReducedPrecisionMlpNetwork<QuantizedDense>;
+extern template class ReducedPrecisionMlpNetwork<HalfDense>;
+
+#endif //REDUCEDPRECISIONMLPNETWORK_H
@@ -0,0 +1,113 @@
+#include "SparseMatrix.h"
+#include "VectorOps.h"
+#include <algorithm>
+#define ZERO 0
+#define FLOAT_ZERO 0.0f
+
+/**
+ * Constructs an empty 0 × 0 matrix
+ */
+SparseMatrix::SparseMatrix() : _rowsNum(ZERO), _colsNum(ZERO), _rowStart(1, ZERO)
+{
+}
+
+/**
+ * Constructs the compressed form of a dense matrix, zeros are dropped
+ * @param m matrix
+ */
+SparseMatrix::SparseMatrix(const Matrix &m) : _rowsNum(m.getRows()), _colsNum(m.getCols())
+{
+    _rowStart.reserve((size_t) _rowsNum + 1);
+    _rowStart.push_back(ZERO);
+    for (int i = 0; i < _rowsNum; i++)
+    {
+        const float *row = m.row(i);
+        for (int j = 0; j < _colsNum; j++)
+        {
+            if (row[j] != FLOAT_ZERO)
+            {
+                _colIndex.push_back(j);
+                _values.push_back(row[j]);
+            }
+        }
+        _rowStart.push_back((int) _values.size());
+    }
+}
+
+/**
+ * getter - returns the amount of rows as int
+ */
+int SparseMatrix::getRows() const
+{
+    return _rowsNum;
+}
+
+/**
+ * getter - returns the amount of cols as int
+ */
+int SparseMatrix::getCols() const
+{
+    return _colsNum;
+}
+
+/**
+ * getter - returns the amount of stored elements
+ */
+int SparseMatrix::getNonZeros() const
+{
+    return (int) _values.size();
+}
+
+/**
+ * Fraction of the elements of a matrix that are not zero
+ * @param m matrix
+ * @return a number in [0, 1]
+ */
+float SparseMatrix::density(const Matrix &m)
+{
+    const float *data = m.data();
+    long zeros = std::count(data, data + m.size(), FLOAT_ZERO);
+    return (float) (m.size() - zeros) / (float) m.size();
+}
+
+/**
+ * Fused sparse dense layer kernel y = act(S * x + bias) over the rows [first, last)
+ * @param first first row
+ * @param last one past the last row
+ * @param x pointer to getCols() contiguous floats
+ * @param bias pointer to getRows() contiguous biases, indexed by row, may be nullptr
+ * @param y pointer to getRows() contiguous outputs, indexed by row, rows [first, last) are overwritten
+ * @param act function applied to every output
+ */
+void SparseMatrix::gemvBiasAct(int first, int last, const float *x, const float *bias, float *y,
+                               GemvActivation act) const
+{
+    for (int i = first; i < last; i++)
+    {
+        const int start = _rowStart[i];
+        float z = vecSparseDot(_values.data() + start, _colIndex.data() + start, x, _rowStart[i + 1] - start);
+        z = (bias != nullptr) ? z + bias[i] : z;
+        y[i] = (act == GemvRelu && z < FLOAT_ZERO) ? FLOAT_ZERO : z;
+    }
+}
+
+/**
+ * Row major product C = S * B, every stored element adds a scaled row of B to a row of C
+ * @param n cols of B and C
+ * @param b pointer to B, getCols() rows
+ * @param ldb distance between two rows of B
+ * @param c pointer to C, getRows() rows, overwritten
+ * @param ldc distance between two rows of C
+ */
+void SparseMatrix::gemm(int n, const float *b, int ldb, float *c, int ldc) const
+{
+    for (int i = 0; i < _rowsNum; i++)
+    {
+        float *row = c + (size_t) i * ldc;
+        std::fill(row, row + n, FLOAT_ZERO);
+        for (int p = _rowStart[i]; p < _rowStart[i + 1]; p++)
+        {
+            vecScaleAdd(b + (size_t) _colIndex[p] * ldb, _values[p], row, row, n);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// SparseMatrix.h
+
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include "Matrix.h"
+#include "Gemm.h"
+#include <vector>
+
+/**
+ * A read only matrix in compressed sparse row form: the nonzero elements of every row in column
+ * order, their column indices, and where every row starts. Meant for pruned layers, the products
+ * skip the zero weights entirely.
+ */
+class SparseMatrix
+{
+public:
+    /**
+     * Constructs an empty 0 × 0 matrix
+     */
+    SparseMatrix();
+
+    /**
+     * Constructs the compressed form of a dense matrix, zeros are dropped
+     * @param m matrix
+     */
+    explicit SparseMatrix(const Matrix &m);
+
+    /**
+     * getter - returns the amount of rows as int
+     */
+    int getRows() const;
+
+    /**
+     * getter - returns the amount of cols as int
+     */
+    int getCols() const;
+
+    /**
+     * getter - returns the amount of stored elements
+     */
+    int getNonZeros() const;
+
+    /**
+     * Fraction of the elements of a matrix that are not zero
+     * @param m matrix
+     * @return a number in [0, 1]
+     */
+    static float density(const Matrix &m);
+
+    /**
+     * Fused sparse dense layer kernel y = act(S * x + bias) over the rows [first, last)
+     * @param first first row
+     * @param last one past the last row
+     * @param x pointer to getCols() contiguous floats
+     * @param bias pointer to getRows() contiguous biases, indexed by row, may be nullptr
+     * @param y pointer to getRows() contiguous outputs, indexed by row, rows [first, last) are overwritten
+     * @param act function applied to every output
+     */
+    void gemvBiasAct(int first, int last, const float *x, const float *bias, float *y, GemvActivation act) const;
+
+    /**
+     * Row major product C = S * B, every stored element adds a scaled row of B to a row of C
+     * @param n cols of B and C
+     * @param b pointer to B, getCols() rows
+     * @param ldb distance between two rows of B
+     * @param c pointer to C, getRows() rows, overwritten
+     * @param ldc distance between two rows of C
+     */
+    void gemm(int n, const float *b, int ldb, float *c, int ldc) const;
+
+private:
+    int _rowsNum;
+    int _colsNum;
+    std::vector<int> _rowStart;
+    std::vector<int> _colIndex;
+    std::vector<float> _values;
+};
+
+#endif //SPARSEMATRIX_H
@@ -0,0 +1,156 @@
+// StaticDense.h
+
+#ifndef STATICDENSE_H
+#define STATICDENSE_H
+
+#include "Dense.h"
+#include "StaticMatrix.h"
+#include "VectorOps.h"
+#include <cstring>
+#include <memory>
+
+/*
+ * Register tile of StaticDense::apply, STATIC_DENSE_TILE vectors of STATIC_DENSE_LANES outputs are
+ * accumulated over the whole input before they are stored. Vectors wider than the target's registers
+ * are lowered through memory by gcc, so the lanes follow the instruction set the build targets.
+ */
+#ifdef __AVX__
+#define STATIC_DENSE_LANES 8
+#define STATIC_DENSE_TILE 4
+#else
+#define STATIC_DENSE_LANES 4
+#define STATIC_DENSE_TILE 8
+#endif
+
+/**
+ * A dense layer of In inputs and Out outputs fixed at compile time. The weights are kept transposed
+ * on the heap, one row of Out weights per input padded with zeros to whole vectors, so the layer is a
+ * sum of In scaled weight rows into register accumulators. Every output is summed in input order.
+ */
+template<int In, int Out, ActivationType Act>
+class StaticDense
+{
+public:
+    /**
+     * Constructor - copies a Dense layer of the same shape and activation, terminates otherwise
+     * @param dense the layer
+     */
+    explicit StaticDense(const Dense& dense);
+
+    /**
+     * Applies the layer on a single input vector
+     * @param x pointer to In floats
+     * @param y pointer to Out floats, overwritten with the activated outputs
+     */
+    void apply(const float* x, float* y) const;
+
+    /**
+     * Parenthesis operator - Applies the layer on a single input vector
+     * @param x input vector
+     * @return output vector
+     */
+    StaticMatrix<Out, 1> operator()(const StaticMatrix<In, 1>& x) const;
+
+private:
+    static constexpr int _padded = (Out + STATIC_DENSE_LANES - 1) / STATIC_DENSE_LANES * STATIC_DENSE_LANES;
+
+    std::unique_ptr<StaticMatrix<In, _padded>> _weights;
+    StaticMatrix<Out, 1> _bias;
+};
+
+template<int In, int Out, ActivationType Act>
+StaticDense<In, Out, Act>::StaticDense(const Dense& dense) : _weights(new StaticMatrix<In, _padded>())
+{
+    const Matrix& w = dense.getWeights();
+    if(w.getRows() != Out || w.getCols() != In || dense.getBias().size() != Out ||
+       dense.getActivation().getActivationType() != Act)
+    {
+        staticDimError();
+    }
+    for(int j = 0; j < In; j++)
+    {
+        for(int i = 0; i < _padded; i++)
+        {
+            (*_weights)(j, i) = (i < Out) ? w.row(i)[j] : 0.0f;
+        }
+    }
+    for(int i = 0; i < Out; i++)
+    {
+        _bias[i] = dense.getBias().data()[i];
+    }
+}
+
+template<int In, int Out, ActivationType Act>
+void StaticDense<In, Out, Act>::apply(const float* x, float* y) const
+{
+    float acc[_padded];
+    const float* w = _weights->data();
+#if defined(__GNUC__) || defined(__clang__)
+    typedef float StaticLane __attribute__((vector_size(STATIC_DENSE_LANES * sizeof(float))));
+    const int tiled = _padded - _padded % (STATIC_DENSE_LANES * STATIC_DENSE_TILE);
+    for(int t = 0; t < tiled; t += STATIC_DENSE_LANES * STATIC_DENSE_TILE)
+    {
+        StaticLane sums[STATIC_DENSE_TILE] = {};
+        for(int j = 0; j < In; j++)
+        {
+            const float* row = w + j * _padded + t;
+#pragma GCC unroll 4
+            for(int v = 0; v < STATIC_DENSE_TILE; v++)
+            {
+                StaticLane lane;
+                std::memcpy(&lane, row + v * STATIC_DENSE_LANES, sizeof(lane));
+                sums[v] += lane * x[j];
+            }
+        }
+        std::memcpy(acc + t, sums, sizeof(sums));
+    }
+    // the outputs left after the whole tiles, one vector at a time
+    for(int t = tiled; t < _padded; t += STATIC_DENSE_LANES)
+    {
+        StaticLane sum = {};
+        for(int j = 0; j < In; j++)
+        {
+            StaticLane lane;
+            std::memcpy(&lane, w + j * _padded + t, sizeof(lane));
+            sum += lane * x[j];
+        }
+        std::memcpy(acc + t, &sum, sizeof(sum));
+    }
+#else
+    for(int i = 0; i < _padded; i++)
+    {
+        acc[i] = 0.0f;
+    }
+    for(int j = 0; j < In; j++)
+    {
+        const float* row = w + j * _padded;
+        for(int i = 0; i < _padded; i++)
+        {
+            acc[i] += row[i] * x[j];
+        }
+    }
+#endif
+    for(int i = 0; i < Out; i++)
+    {
+        acc[i] += _bias[i];
+    }
+    if(Act == Softmax)
+    {
+        vecSoftmax(acc, y, Out);
+        return;
+    }
+    for(int i = 0; i < Out; i++)
+    {
+        y[i] = (acc[i] < 0.0f) ? 0.0f : acc[i];
+    }
+}
+
+template<int In, int Out, ActivationType Act>
+StaticMatrix<Out, 1> StaticDense<In, Out, Act>::operator()(const StaticMatrix<In, 1>& x) const
+{
+    StaticMatrix<Out, 1> y;
+    apply(x.data(), y.data());
+    return y;
+}
+
+#endif //STATICDENSE_H
@@ -0,0 +1,21 @@
+#include "StaticMatrix.h"
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define OUTOFBOUND_ERROR "Error: index out of bound"
+
+/**
+ * Reports an out of bound index of a StaticMatrix and terminates
+ */
+void staticOutOfBound()
+{
+    std::cerr << OUTOFBOUND_ERROR << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Reports a layer that does not match the compile time shape it is loaded into and terminates
+ */
+void staticDimError()
+{
+    std::cerr << DIM_ERROR_MSG << std::endl;
+    exit(EXIT_FAILURE);
+}
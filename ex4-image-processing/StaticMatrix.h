@@ -0,0 +1,168 @@
+// StaticMatrix.h
+
+#ifndef STATICMATRIX_H
+#define STATICMATRIX_H
+
+#include "Matrix.h"
+
+/**
+ * Reports an out of bound index of a StaticMatrix and terminates
+ */
+void staticOutOfBound();
+
+/**
+ * Reports a layer that does not match the compile time shape it is loaded into and terminates
+ */
+void staticDimError();
+
+/**
+ * A matrix whose dimensions are compile time constants. The elements are stored inside the object,
+ * so a local StaticMatrix lives on the stack and needs no allocation, and every loop over it has a
+ * constant trip count the compiler can unroll and vectorize.
+ */
+template<int R, int C>
+class StaticMatrix
+{
+    static_assert(R > 0 && C > 0, "a StaticMatrix needs positive dimensions");
+
+public:
+    static constexpr int rows = R;
+    static constexpr int cols = C;
+    static constexpr int size = R * C;
+
+    /**
+     * Constructs R × C matrix, the elements are left uninitialized like a plain array
+     */
+    StaticMatrix() = default;
+
+    /**
+     * Parenthesis indexing
+     * @param i row index
+     * @param j col index
+     * @return reference to the element
+     */
+    float& operator()(int i, int j);
+
+    /**
+     * Parenthesis indexing for const matrices
+     * @param i row index
+     * @param j col index
+     * @return the element
+     */
+    float operator()(int i, int j) const;
+
+    /**
+     * Brackets indexing, row major order
+     * @param i index in matrix
+     * @return reference to the element
+     */
+    float& operator[](int i);
+
+    /**
+     * Brackets indexing for const matrices, row major order
+     * @param i index in matrix
+     * @return the element
+     */
+    float operator[](int i) const;
+
+    /**
+     * Returns a pointer to the first element, elements are stored row after row
+     */
+    float* data();
+
+    /**
+     * Returns a pointer to the first element, elements are stored row after row
+     */
+    const float* data() const;
+
+    /**
+     * Heap allocation from defaultMatrixPool(), which honors the alignment of the elements that
+     * plain new ignores before C++17
+     * @param bytes size of the object
+     */
+    static void* operator new(size_t bytes);
+
+    /**
+     * Returns an object allocated with operator new to defaultMatrixPool()
+     * @param p the object
+     * @param bytes size of the object
+     */
+    static void operator delete(void* p, size_t bytes);
+
+private:
+    alignas(MATRIX_ALIGNMENT) float _matrix[R * C];
+};
+
+template<int R, int C>
+inline float& StaticMatrix<R, C>::operator()(int i, int j)
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= R || j >= C || i < 0 || j < 0)
+    {
+        staticOutOfBound();
+    }
+#endif
+    return _matrix[i * C + j];
+}
+
+template<int R, int C>
+inline float StaticMatrix<R, C>::operator()(int i, int j) const
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= R || j >= C || i < 0 || j < 0)
+    {
+        staticOutOfBound();
+    }
+#endif
+    return _matrix[i * C + j];
+}
+
+template<int R, int C>
+inline float& StaticMatrix<R, C>::operator[](int i)
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= R * C || i < 0)
+    {
+        staticOutOfBound();
+    }
+#endif
+    return _matrix[i];
+}
+
+template<int R, int C>
+inline float StaticMatrix<R, C>::operator[](int i) const
+{
+#if MATRIX_BOUNDS_CHECK
+    if(i >= R * C || i < 0)
+    {
+        staticOutOfBound();
+    }
+#endif
+    return _matrix[i];
+}
+
+template<int R, int C>
+inline float* StaticMatrix<R, C>::data()
+{
+    return _matrix;
+}
+
+template<int R, int C>
+inline const float* StaticMatrix<R, C>::data() const
+{
+    return _matrix;
+}
+
+template<int R, int C>
+void* StaticMatrix<R, C>::operator new(size_t bytes)
+{
+    return defaultMatrixPool().allocate(bytes / sizeof(float));
+}
+
+template<int R, int C>
+void StaticMatrix<R, C>::operator delete(void* p, size_t bytes)
+{
+    defaultMatrixPool().deallocate(static_cast<float*>(p), bytes / sizeof(float));
+}
+
+#endif //STATICMATRIX_H
@@ -0,0 +1,71 @@
+#include "StaticMlpNetwork.h"
+#define DIM_ERROR_MSG "Error: invalid dimensions"
+#define ONE 1
+#define ZERO 0
+#define TWO 2
+#define THREE 3
+
+static_assert(MLP_SIZE == 4, "StaticMlpNetwork has one member per layer of weightsDims");
+static_assert(weightsDims[0].cols == imgDims.rows * imgDims.cols, "the first layer reads a whole image");
+
+/**
+ * Constructor - copies every layer of a network shaped like weightsDims, terminates otherwise
+ * @param network the network
+ */
+StaticMlpNetwork::StaticMlpNetwork(const MlpNetwork &network) : _firstDense(network.getLayer(ZERO)),
+                                                                _secondDense(network.getLayer(ONE)),
+                                                                _thirdDense(network.getLayer(TWO)),
+                                                                _fourthDense(network.getLayer(THREE))
+{
+}
+
+/**
+ * Parenthesis operator - Applies the entire network on input
+ * @param img - matrix
+ * @return digit struct
+ */
+Digit StaticMlpNetwork::operator()(const Matrix &img) const
+{
+    if (img.size() != imgDims.rows * imgDims.cols)
+    {
+        std::cerr << DIM_ERROR_MSG << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return _classifyOne(img.data());
+}
+
+/**
+ * Applies the entire network on images stored one after the other
+ * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+ * @param count amount of images
+ * @return digit struct of every image, in order
+ */
+std::vector<Digit> StaticMlpNetwork::classify(const float *images, int count) const
+{
+    const int imgSize = imgDims.rows * imgDims.cols;
+    std::vector<Digit> digits;
+    digits.reserve(count);
+    for (int j = 0; j < count; j++)
+    {
+        digits.push_back(_classifyOne(images + j * imgSize));
+    }
+    return digits;
+}
+
+/**
+ * Applies all layers on a single image
+ * @param img pointer to imgDims.rows * imgDims.cols floats
+ * @return digit struct
+ */
+Digit StaticMlpNetwork::_classifyOne(const float *img) const
+{
+    StaticMatrix<weightsDims[0].rows, 1> activateFirstDense;
+    StaticMatrix<weightsDims[1].rows, 1> activateSecondDense;
+    StaticMatrix<weightsDims[2].rows, 1> activateThirdDense;
+    StaticMatrix<weightsDims[3].rows, 1> result;
+    _firstDense.apply(img, activateFirstDense.data());
+    _secondDense.apply(activateFirstDense.data(), activateSecondDense.data());
+    _thirdDense.apply(activateSecondDense.data(), activateThirdDense.data());
+    _fourthDense.apply(activateThirdDense.data(), result.data());
+    return MlpNetwork::toDigit(result.data(), result.rows, ONE);
+}
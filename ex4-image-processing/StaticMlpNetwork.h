@@ -0,0 +1,53 @@
+// StaticMlpNetwork.h
+
+#ifndef STATICMLPNETWORK_H
+#define STATICMLPNETWORK_H
+
+#include "MlpNetwork.h"
+#include "StaticDense.h"
+#include <vector>
+
+/**
+ * A copy of a MlpNetwork specialized for the layer shapes of weightsDims. Every layer is a
+ * StaticDense and the activations between layers are StaticMatrix locals on the stack, classifying
+ * an image allocates nothing.
+ */
+class StaticMlpNetwork
+{
+public:
+    /**
+     * Constructor - copies every layer of a network shaped like weightsDims, terminates otherwise
+     * @param network the network
+     */
+    explicit StaticMlpNetwork(const MlpNetwork &network);
+
+    /**
+     * Parenthesis operator - Applies the entire network on input
+     * @param img - matrix
+     * @return digit struct
+     */
+    Digit operator()(const Matrix &img) const;
+
+    /**
+     * Applies the entire network on images stored one after the other
+     * @param images pointer to count * imgDims.rows * imgDims.cols contiguous floats
+     * @param count amount of images
+     * @return digit struct of every image, in order
+     */
+    std::vector<Digit> classify(const float *images, int count) const;
+
+private:
+    StaticDense<weightsDims[0].cols, weightsDims[0].rows, Relu> _firstDense;
+    StaticDense<weightsDims[1].cols, weightsDims[1].rows, Relu> _secondDense;
+    StaticDense<weightsDims[2].cols, weightsDims[2].rows, Relu> _thirdDense;
+    StaticDense<weightsDims[3].cols, weightsDims[3].rows, Softmax> _fourthDense;
+
+    /**
+     * Applies all layers on a single image
+     * @param img pointer to imgDims.rows * imgDims.cols floats
+     * @return digit struct
+     */
+    Digit _classifyOne(const float *img) const;
+};
+
+#endif //STATICMLPNETWORK_H
@@ -0,0 +1,212 @@
+#include "ThreadPool.h"
+#define ONE 1
+#define ZERO 0
+
+/**
+ * Depth of parallelFor chunks the current thread is running
+ */
+static thread_local int taskDepth = ZERO;
+
+/**
+ * The pool the current thread is a worker of and the index of its deque there
+ */
+static thread_local const ThreadPool *workerPool = nullptr;
+static thread_local int workerIndex = ZERO;
+
+/**
+ * Constructor - starts the worker threads
+ * @param threads amount of threads working on a range including the caller, 0 for one per core
+ */
+ThreadPool::ThreadPool(int threads) : _queued(ZERO), _stopping(false)
+{
+    if (threads <= ZERO)
+    {
+        threads = (int) std::thread::hardware_concurrency();
+        threads = (threads <= ZERO) ? ONE : threads;
+    }
+    // the caller of parallelFor is the last thread, it works on the shared deque number 0
+    for (int i = 0; i < threads; i++)
+    {
+        _queues.emplace_back(new WorkQueue());
+    }
+    for (int i = ONE; i < threads; i++)
+    {
+        _workers.emplace_back(&ThreadPool::_workerLoop, this, i);
+    }
+}
+
+/**
+ * destructor, finishes the queued tasks and joins the workers
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_sleepLock);
+        _stopping = true;
+    }
+    _wakeUp.notify_all();
+    for (std::thread &worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * getter - returns the amount of threads working on a range, including the caller
+ */
+int ThreadPool::getThreadCount() const
+{
+    return (int) _queues.size();
+}
+
+/**
+ * Runs body over [begin, end) split into chunks of at most grain indices, returns when all are done
+ * @param begin first index
+ * @param end one past the last index
+ * @param grain maximal chunk size, positive
+ * @param body called with the bounds of every chunk
+ */
+void ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body)
+{
+    if (end - begin <= grain || _workers.empty())
+    {
+        taskDepth++;
+        for (int first = begin; first < end; first += grain)
+        {
+            body(first, (end - first < grain) ? end : first + grain);
+        }
+        taskDepth--;
+        return;
+    }
+    std::atomic<int> remaining((end - begin + grain - ONE) / grain);
+    const int chunks = remaining.load();
+    const int home = _home();
+    const int queues = (int) _queues.size();
+    for (int c = 0; c < chunks; c++)
+    {
+        int first = begin + c * grain;
+        int last = (end - first < grain) ? end : first + grain;
+        WorkQueue &queue = *_queues[(home + c) % queues];
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.emplace_back([this, &body, &remaining, first, last]()
+                                     {
+                                         body(first, last);
+                                         if (--remaining == ZERO)
+                                         {
+                                             // taking the lock orders the wake up after the caller's check
+                                             std::lock_guard<std::mutex> sleeping(_sleepLock);
+                                             _wakeUp.notify_all();
+                                         }
+                                     });
+        }
+        _queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_sleepLock);
+    }
+    _wakeUp.notify_all();
+
+    // help while there is work, this also runs tasks of enclosing parallelFor calls, then sleep until
+    // the last chunk is done or new work is queued
+    std::function<void()> task;
+    while (remaining.load() > ZERO)
+    {
+        if (_takeTask(home, task))
+        {
+            _run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(_sleepLock);
+        _wakeUp.wait(guard, [this, &remaining]()
+        { return remaining.load() == ZERO || _queued.load() > ZERO; });
+    }
+}
+
+/**
+ * Returns true if the calling thread is running a chunk of a parallelFor of any pool, code that
+ * could fan out itself should then stay on the thread
+ */
+bool ThreadPool::insideTask()
+{
+    return taskDepth > ZERO;
+}
+
+/**
+ * Runs a task, marking the thread as inside a task meanwhile
+ * @param task the task
+ */
+void ThreadPool::_run(const std::function<void()> &task)
+{
+    taskDepth++;
+    task();
+    taskDepth--;
+}
+
+/**
+ * Main loop of worker number index
+ * @param index worker number, also the index of its own deque
+ */
+void ThreadPool::_workerLoop(int index)
+{
+    workerPool = this;
+    workerIndex = index;
+    std::function<void()> task;
+    while (true)
+    {
+        if (_takeTask(index, task))
+        {
+            _run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(_sleepLock);
+        _wakeUp.wait(guard, [this]()
+        { return _stopping || _queued.load() > ZERO; });
+        if (_stopping && _queued.load() == ZERO)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Returns the index of the calling thread's own deque, 0 for a thread that is not a worker of
+ * this pool
+ */
+int ThreadPool::_home() const
+{
+    return (workerPool == this) ? workerIndex : ZERO;
+}
+
+/**
+ * Takes one task, from the back of deque number home or from the front of any other deque
+ * @param home index of the preferred deque
+ * @param task filled with the task found
+ * @return true if a task was found
+ */
+bool ThreadPool::_takeTask(int home, std::function<void()> &task)
+{
+    int count = (int) _queues.size();
+    for (int i = 0; i < count; i++)
+    {
+        WorkQueue &queue = *_queues[(home + i) % count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+        if (i == ZERO)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        _queued--;
+        return true;
+    }
+    return false;
+}
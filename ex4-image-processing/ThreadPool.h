@@ -0,0 +1,103 @@
+// ThreadPool.h
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed size pool of threads with one task deque per thread. A parallelFor deals its chunks out
+ * over the deques starting with the caller's own, a thread pops work from the back of its own deque
+ * and steals from the front of the others when it runs dry. The thread calling parallelFor takes
+ * part in the work while there is any, so nested calls cannot deadlock, and sleeps once the last
+ * chunks of its range are running elsewhere.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Constructor - starts the worker threads
+     * @param threads amount of threads working on a range including the caller, 0 for one per core
+     */
+    explicit ThreadPool(int threads = 0);
+
+    /**
+     * destructor, finishes the queued tasks and joins the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * getter - returns the amount of threads working on a range, including the caller
+     */
+    int getThreadCount() const;
+
+    /**
+     * Runs body over [begin, end) split into chunks of at most grain indices, returns when all are done
+     * @param begin first index
+     * @param end one past the last index
+     * @param grain maximal chunk size, positive
+     * @param body called with the bounds of every chunk
+     */
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body);
+
+    /**
+     * Returns true if the calling thread is running a chunk of a parallelFor of any pool, code that
+     * could fan out itself should then stay on the thread
+     */
+    static bool insideTask();
+
+private:
+    /**
+     * A deque of tasks owned by one worker
+     */
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+    std::vector<std::thread> _workers;
+    std::mutex _sleepLock;
+    std::condition_variable _wakeUp;
+    std::atomic<int> _queued;
+    bool _stopping;
+
+    /**
+     * Main loop of worker number index
+     * @param index worker number, also the index of its own deque
+     */
+    void _workerLoop(int index);
+
+    /**
+     * Returns the index of the calling thread's own deque, 0 for a thread that is not a worker of
+     * this pool
+     */
+    int _home() const;
+
+    /**
+     * Takes one task, from the back of deque number home or from the front of any other deque
+     * @param home index of the preferred deque
+     * @param task filled with the task found
+     * @return true if a task was found
+     */
+    bool _takeTask(int home, std::function<void()> &task);
+
+    /**
+     * Runs a task, marking the thread as inside a task meanwhile
+     * @param task the task
+     */
+    static void _run(const std::function<void()> &task);
+};
+
+#endif //THREADPOOL_H
@@ -0,0 +1,624 @@
+#include "VectorOps.h"
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOROPS_X86 1
+#include <immintrin.h>
+#endif
+// the scalar fallback must not be contracted into fma, or it would stop matching the vector kernels
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#define FLOAT_ZERO 0.0f
+#define FLOAT_ONE 1.0f
+#define FLOAT_HALF 0.5f
+// exp(x) = 2^n * exp(r) with n = round(x / ln 2), ln 2 split in two so that n * EXP_LN2_HI is exact
+#define EXP_HI 88.3762626647949f
+#define EXP_LO (-87.3365447504f)
+#define EXP_LOG2E 1.44269504088896341f
+#define EXP_LN2_HI 0.693359375f
+#define EXP_LN2_LO (-2.12194440e-4f)
+// minimax polynomial of exp(r) on [-ln 2 / 2, ln 2 / 2] (Cephes expf), relative error below 2e-7
+#define EXP_P0 1.9875691500E-4f
+#define EXP_P1 1.3981999507E-3f
+#define EXP_P2 8.3334519073E-3f
+#define EXP_P3 4.1665795894E-2f
+#define EXP_P4 1.6666665459E-1f
+#define EXP_P5 5.0000001201E-1f
+#define EXP_BIAS 127
+#define EXP_MANTISSA_BITS 23
+// partial sums of vecSparseDot, one AVX-512 register or two AVX2 registers
+#define SPARSE_LANES 16
+#define ISA_SCALAR "scalar"
+#define ISA_AVX2 "avx2"
+#define ISA_AVX512 "avx512f"
+
+/**
+ * Table of the kernels selected for this CPU
+ */
+struct VectorOpsTable
+{
+    void (*add)(const float *, const float *, float *, int);
+    void (*scale)(const float *, float, float *, int);
+    void (*scaleAdd)(const float *, float, const float *, float *, int);
+    void (*relu)(const float *, float *, int);
+    void (*exp)(const float *, float, float *, int);
+    float (*max)(const float *, int);
+    float (*sparseDot)(const float *, const int *, const float *, int);
+    const char *isa;
+};
+
+static void scalarAdd(const float *a, const float *b, float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+static void scalarScale(const float *a, float c, float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = a[i] * c;
+    }
+}
+
+static void scalarScaleAdd(const float *a, float c, const float *b, float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float product = a[i] * c;
+        out[i] = product + b[i];
+    }
+}
+
+static void scalarRelu(const float *a, float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = (a[i] < FLOAT_ZERO) ? FLOAT_ZERO : a[i];
+    }
+}
+
+/**
+ * exp(x), the operation sequence every vector variant repeats lane by lane
+ * @param x argument
+ * @return exp(x), 0 below EXP_LO, NaN for NaN
+ */
+static inline float scalarExpOne(float x)
+{
+    if (x != x)
+    {
+        return x;
+    }
+    if (x < EXP_LO)
+    {
+        return FLOAT_ZERO;
+    }
+    x = (x > EXP_HI) ? EXP_HI : x;
+    // floor without a libm call, t is well inside the int range
+    float t = x * EXP_LOG2E + FLOAT_HALF;
+    float n = (float) (int32_t) t;
+    n = (n > t) ? n - FLOAT_ONE : n;
+    float hi = n * EXP_LN2_HI;
+    x = x - hi;
+    float lo = n * EXP_LN2_LO;
+    x = x - lo;
+    float x2 = x * x;
+    float p = EXP_P0 * x + EXP_P1;
+    p = p * x + EXP_P2;
+    p = p * x + EXP_P3;
+    p = p * x + EXP_P4;
+    p = p * x + EXP_P5;
+    p = p * x2 + x;
+    p = p + FLOAT_ONE;
+    int32_t bits = ((int32_t) n + EXP_BIAS) << EXP_MANTISSA_BITS;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+static void scalarExp(const float *a, float shift, float *out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = scalarExpOne(a[i] - shift);
+    }
+}
+
+static float scalarMax(const float *a, int n)
+{
+    float max = a[0];
+    for (int i = 1; i < n; i++)
+    {
+        max = (a[i] > max) ? a[i] : max;
+    }
+    return max;
+}
+
+/**
+ * Adds up the SPARSE_LANES partial sums of a sparse dot product by halving, lane l with lane
+ * l + width, the order the vector kernels fold their registers in
+ * @param acc the partial sums, clobbered
+ * @return the total
+ */
+static float sumLanes(float *acc)
+{
+    for (int width = SPARSE_LANES / 2; width > 0; width /= 2)
+    {
+        for (int l = 0; l < width; l++)
+        {
+            acc[l] += acc[l + width];
+        }
+    }
+    return acc[0];
+}
+
+static float scalarSparseDot(const float *values, const int *index, const float *x, int n)
+{
+    float acc[SPARSE_LANES] = {};
+    for (int i = 0; i < n; i += SPARSE_LANES)
+    {
+        for (int l = 0; l < SPARSE_LANES; l++)
+        {
+            // lanes past the end add a zero like the masked vector tail does
+            float product = (i + l < n) ? values[i + l] * x[index[i + l]] : FLOAT_ZERO;
+            acc[l] += product;
+        }
+    }
+    return sumLanes(acc);
+}
+
+#ifdef VECTOROPS_X86
+
+// _mm256_max_ps(zero, x) returns x when x is NaN or -0, and the AVX-512 version keeps every lane that is
+// not less than zero, both exactly like the scalar comparison
+
+__attribute__((target("avx2"))) static void avx2Add(const float *a, const float *b, float *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    scalarAdd(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void avx2Scale(const float *a, float c, float *out, int n)
+{
+    __m256 vc = _mm256_set1_ps(c);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), vc));
+    }
+    scalarScale(a + i, c, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void avx2ScaleAdd(const float *a, float c, const float *b, float *out,
+                                                         int n)
+{
+    __m256 vc = _mm256_set1_ps(c);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 product = _mm256_mul_ps(_mm256_loadu_ps(a + i), vc);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(product, _mm256_loadu_ps(b + i)));
+    }
+    scalarScaleAdd(a + i, c, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void avx2Relu(const float *a, float *out, int n)
+{
+    __m256 zero = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_max_ps(zero, _mm256_loadu_ps(a + i)));
+    }
+    scalarRelu(a + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void avx512Add(const float *a, const float *b, float *out, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, tail, _mm512_add_ps(_mm512_maskz_loadu_ps(tail, a + i),
+                                                       _mm512_maskz_loadu_ps(tail, b + i)));
+}
+
+__attribute__((target("avx512f"))) static void avx512Scale(const float *a, float c, float *out, int n)
+{
+    __m512 vc = _mm512_set1_ps(c);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), vc));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, tail, _mm512_mul_ps(_mm512_maskz_loadu_ps(tail, a + i), vc));
+}
+
+__attribute__((target("avx512f"))) static void avx512ScaleAdd(const float *a, float c, const float *b, float *out,
+                                                               int n)
+{
+    __m512 vc = _mm512_set1_ps(c);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512 product = _mm512_mul_ps(_mm512_loadu_ps(a + i), vc);
+        _mm512_storeu_ps(out + i, _mm512_add_ps(product, _mm512_loadu_ps(b + i)));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    __m512 product = _mm512_mul_ps(_mm512_maskz_loadu_ps(tail, a + i), vc);
+    _mm512_mask_storeu_ps(out + i, tail, _mm512_add_ps(product, _mm512_maskz_loadu_ps(tail, b + i)));
+}
+
+__attribute__((target("avx512f"))) static void avx512Relu(const float *a, float *out, int n)
+{
+    __m512 zero = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a + i);
+        _mm512_storeu_ps(out + i, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero, _CMP_NLT_UQ), x));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    __m512 x = _mm512_maskz_loadu_ps(tail, a + i);
+    _mm512_mask_storeu_ps(out + i, tail, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero, _CMP_NLT_UQ), x));
+}
+
+__attribute__((target("avx2"))) static inline __m256 avx2ExpOne(__m256 x)
+{
+    __m256 nan = _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+    __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(EXP_LO), _CMP_LT_OQ);
+    __m256 v = _mm256_min_ps(x, _mm256_set1_ps(EXP_HI));
+    __m256 n = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(EXP_LOG2E)),
+                                             _mm256_set1_ps(FLOAT_HALF)));
+    v = _mm256_sub_ps(v, _mm256_mul_ps(n, _mm256_set1_ps(EXP_LN2_HI)));
+    v = _mm256_sub_ps(v, _mm256_mul_ps(n, _mm256_set1_ps(EXP_LN2_LO)));
+    __m256 x2 = _mm256_mul_ps(v, v);
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(EXP_P0), v), _mm256_set1_ps(EXP_P1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(EXP_P2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(EXP_P3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(EXP_P4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(EXP_P5));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x2), v);
+    p = _mm256_add_ps(p, _mm256_set1_ps(FLOAT_ONE));
+    __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(EXP_BIAS)),
+                                     EXP_MANTISSA_BITS);
+    p = _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+    p = _mm256_andnot_ps(underflow, p);
+    return _mm256_blendv_ps(p, x, nan);
+}
+
+__attribute__((target("avx2"))) static void avx2Exp(const float *a, float shift, float *out, int n)
+{
+    __m256 vs = _mm256_set1_ps(shift);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, avx2ExpOne(_mm256_sub_ps(_mm256_loadu_ps(a + i), vs)));
+    }
+    // a masked tail, calling the scalar code with dirty upper halves costs more than the whole vector
+    __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    _mm256_maskstore_ps(out + i, tail, avx2ExpOne(_mm256_sub_ps(_mm256_maskload_ps(a + i, tail), vs)));
+}
+
+__attribute__((target("avx2"))) static float avx2Max(const float *a, int n)
+{
+    if (n < 8)
+    {
+        return scalarMax(a, n);
+    }
+    __m256 max = _mm256_loadu_ps(a);
+    int i = 8;
+    for (; i + 8 <= n; i += 8)
+    {
+        max = _mm256_max_ps(_mm256_loadu_ps(a + i), max);
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, max);
+    float result = scalarMax(lanes, 8);
+    for (; i < n; i++)
+    {
+        result = (a[i] > result) ? a[i] : result;
+    }
+    return result;
+}
+
+/**
+ * Folds eight partial sums the way sumLanes does
+ */
+__attribute__((target("avx2"))) static inline float avx2SumLanes(__m256 acc)
+{
+    __m128 quarter = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    __m128 pair = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+
+__attribute__((target("avx2"))) static float avx2SparseDot(const float *values, const int *index, const float *x,
+                                                          int n)
+{
+    __m256 low = _mm256_setzero_ps();
+    __m256 high = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + SPARSE_LANES <= n; i += SPARSE_LANES)
+    {
+        __m256 lowX = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i *) (index + i)), sizeof(float));
+        __m256 highX = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i *) (index + i + 8)),
+                                           sizeof(float));
+        low = _mm256_add_ps(low, _mm256_mul_ps(_mm256_loadu_ps(values + i), lowX));
+        high = _mm256_add_ps(high, _mm256_mul_ps(_mm256_loadu_ps(values + i + 8), highX));
+    }
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i lowTail = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), lanes);
+    __m256i highTail = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i - 8), lanes);
+    __m256 lowX = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, _mm256_maskload_epi32(index + i, lowTail),
+                                           _mm256_castsi256_ps(lowTail), sizeof(float));
+    __m256 highX = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x,
+                                            _mm256_maskload_epi32(index + i + 8, highTail),
+                                            _mm256_castsi256_ps(highTail), sizeof(float));
+    low = _mm256_add_ps(low, _mm256_mul_ps(_mm256_maskload_ps(values + i, lowTail), lowX));
+    high = _mm256_add_ps(high, _mm256_mul_ps(_mm256_maskload_ps(values + i + 8, highTail), highX));
+    return avx2SumLanes(_mm256_add_ps(low, high));
+}
+
+// the unmasked _mm512_min_ps, _mm512_roundscale_ps, _mm512_cvttps_epi32 and _mm512_slli_epi32 start
+// from an undefined register that gcc 12 reports as uninitialized, the zero-masked forms are the same
+__attribute__((target("avx512f"))) static inline __m512 avx512ExpOne(__m512 x)
+{
+    const __mmask16 all = (__mmask16) ~0u;
+    __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+    __mmask16 normal = _mm512_cmp_ps_mask(x, _mm512_set1_ps(EXP_LO), _CMP_NLT_UQ);
+    __m512 v = _mm512_maskz_min_ps(all, x, _mm512_set1_ps(EXP_HI));
+    __m512 n = _mm512_maskz_roundscale_ps(all, _mm512_add_ps(_mm512_mul_ps(v, _mm512_set1_ps(EXP_LOG2E)),
+                                                        _mm512_set1_ps(FLOAT_HALF)),
+                                          _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    v = _mm512_sub_ps(v, _mm512_mul_ps(n, _mm512_set1_ps(EXP_LN2_HI)));
+    v = _mm512_sub_ps(v, _mm512_mul_ps(n, _mm512_set1_ps(EXP_LN2_LO)));
+    __m512 x2 = _mm512_mul_ps(v, v);
+    __m512 p = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(EXP_P0), v), _mm512_set1_ps(EXP_P1));
+    p = _mm512_add_ps(_mm512_mul_ps(p, v), _mm512_set1_ps(EXP_P2));
+    p = _mm512_add_ps(_mm512_mul_ps(p, v), _mm512_set1_ps(EXP_P3));
+    p = _mm512_add_ps(_mm512_mul_ps(p, v), _mm512_set1_ps(EXP_P4));
+    p = _mm512_add_ps(_mm512_mul_ps(p, v), _mm512_set1_ps(EXP_P5));
+    p = _mm512_add_ps(_mm512_mul_ps(p, x2), v);
+    p = _mm512_add_ps(p, _mm512_set1_ps(FLOAT_ONE));
+    __m512i bits = _mm512_maskz_slli_epi32(all, _mm512_add_epi32(_mm512_maskz_cvttps_epi32(all, n),
+                                                                  _mm512_set1_epi32(EXP_BIAS)),
+                                           EXP_MANTISSA_BITS);
+    p = _mm512_maskz_mov_ps(normal, _mm512_mul_ps(p, _mm512_castsi512_ps(bits)));
+    return _mm512_mask_mov_ps(p, nan, x);
+}
+
+__attribute__((target("avx512f"))) static void avx512Exp(const float *a, float shift, float *out, int n)
+{
+    __m512 vs = _mm512_set1_ps(shift);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, avx512ExpOne(_mm512_sub_ps(_mm512_loadu_ps(a + i), vs)));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    _mm512_mask_storeu_ps(out + i, tail, avx512ExpOne(_mm512_sub_ps(_mm512_maskz_loadu_ps(tail, a + i), vs)));
+}
+
+__attribute__((target("avx512f"))) static float avx512SparseDot(const float *values, const int *index,
+                                                               const float *x, int n)
+{
+    const __mmask16 all = (__mmask16) ~0u;
+    __m512 acc = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + SPARSE_LANES <= n; i += SPARSE_LANES)
+    {
+        __m512 gathered = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), all, _mm512_loadu_si512(index + i), x,
+                                                   sizeof(float));
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(values + i), gathered));
+    }
+    __mmask16 tail = (__mmask16) ((1u << (n - i)) - 1);
+    __m512 gathered = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), tail,
+                                               _mm512_maskz_loadu_epi32(tail, index + i), x, sizeof(float));
+    acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_maskz_loadu_ps(tail, values + i), gathered));
+    // _mm512_castps512_ps256 is an unmasked extract as well
+    __m256 low = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd((__mmask8) all, _mm512_castps_pd(acc), 0));
+    __m256 high = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd((__mmask8) all, _mm512_castps_pd(acc), 1));
+    return avx2SumLanes(_mm256_add_ps(low, high));
+}
+
+#endif //VECTOROPS_X86
+
+/**
+ * Queries cpuid and picks the widest supported kernels
+ * @return the kernel table
+ */
+static VectorOpsTable selectKernels()
+{
+#ifdef VECTOROPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return {avx512Add, avx512Scale, avx512ScaleAdd, avx512Relu, avx512Exp, avx2Max, avx512SparseDot,
+                ISA_AVX512};
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {avx2Add, avx2Scale, avx2ScaleAdd, avx2Relu, avx2Exp, avx2Max, avx2SparseDot, ISA_AVX2};
+    }
+#endif
+    return {scalarAdd, scalarScale, scalarScaleAdd, scalarRelu, scalarExp, scalarMax, scalarSparseDot,
+            ISA_SCALAR};
+}
+
+/**
+ * The kernels of this process, selected on first use
+ */
+static const VectorOpsTable &kernels()
+{
+    static const VectorOpsTable table = selectKernels();
+    return table;
+}
+
+/**
+ * out[i] = a[i] + b[i]
+ * @param a first operand
+ * @param b second operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecAdd(const float *a, const float *b, float *out, int n)
+{
+    kernels().add(a, b, out, n);
+}
+
+/**
+ * out[i] = a[i] * c
+ * @param a operand
+ * @param c scalar
+ * @param out result
+ * @param n amount of elements
+ */
+void vecScale(const float *a, float c, float *out, int n)
+{
+    kernels().scale(a, c, out, n);
+}
+
+/**
+ * out[i] = a[i] * c + b[i], the product is rounded before the addition
+ * @param a scaled operand
+ * @param c scalar
+ * @param b added operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecScaleAdd(const float *a, float c, const float *b, float *out, int n)
+{
+    kernels().scaleAdd(a, c, b, out, n);
+}
+
+/**
+ * out[i] = a[i] < 0 ? 0 : a[i]
+ * @param a operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecRelu(const float *a, float *out, int n)
+{
+    kernels().relu(a, out, n);
+}
+
+/**
+ * out[i] = exp(a[i] - shift) by range reduction and a polynomial, relative error below 2e-7 (3 ulp).
+ * Results that would be subnormal are flushed to 0 and NaN is passed through.
+ * @param a operand
+ * @param shift subtracted from every element before the exponent
+ * @param out result
+ * @param n amount of elements
+ */
+void vecExp(const float *a, float shift, float *out, int n)
+{
+    kernels().exp(a, shift, out, n);
+}
+
+/**
+ * Largest element, the result is unspecified when an element is NaN
+ * @param a operand
+ * @param n amount of elements, positive
+ * @return the maximum
+ */
+float vecMax(const float *a, int n)
+{
+    return kernels().max(a, n);
+}
+
+/**
+ * Sparse dot product, the sum of values[i] * x[index[i]]. The products are accumulated in 16
+ * interleaved partial sums that are folded in a fixed order.
+ * @param values the nonzero elements
+ * @param index the position in x of every element
+ * @param x dense operand
+ * @param n amount of elements
+ * @return the dot product
+ */
+float vecSparseDot(const float *values, const int *index, const float *x, int n)
+{
+    return kernels().sparseDot(values, index, x, n);
+}
+
+/**
+ * Index of the largest element, the first one on ties
+ * @param a operand
+ * @param n amount of elements, positive
+ * @return the index
+ */
+int vecArgmax(const float *a, int n)
+{
+    int index = 0;
+    for (int i = 1; i < n; i++)
+    {
+        index = (a[i] > a[index]) ? i : index;
+    }
+    return index;
+}
+
+/**
+ * out = softmax(a), the maximum is subtracted first so no exponent overflows
+ * @param a operand
+ * @param out result
+ * @param n amount of elements, positive
+ * @return sum of exp(a[i] - max(a)), 1 / sum is the probability of the largest element
+ */
+float vecSoftmax(const float *a, float *out, int n)
+{
+    const VectorOpsTable &table = kernels();
+    table.exp(a, table.max(a, n), out, n);
+    float sum = FLOAT_ZERO;
+    for (int i = 0; i < n; i++)
+    {
+        sum += out[i];
+    }
+    table.scale(out, FLOAT_ONE / sum, out, n);
+    return sum;
+}
+
+/**
+ * out = log(softmax(a)) = a - max(a) - log(sum of exp(a[i] - max(a))), without ever normalizing
+ * @param a operand
+ * @param out result
+ * @param n amount of elements, positive
+ */
+void vecLogSoftmax(const float *a, float *out, int n)
+{
+    static thread_local std::vector<float> exps;
+    exps.resize((size_t) n);
+    const float max = vecMax(a, n);
+    vecExp(a, max, exps.data(), n);
+    float sum = FLOAT_ZERO;
+    for (int i = 0; i < n; i++)
+    {
+        sum += exps[i];
+    }
+    // a[i] - max is exact for the elements that matter, adding max into the log would round it away
+    const float logSum = std::log(sum);
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = (a[i] - max) - logSum;
+    }
+}
+
+/**
+ * Name of the instruction set the kernels were dispatched to ("avx512f", "avx2" or "scalar")
+ */
+const char *vecOpsIsa()
+{
+    return kernels().isa;
+}
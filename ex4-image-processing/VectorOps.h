@@ -0,0 +1,108 @@
+// VectorOps.h
+
+#ifndef VECTOROPS_H
+#define VECTOROPS_H
+
+/**
+ * Element-wise float kernels. The implementation is picked once at startup from the
+ * instruction sets the CPU reports (AVX-512F, AVX2 or plain scalar code), every variant
+ * gives bit-identical results since none of them fuses or reorders operations.
+ * In-place calls (out equal to one of the inputs) are allowed.
+ */
+
+/**
+ * out[i] = a[i] + b[i]
+ * @param a first operand
+ * @param b second operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecAdd(const float *a, const float *b, float *out, int n);
+
+/**
+ * out[i] = a[i] * c
+ * @param a operand
+ * @param c scalar
+ * @param out result
+ * @param n amount of elements
+ */
+void vecScale(const float *a, float c, float *out, int n);
+
+/**
+ * out[i] = a[i] * c + b[i], the product is rounded before the addition
+ * @param a scaled operand
+ * @param c scalar
+ * @param b added operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecScaleAdd(const float *a, float c, const float *b, float *out, int n);
+
+/**
+ * out[i] = a[i] < 0 ? 0 : a[i]
+ * @param a operand
+ * @param out result
+ * @param n amount of elements
+ */
+void vecRelu(const float *a, float *out, int n);
+
+/**
+ * out[i] = exp(a[i] - shift) by range reduction and a polynomial, relative error below 2e-7 (3 ulp).
+ * Results that would be subnormal are flushed to 0 and NaN is passed through.
+ * @param a operand
+ * @param shift subtracted from every element before the exponent
+ * @param out result
+ * @param n amount of elements
+ */
+void vecExp(const float *a, float shift, float *out, int n);
+
+/**
+ * Largest element, the result is unspecified when an element is NaN
+ * @param a operand
+ * @param n amount of elements, positive
+ * @return the maximum
+ */
+float vecMax(const float *a, int n);
+
+/**
+ * Sparse dot product, the sum of values[i] * x[index[i]]. The products are accumulated in 16
+ * interleaved partial sums that are folded in a fixed order.
+ * @param values the nonzero elements
+ * @param index the position in x of every element
+ * @param x dense operand
+ * @param n amount of elements
+ * @return the dot product
+ */
+float vecSparseDot(const float *values, const int *index, const float *x, int n);
+
+/**
+ * Index of the largest element, the first one on ties
+ * @param a operand
+ * @param n amount of elements, positive
+ * @return the index
+ */
+int vecArgmax(const float *a, int n);
+
+/**
+ * out = softmax(a), the maximum is subtracted first so no exponent overflows
+ * @param a operand
+ * @param out result
+ * @param n amount of elements, positive
+ * @return sum of exp(a[i] - max(a)), 1 / sum is the probability of the largest element
+ */
+float vecSoftmax(const float *a, float *out, int n);
+
+/**
+ * out = log(softmax(a)) = a - max(a) - log(sum of exp(a[i] - max(a))), without ever normalizing
+ * @param a operand
+ * @param out result
+ * @param n amount of elements, positive
+ */
+void vecLogSoftmax(const float *a, float *out, int n);
+
+/**
+ * Name of the instruction set the kernels were dispatched to ("avx512f", "avx2" or "scalar")
+ */
+const char *vecOpsIsa();
+
+#endif //VECTOROPS_H
@@ -0,0 +1,22 @@
+# bench_check.cmake
+#
+# Script of the bench_check target: runs bench_matrix and compares the run with the stored baseline
+# through bench_report. Without a baseline (a fresh checkout, see the bench_baseline target) it
+# skips with a message instead of failing. Expects BENCH_MATRIX, BENCH_REPORT, BASELINE, CURRENT and
+# THRESHOLD to be set with -D.
+
+if(NOT EXISTS "${BASELINE}")
+    message(STATUS "bench_check skipped: no baseline at ${BASELINE}, store one with the bench_baseline target")
+    return()
+endif()
+
+execute_process(COMMAND ${BENCH_MATRIX} --benchmark_out=${CURRENT} --benchmark_out_format=json
+        RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "bench_check: bench_matrix failed")
+endif()
+execute_process(COMMAND ${BENCH_REPORT} ${BASELINE} ${CURRENT} --threshold=${THRESHOLD}
+        RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "bench_check: regressions against ${BASELINE}, see the report above")
+endif()
@@ -0,0 +1,630 @@
+// bench_matrix.cpp
+//
+// Google Benchmark suite of the matrix kernels, the layers and the whole network. Every case names
+// its shape in the arguments, e.g. BM_GemmLayer/layer:0/batch:64 is the 128 × 784 first layer
+// applied to 64 inputs. Store a run with --benchmark_out=run.json --benchmark_out_format=json and
+// compare two runs with bench_report (or the bench_baseline and bench_check targets).
+
+#include "Activation.h"
+#include "Dense.h"
+#include "Gemm.h"
+#include "MlpNetwork.h"
+#include "ReducedPrecisionMlpNetwork.h"
+#include "SparseMatrix.h"
+#include "StaticMlpNetwork.h"
+#include "ThreadPool.h"
+#include "VectorOps.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <thread>
+#include <vector>
+#define SEED 7
+#define NETWORK_IMAGES 512
+
+/**
+ * A rows × cols matrix of uniform values in [-1, 1)
+ * @param rows positive number
+ * @param cols positive number
+ * @param seed seed of the values
+ * @return the matrix
+ */
+static Matrix randomMatrix(int rows, int cols, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = uniform(random);
+    }
+    return m;
+}
+
+/**
+ * count images of uniform pixels in [0, 1), stored one after the other
+ * @param count amount of images
+ * @return the pixels
+ */
+static std::vector<float> randomImages(int count)
+{
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<float> images((size_t) count * imgDims.rows * imgDims.cols);
+    for (float &pixel : images)
+    {
+        pixel = uniform(random);
+    }
+    return images;
+}
+
+/**
+ * Returns a network of the weightsDims shapes with random weights, built once
+ */
+static const MlpNetwork &network()
+{
+    static const MlpNetwork *net = []()
+    {
+        Matrix weights[MLP_SIZE];
+        Matrix biases[MLP_SIZE];
+        for (int i = 0; i < MLP_SIZE; i++)
+        {
+            weights[i] = randomMatrix(weightsDims[i].rows, weightsDims[i].cols, SEED + i);
+            // scaled down so the activations stay in range through the layers
+            weights[i] = weights[i] * (1.0f / (float) weightsDims[i].cols);
+            biases[i] = randomMatrix(biasDims[i].rows, biasDims[i].cols, SEED + MLP_SIZE + i);
+        }
+        return new MlpNetwork(weights, biases);
+    }();
+    return *net;
+}
+
+/**
+ * The Matrix::operator* loop before the blocked kernel: i-j-k through the checked accessors
+ * @param a left operand
+ * @param b right operand
+ * @return the product
+ */
+static Matrix naiveProduct(const Matrix &a, const Matrix &b)
+{
+    Matrix result(a.getRows(), b.getCols());
+    for (int i = 0; i < a.getRows(); i++)
+    {
+        for (int j = 0; j < b.getCols(); j++)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < a.getCols(); k++)
+            {
+                sum += a(i, k) * b(k, j);
+            }
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+/**
+ * Reports the floating point operations of one iteration as a rate
+ * @param state the benchmark state
+ * @param flops operations per iteration
+ */
+static void setFlops(benchmark::State &state, double flops)
+{
+    state.counters["FLOPS"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate,
+                                                 benchmark::Counter::kIs1000);
+}
+
+/**
+ * Registers layer index × batch size for every layer of weightsDims
+ * @param bench the benchmark
+ * @param batches batch sizes
+ */
+static void layerArgs(benchmark::internal::Benchmark *bench, const std::vector<int> &batches)
+{
+    bench->ArgNames({"layer", "batch"});
+    for (int layer = 0; layer < MLP_SIZE; layer++)
+    {
+        for (int batch : batches)
+        {
+            bench->Args({layer, batch});
+        }
+    }
+}
+
+/**
+ * The thread counts of a scaling curve, powers of two up to the amount of cores and the cores
+ * themselves
+ */
+static std::vector<int> threadCounts()
+{
+    int cores = (int) std::thread::hardware_concurrency();
+    cores = (cores <= 0) ? 1 : cores;
+    std::vector<int> counts;
+    for (int threads = 1; threads < cores; threads *= 2)
+    {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+    return counts;
+}
+
+// ---------------------------------------------------------------------------------------------
+// GEMM and GEMV at the layer shapes, against the loop they replaced
+
+static void BM_GemmLayer(benchmark::State &state)
+{
+    const MatrixDims dims = weightsDims[state.range(0)];
+    const int batch = (int) state.range(1);
+    const Matrix w = randomMatrix(dims.rows, dims.cols, SEED);
+    const Matrix x = randomMatrix(dims.cols, batch, SEED + 1);
+    Matrix y(dims.rows, batch);
+    for (auto _ : state)
+    {
+        y = w * x;
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dims.rows * dims.cols * batch);
+}
+BENCHMARK(BM_GemmLayer)->Apply([](benchmark::internal::Benchmark *bench)
+                               {
+                                   layerArgs(bench, {1, 64});
+                               });
+
+static void BM_NaiveGemmLayer(benchmark::State &state)
+{
+    const MatrixDims dims = weightsDims[state.range(0)];
+    const int batch = (int) state.range(1);
+    const Matrix w = randomMatrix(dims.rows, dims.cols, SEED);
+    const Matrix x = randomMatrix(dims.cols, batch, SEED + 1);
+    for (auto _ : state)
+    {
+        Matrix y = naiveProduct(w, x);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dims.rows * dims.cols * batch);
+}
+BENCHMARK(BM_NaiveGemmLayer)->Apply([](benchmark::internal::Benchmark *bench)
+                                    {
+                                        layerArgs(bench, {1, 64});
+                                    });
+
+static void BM_GemvBiasRelu(benchmark::State &state)
+{
+    const MatrixDims dims = weightsDims[state.range(0)];
+    const Matrix w = randomMatrix(dims.rows, dims.cols, SEED);
+    const Matrix x = randomMatrix(dims.cols, 1, SEED + 1);
+    const Matrix bias = randomMatrix(dims.rows, 1, SEED + 2);
+    Matrix y(dims.rows, 1);
+    for (auto _ : state)
+    {
+        gemvBiasAct(dims.rows, dims.cols, w.data(), dims.cols, x.data(), bias.data(), y.data(), GemvRelu);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dims.rows * dims.cols);
+}
+BENCHMARK(BM_GemvBiasRelu)->ArgName("layer")->DenseRange(0, MLP_SIZE - 1);
+
+// square products across the gemm threads, the scaling curve of the parallel GEMM
+static void BM_GemmSquare(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, n, SEED);
+    const Matrix b = randomMatrix(n, n, SEED + 1);
+    Matrix c(n, n);
+    const int previous = getGemmThreads();
+    setGemmThreads((int) state.range(1));
+    for (auto _ : state)
+    {
+        gemm(n, n, n, a.data(), n, b.data(), n, c.data(), n);
+        benchmark::DoNotOptimize(c.data());
+    }
+    setGemmThreads(previous);
+    setFlops(state, 2.0 * n * n * n);
+}
+BENCHMARK(BM_GemmSquare)->Apply([](benchmark::internal::Benchmark *bench)
+                                {
+                                    bench->ArgNames({"n", "threads"});
+                                    for (int n = 256; n <= 4096; n *= 2)
+                                    {
+                                        for (int threads : threadCounts())
+                                        {
+                                            bench->Args({n, threads});
+                                        }
+                                    }
+                                })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// ---------------------------------------------------------------------------------------------
+// element access: y += M x over a layer's weights through operator() (checked when
+// MATRIX_BOUNDS_CHECK is on, see bench_matrix_checked), row() and data()
+
+#define ACCESS_OPERATOR 0
+#define ACCESS_ROW 1
+#define ACCESS_DATA 2
+
+static void BM_ElementAccess(benchmark::State &state)
+{
+    const MatrixDims dims = weightsDims[state.range(0)];
+    const int access = (int) state.range(1);
+    const Matrix w = randomMatrix(dims.rows, dims.cols, SEED);
+    const Matrix x = randomMatrix(dims.cols, 1, SEED + 1);
+    Matrix y(dims.rows, 1);
+    for (auto _ : state)
+    {
+        for (int i = 0; i < dims.rows; i++)
+        {
+            float sum = 0.0f;
+            if (access == ACCESS_OPERATOR)
+            {
+                for (int j = 0; j < dims.cols; j++)
+                {
+                    sum += w(i, j) * x(j, 0);
+                }
+            }
+            else if (access == ACCESS_ROW)
+            {
+                const float *wRow = w.row(i);
+                for (int j = 0; j < dims.cols; j++)
+                {
+                    sum += wRow[j] * x.row(j)[0];
+                }
+            }
+            else
+            {
+                const float *wData = w.data();
+                const float *xData = x.data();
+                for (int j = 0; j < dims.cols; j++)
+                {
+                    sum += wData[i * dims.cols + j] * xData[j];
+                }
+            }
+            y(i, 0) = sum;
+        }
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dims.rows * dims.cols);
+}
+BENCHMARK(BM_ElementAccess)->ArgNames({"layer", "access"})
+        ->ArgsProduct({{0, 1, 2, 3}, {ACCESS_OPERATOR, ACCESS_ROW, ACCESS_DATA}});
+
+// ---------------------------------------------------------------------------------------------
+// element-wise kernels and activations
+
+static void BM_VecAdd(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    const Matrix b = randomMatrix(n, 1, SEED + 1);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        vecAdd(a.data(), b.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * n * 3 * (int64_t) sizeof(float));
+}
+BENCHMARK(BM_VecAdd)->ArgName("n")->Arg(128)->Arg(784)->Arg(1 << 16);
+
+static void BM_VecScaleAdd(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    const Matrix b = randomMatrix(n, 1, SEED + 1);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        vecScaleAdd(a.data(), 0.5f, b.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * n * 3 * (int64_t) sizeof(float));
+}
+BENCHMARK(BM_VecScaleAdd)->ArgName("n")->Arg(128)->Arg(784)->Arg(1 << 16);
+
+static void BM_VecRelu(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        vecRelu(a.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * n * 2 * (int64_t) sizeof(float));
+}
+BENCHMARK(BM_VecRelu)->ArgName("n")->Arg(128)->Arg(784)->Arg(1 << 16);
+
+static void BM_VecExp(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        vecExp(a.data(), 0.0f, out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * n);
+}
+BENCHMARK(BM_VecExp)->ArgName("n")->Arg(10)->Arg(128)->Arg(1 << 16);
+
+static void BM_VecSoftmax(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(vecSoftmax(a.data(), out.data(), n));
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * n);
+}
+BENCHMARK(BM_VecSoftmax)->ArgName("n")->Arg(10)->Arg(128)->Arg(1 << 16);
+
+static void BM_VecLogSoftmax(benchmark::State &state)
+{
+    const int n = (int) state.range(0);
+    const Matrix a = randomMatrix(n, 1, SEED);
+    Matrix out(n, 1);
+    for (auto _ : state)
+    {
+        vecLogSoftmax(a.data(), out.data(), n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * n);
+}
+BENCHMARK(BM_VecLogSoftmax)->ArgName("n")->Arg(10)->Arg(128)->Arg(1 << 16);
+
+static void BM_Activation(benchmark::State &state)
+{
+    const Activation activation((ActivationType) state.range(0));
+    const int n = (int) state.range(1);
+    Matrix m = randomMatrix(n, 1, SEED);
+    for (auto _ : state)
+    {
+        Matrix out = activation(m);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * n);
+}
+BENCHMARK(BM_Activation)->ArgNames({"softmax", "n"})->ArgsProduct({{Relu, Softmax}, {10, 128}});
+
+// ---------------------------------------------------------------------------------------------
+// Dense layers, one case per weight layout: the row major GEMV of single inputs, the packed
+// column batch (one input per column) and the packed row batch (one input per row)
+
+static void BM_DenseSingle(benchmark::State &state)
+{
+    const Dense &layer = network().getLayer((int) state.range(0));
+    const Matrix x = randomMatrix(layer.getWeights().getCols(), 1, SEED);
+    for (auto _ : state)
+    {
+        Matrix y = layer(x);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * layer.getWeights().size());
+    state.SetBytesProcessed((int64_t) state.iterations() * layer.getWeights().size() * (int64_t) sizeof(float));
+}
+BENCHMARK(BM_DenseSingle)->ArgName("layer")->DenseRange(0, MLP_SIZE - 1);
+
+static void BM_DenseColumns(benchmark::State &state)
+{
+    const Dense &layer = network().getLayer((int) state.range(0));
+    const int batch = (int) state.range(1);
+    const Matrix x = randomMatrix(layer.getWeights().getCols(), batch, SEED);
+    for (auto _ : state)
+    {
+        Matrix y = layer(x);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * layer.getWeights().size() * batch);
+}
+BENCHMARK(BM_DenseColumns)->Apply([](benchmark::internal::Benchmark *bench)
+                                  {
+                                      layerArgs(bench, {8, 64, 512});
+                                  });
+
+static void BM_DenseRows(benchmark::State &state)
+{
+    const Dense &layer = network().getLayer((int) state.range(0));
+    const int batch = (int) state.range(1);
+    const Matrix x = randomMatrix(batch, layer.getWeights().getCols(), SEED);
+    for (auto _ : state)
+    {
+        Matrix y = layer.applyRows(x);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * layer.getWeights().size() * batch);
+}
+BENCHMARK(BM_DenseRows)->Apply([](benchmark::internal::Benchmark *bench)
+                               {
+                                   layerArgs(bench, {8, 64, 512});
+                               });
+
+// dense and CSR GEMV of the first layer with a given percentage of nonzero weights, the crossover
+// that SPARSE_DENSITY_THRESHOLD is set from
+static void BM_SparseCrossover(benchmark::State &state)
+{
+    const MatrixDims dims = weightsDims[0];
+    const bool sparse = state.range(0) != 0;
+    const int percent = (int) state.range(1);
+    Matrix w = randomMatrix(dims.rows, dims.cols, SEED);
+    std::mt19937 random(SEED);
+    std::uniform_int_distribution<int> keep(0, 99);
+    for (int i = 0; i < w.size(); i++)
+    {
+        w[i] = (keep(random) < percent) ? w[i] : 0.0f;
+    }
+    const SparseMatrix s(w);
+    const Matrix x = randomMatrix(dims.cols, 1, SEED + 1);
+    const Matrix bias = randomMatrix(dims.rows, 1, SEED + 2);
+    Matrix y(dims.rows, 1);
+    for (auto _ : state)
+    {
+        if (sparse)
+        {
+            s.gemvBiasAct(0, dims.rows, x.data(), bias.data(), y.data(), GemvRelu);
+        }
+        else
+        {
+            gemvBiasAct(dims.rows, dims.cols, w.data(), dims.cols, x.data(), bias.data(), y.data(), GemvRelu);
+        }
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+BENCHMARK(BM_SparseCrossover)->ArgNames({"sparse", "density%"})
+        ->ArgsProduct({{0, 1}, {5, 10, 15, 20, 25, 30, 40, 50}});
+
+// ---------------------------------------------------------------------------------------------
+// reduced precision copies of the layers and the network, bytes per second are weight bytes read,
+// to set against BM_DenseSingle; the network cases also report their agreement with the float
+// network over NETWORK_IMAGES images
+
+/**
+ * Adds the accuracy of a reduced precision network to the counters of a case
+ * @param state the benchmark state
+ * @param report the comparison with the float network
+ */
+static void setAccuracy(benchmark::State &state, const QuantizationReport &report)
+{
+    state.counters["agreement%"] = 100.0 * report.agreeing / report.images;
+    state.counters["maxError"] = report.maxProbabilityError;
+    state.counters["meanError"] = report.meanProbabilityError;
+}
+
+static void BM_QuantizedDenseSingle(benchmark::State &state)
+{
+    const Dense &dense = network().getLayer((int) state.range(0));
+    const QuantizedDense layer(dense);
+    const Matrix x = randomMatrix(layer.getCols(), 1, SEED);
+    std::vector<float> y((size_t) layer.getRows());
+    for (auto _ : state)
+    {
+        layer.apply(x.data(), y.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dense.getWeights().size());
+    state.SetBytesProcessed((int64_t) state.iterations() * dense.getWeights().size() * (int64_t) sizeof(int8_t));
+}
+BENCHMARK(BM_QuantizedDenseSingle)->ArgName("layer")->DenseRange(0, MLP_SIZE - 1);
+
+static void BM_QuantizedMlpSingle(benchmark::State &state)
+{
+    static const QuantizedMlpNetwork quantized(network());
+    const std::vector<float> images = randomImages(NETWORK_IMAGES);
+    const Matrix img(imgDims.rows * imgDims.cols, 1, const_cast<float *>(images.data()));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(quantized(img));
+    }
+    state.SetItemsProcessed((int64_t) state.iterations());
+    setAccuracy(state, quantized.compareWith(network(), images.data(), NETWORK_IMAGES));
+}
+BENCHMARK(BM_QuantizedMlpSingle);
+
+static void BM_HalfDenseSingle(benchmark::State &state)
+{
+    const Dense &dense = network().getLayer((int) state.range(0));
+    const HalfDense layer(dense, (HalfFormat) state.range(1));
+    const Matrix x = randomMatrix(layer.getCols(), 1, SEED);
+    std::vector<float> y((size_t) layer.getRows());
+    for (auto _ : state)
+    {
+        layer.apply(x.data(), y.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+    setFlops(state, 2.0 * dense.getWeights().size());
+    state.SetBytesProcessed((int64_t) state.iterations() * dense.getWeights().size() * (int64_t) sizeof(uint16_t));
+}
+BENCHMARK(BM_HalfDenseSingle)->ArgNames({"layer", "bf16"})->ArgsProduct({{0, 1, 2, 3}, {Float16, BFloat16}});
+
+static void BM_HalfMlpSingle(benchmark::State &state)
+{
+    const HalfMlpNetwork half(network(), (HalfFormat) state.range(0));
+    const std::vector<float> images = randomImages(NETWORK_IMAGES);
+    const Matrix img(imgDims.rows * imgDims.cols, 1, const_cast<float *>(images.data()));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(half(img));
+    }
+    state.SetItemsProcessed((int64_t) state.iterations());
+    setAccuracy(state, half.compareWith(network(), images.data(), NETWORK_IMAGES));
+}
+BENCHMARK(BM_HalfMlpSingle)->ArgName("bf16")->Arg(Float16)->Arg(BFloat16);
+
+// ---------------------------------------------------------------------------------------------
+// the whole network
+
+static void BM_MlpSingle(benchmark::State &state)
+{
+    const std::vector<float> pixels = randomImages(1);
+    const Matrix img(imgDims.rows * imgDims.cols, 1, const_cast<float *>(pixels.data()));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(network()(img));
+    }
+    state.SetItemsProcessed((int64_t) state.iterations());
+}
+BENCHMARK(BM_MlpSingle);
+
+static void BM_StaticMlpSingle(benchmark::State &state)
+{
+    static const StaticMlpNetwork staticNetwork(network());
+    const std::vector<float> pixels = randomImages(1);
+    const Matrix img(imgDims.rows * imgDims.cols, 1, const_cast<float *>(pixels.data()));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(staticNetwork(img));
+    }
+    state.SetItemsProcessed((int64_t) state.iterations());
+}
+BENCHMARK(BM_StaticMlpSingle);
+
+// batch throughput, items per second are images per second
+static void BM_MlpBatch(benchmark::State &state)
+{
+    const int batch = (int) state.range(0);
+    const std::vector<float> images = randomImages(batch);
+    for (auto _ : state)
+    {
+        std::vector<Digit> digits = network().classify(images.data(), batch);
+        benchmark::DoNotOptimize(digits.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * batch);
+}
+BENCHMARK(BM_MlpBatch)->ArgName("batch")->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+
+static void BM_StaticMlpBatch(benchmark::State &state)
+{
+    static const StaticMlpNetwork staticNetwork(network());
+    const int batch = (int) state.range(0);
+    const std::vector<float> images = randomImages(batch);
+    for (auto _ : state)
+    {
+        std::vector<Digit> digits = staticNetwork.classify(images.data(), batch);
+        benchmark::DoNotOptimize(digits.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * batch);
+}
+BENCHMARK(BM_StaticMlpBatch)->ArgName("batch")->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+
+// the scaling curve of the pool, NETWORK_IMAGES images split into sub-batches across threads
+static void BM_MlpParallel(benchmark::State &state)
+{
+    ThreadPool pool((int) state.range(0));
+    const std::vector<float> images = randomImages(NETWORK_IMAGES);
+    for (auto _ : state)
+    {
+        std::vector<Digit> digits = network().classify(images.data(), NETWORK_IMAGES, pool);
+        benchmark::DoNotOptimize(digits.data());
+    }
+    state.SetItemsProcessed((int64_t) state.iterations() * NETWORK_IMAGES);
+}
+BENCHMARK(BM_MlpParallel)->Apply([](benchmark::internal::Benchmark *bench)
+                                 {
+                                     bench->ArgName("threads");
+                                     for (int threads : threadCounts())
+                                     {
+                                         bench->Arg(threads);
+                                     }
+                                 })->UseRealTime();
+
+BENCHMARK_MAIN();
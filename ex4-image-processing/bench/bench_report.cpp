@@ -0,0 +1,423 @@
+// bench_report.cpp
+//
+// Compares two Google Benchmark JSON runs of bench_matrix case by case:
+//     bench_report <baseline.json> <current.json> [--threshold=0.10]
+// Every case present in both runs is listed with its time in each and the ratio. Cases slower than
+// the baseline by more than the threshold are flagged, and the exit status is then 1, so the report
+// can gate a build. Repeated runs (--benchmark_repetitions) are compared on their mean.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#define USAGE_MSG "Usage: bench_report <baseline.json> <current.json> [--threshold=0.10]"
+#define READ_FILE_ERROR "Error: there is a problem with the file!"
+#define FORMAT_ERROR "Error: not a Google Benchmark JSON file: "
+#define THRESHOLD_FLAG "--threshold="
+#define DEFAULT_THRESHOLD 0.10
+#define NAME_WIDTH 56
+
+/**
+ * @struct JsonValue
+ * @brief A parsed JSON value, only the fields of the kind it holds are used
+ */
+typedef struct JsonValue
+{
+    enum Kind
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    } kind;
+    double number;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> fields;
+} JsonValue;
+
+/**
+ * A recursive descent parser for the JSON bench_matrix writes, terminates on malformed input
+ */
+class JsonParser
+{
+public:
+    /**
+     * Constructor
+     * @param text the document
+     * @param path where it was read from, for the error message
+     */
+    JsonParser(const std::string &text, const std::string &path) : _text(text), _path(path), _at(0)
+    {
+    }
+
+    /**
+     * Parses the whole document
+     * @return the top level value
+     */
+    JsonValue parse()
+    {
+        JsonValue value = _value();
+        _skipSpace();
+        if (_at != _text.size())
+        {
+            _fail();
+        }
+        return value;
+    }
+
+private:
+    const std::string &_text;
+    const std::string &_path;
+    size_t _at;
+
+    /**
+     * Reports a malformed document and terminates
+     */
+    void _fail() const
+    {
+        std::cerr << FORMAT_ERROR << _path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    void _skipSpace()
+    {
+        while (_at < _text.size() && (_text[_at] == ' ' || _text[_at] == '\n' || _text[_at] == '\r' ||
+                                      _text[_at] == '\t'))
+        {
+            _at++;
+        }
+    }
+
+    /**
+     * Consumes c, terminates if the next character is anything else
+     * @param c expected character
+     */
+    void _expect(char c)
+    {
+        _skipSpace();
+        if (_at >= _text.size() || _text[_at] != c)
+        {
+            _fail();
+        }
+        _at++;
+    }
+
+    /**
+     * Consumes a literal such as true, terminates if it is not next
+     * @param word the literal
+     */
+    void _literal(const char *word)
+    {
+        std::string expected(word);
+        if (_text.compare(_at, expected.size(), expected) != 0)
+        {
+            _fail();
+        }
+        _at += expected.size();
+    }
+
+    JsonValue _value()
+    {
+        _skipSpace();
+        JsonValue value;
+        value.kind = JsonValue::Null;
+        value.number = 0;
+        if (_at >= _text.size())
+        {
+            _fail();
+        }
+        char c = _text[_at];
+        if (c == '{')
+        {
+            value.kind = JsonValue::Object;
+            _object(value);
+        }
+        else if (c == '[')
+        {
+            value.kind = JsonValue::Array;
+            _array(value);
+        }
+        else if (c == '"')
+        {
+            value.kind = JsonValue::String;
+            value.text = _string();
+        }
+        else if (c == 't' || c == 'f')
+        {
+            value.kind = JsonValue::Bool;
+            value.number = (c == 't') ? 1 : 0;
+            _literal((c == 't') ? "true" : "false");
+        }
+        else if (c == 'n')
+        {
+            _literal("null");
+        }
+        else
+        {
+            value.kind = JsonValue::Number;
+            value.number = _number();
+        }
+        return value;
+    }
+
+    void _object(JsonValue &value)
+    {
+        _expect('{');
+        _skipSpace();
+        if (_at < _text.size() && _text[_at] == '}')
+        {
+            _at++;
+            return;
+        }
+        while (true)
+        {
+            _skipSpace();
+            std::string key = _string();
+            _expect(':');
+            value.fields[key] = _value();
+            _skipSpace();
+            if (_at < _text.size() && _text[_at] == ',')
+            {
+                _at++;
+                continue;
+            }
+            _expect('}');
+            return;
+        }
+    }
+
+    void _array(JsonValue &value)
+    {
+        _expect('[');
+        _skipSpace();
+        if (_at < _text.size() && _text[_at] == ']')
+        {
+            _at++;
+            return;
+        }
+        while (true)
+        {
+            value.items.push_back(_value());
+            _skipSpace();
+            if (_at < _text.size() && _text[_at] == ',')
+            {
+                _at++;
+                continue;
+            }
+            _expect(']');
+            return;
+        }
+    }
+
+    std::string _string()
+    {
+        if (_at >= _text.size() || _text[_at] != '"')
+        {
+            _fail();
+        }
+        _at++;
+        std::string result;
+        while (_at < _text.size() && _text[_at] != '"')
+        {
+            char c = _text[_at++];
+            if (c == '\\' && _at < _text.size())
+            {
+                // benchmark names never hold escapes beyond the simple ones, \u is kept verbatim
+                char escaped = _text[_at++];
+                c = (escaped == 'n') ? '\n' : (escaped == 't') ? '\t' : escaped;
+                if (escaped == 'u')
+                {
+                    result += "\\u";
+                    continue;
+                }
+            }
+            result.push_back(c);
+        }
+        _expect('"');
+        return result;
+    }
+
+    double _number()
+    {
+        const char *start = _text.c_str() + _at;
+        char *end = nullptr;
+        double number = std::strtod(start, &end);
+        if (end == start)
+        {
+            _fail();
+        }
+        _at += (size_t) (end - start);
+        return number;
+    }
+};
+
+/**
+ * Nanoseconds in one time unit of Google Benchmark
+ * @param unit "ns", "us", "ms" or "s"
+ */
+static double unitNanoseconds(const std::string &unit)
+{
+    if (unit == "us")
+    {
+        return 1e3;
+    }
+    if (unit == "ms")
+    {
+        return 1e6;
+    }
+    return (unit == "s") ? 1e9 : 1.0;
+}
+
+/**
+ * Reads a run, the real time of every case in nanoseconds by name, in the order of the file
+ * @param path the JSON file
+ * @param order filled with the names in file order
+ * @return time of every case
+ */
+static std::map<std::string, double> readRun(const std::string &path, std::vector<std::string> &order)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << READ_FILE_ERROR << " " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    const std::string document = text.str();
+    JsonValue root = JsonParser(document, path).parse();
+    if (root.kind != JsonValue::Object || root.fields.count("benchmarks") == 0)
+    {
+        std::cerr << FORMAT_ERROR << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::map<std::string, double> times;
+    for (const JsonValue &bench : root.fields["benchmarks"].items)
+    {
+        std::map<std::string, JsonValue>::const_iterator name = bench.fields.find("run_name");
+        std::map<std::string, JsonValue>::const_iterator type = bench.fields.find("run_type");
+        std::map<std::string, JsonValue>::const_iterator time = bench.fields.find("real_time");
+        std::map<std::string, JsonValue>::const_iterator unit = bench.fields.find("time_unit");
+        if (name == bench.fields.end() || time == bench.fields.end())
+        {
+            continue;
+        }
+        // single runs are iterations, repeated runs are compared on their mean
+        bool aggregate = type != bench.fields.end() && type->second.text == "aggregate";
+        std::map<std::string, JsonValue>::const_iterator aggregateName = bench.fields.find("aggregate_name");
+        if (aggregate && (aggregateName == bench.fields.end() || aggregateName->second.text != "mean"))
+        {
+            continue;
+        }
+        if (!aggregate && times.count(name->second.text) != 0)
+        {
+            // a repetition of a case already seen, its mean follows
+            continue;
+        }
+        double nanoseconds = time->second.number *
+                             unitNanoseconds((unit != bench.fields.end()) ? unit->second.text : "ns");
+        if (times.count(name->second.text) == 0)
+        {
+            order.push_back(name->second.text);
+        }
+        times[name->second.text] = nanoseconds;
+    }
+    return times;
+}
+
+/**
+ * Formats a duration with a readable unit
+ * @param nanoseconds the duration
+ */
+static std::string formatTime(double nanoseconds)
+{
+    char text[32];
+    if (nanoseconds >= 1e9)
+    {
+        std::snprintf(text, sizeof(text), "%.3f s", nanoseconds / 1e9);
+    }
+    else if (nanoseconds >= 1e6)
+    {
+        std::snprintf(text, sizeof(text), "%.3f ms", nanoseconds / 1e6);
+    }
+    else if (nanoseconds >= 1e3)
+    {
+        std::snprintf(text, sizeof(text), "%.3f us", nanoseconds / 1e3);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.1f ns", nanoseconds);
+    }
+    return text;
+}
+
+int main(int argc, char *argv[])
+{
+    double threshold = DEFAULT_THRESHOLD;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg.compare(0, std::string(THRESHOLD_FLAG).size(), THRESHOLD_FLAG) == 0)
+        {
+            threshold = std::atof(arg.c_str() + std::string(THRESHOLD_FLAG).size());
+            continue;
+        }
+        paths.push_back(arg);
+    }
+    if (paths.size() != 2 || threshold < 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> baselineOrder;
+    std::vector<std::string> currentOrder;
+    std::map<std::string, double> baseline = readRun(paths[0], baselineOrder);
+    std::map<std::string, double> current = readRun(paths[1], currentOrder);
+
+    int regressions = 0;
+    int compared = 0;
+    std::printf("%-*s %14s %14s %8s\n", NAME_WIDTH, "case", "baseline", "current", "ratio");
+    for (const std::string &name : currentOrder)
+    {
+        std::map<std::string, double>::const_iterator before = baseline.find(name);
+        if (before == baseline.end())
+        {
+            std::printf("%-*s %14s %14s %8s\n", NAME_WIDTH, name.c_str(), "-",
+                        formatTime(current[name]).c_str(), "new");
+            continue;
+        }
+        double ratio = current[name] / before->second;
+        const char *flag = "";
+        if (ratio > 1 + threshold)
+        {
+            flag = "  REGRESSION";
+            regressions++;
+        }
+        else if (ratio < 1 - threshold)
+        {
+            flag = "  faster";
+        }
+        compared++;
+        std::printf("%-*s %14s %14s %7.2fx%s\n", NAME_WIDTH, name.c_str(), formatTime(before->second).c_str(),
+                    formatTime(current[name]).c_str(), ratio, flag);
+    }
+    for (const std::string &name : baselineOrder)
+    {
+        if (current.count(name) == 0)
+        {
+            std::printf("%-*s %14s %14s %8s\n", NAME_WIDTH, name.c_str(), formatTime(baseline[name]).c_str(),
+                        "-", "gone");
+        }
+    }
+    std::printf("%d cases compared, %d slower than the baseline by more than %.0f%%\n", compared, regressions,
+                threshold * 100);
+    return (regressions > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
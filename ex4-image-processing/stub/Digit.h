@@ -0,0 +1,18 @@
+// Digit.h
+
+#ifndef DIGIT_H
+#define DIGIT_H
+
+/**
+ * @struct Digit
+ * @brief Identified (by Mlp network) digit with the associated probability.
+ * @var value - Identified digit value
+ * @var probability - identification probability
+ */
+typedef struct Digit
+{
+    unsigned int value;
+    float probability;
+} Digit;
+
+#endif //DIGIT_H
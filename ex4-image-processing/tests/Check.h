@@ -0,0 +1,177 @@
+// Check.h
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * A minimal test harness without dependencies. TEST_CASE(name) defines a case, the CHECK macros
+ * report a failure with its location and let the case go on, RUN_TESTS() in main runs every case
+ * and returns non-zero if any check failed. CHECK_EXITS runs a statement in a forked child, for the
+ * error paths that terminate the process.
+ */
+
+/**
+ * @struct TestCase
+ * @brief A named test function
+ */
+typedef struct TestCase
+{
+    const char *name;
+    std::function<void()> body;
+} TestCase;
+
+/**
+ * Returns the cases of the executable, in definition order
+ */
+inline std::vector<TestCase> &testCases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+/**
+ * Returns the amount of failed checks so far
+ */
+inline int &testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+/**
+ * Reports a failed check
+ * @param file source file of the check
+ * @param line line of the check
+ * @param message what was expected
+ */
+inline void testFail(const char *file, int line, const std::string &message)
+{
+    std::cerr << file << ":" << line << ": check failed: " << message << std::endl;
+    testFailures()++;
+}
+
+/**
+ * Runs body in a forked child and collects what it writes to std::cerr
+ * @param body the code expected to terminate
+ * @param errors filled with the error output of the child
+ * @return true if the child exited with EXIT_FAILURE
+ */
+inline bool exitsWithFailure(const std::function<void()> &body, std::string &errors)
+{
+    int channel[2];
+    if (pipe(channel) != 0)
+    {
+        return false;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        close(channel[0]);
+        dup2(channel[1], STDERR_FILENO);
+        body();
+        // the body returned, which is a failure of its own
+        _exit(EXIT_SUCCESS);
+    }
+    close(channel[1]);
+    char buffer[256];
+    ssize_t length;
+    while ((length = read(channel[0], buffer, sizeof(buffer))) > 0)
+    {
+        errors.append(buffer, (size_t) length);
+    }
+    close(channel[0]);
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) != child)
+    {
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+/**
+ * Registers a case at static initialization
+ */
+class TestRegistration
+{
+public:
+    TestRegistration(const char *name, std::function<void()> body)
+    {
+        testCases().push_back(TestCase{name, std::move(body)});
+    }
+};
+
+/**
+ * Runs every case, prints a line per case
+ * @return the exit status, 0 if every check passed
+ */
+inline int runTests()
+{
+    for (const TestCase &test : testCases())
+    {
+        const int before = testFailures();
+        test.body();
+        std::cout << ((testFailures() == before) ? "[ OK ] " : "[FAIL] ") << test.name << std::endl;
+    }
+    std::cout << testCases().size() << " cases, " << testFailures() << " failed checks" << std::endl;
+    return (testFailures() == 0) ? 0 : 1;
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            testFail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do \
+    { \
+        if (!((actual) == (expected))) \
+        { \
+            testFail(__FILE__, __LINE__, std::string(#actual " == " #expected ", got ") + \
+                                         std::to_string(actual) + " and " + std::to_string(expected)); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do \
+    { \
+        if (!(std::fabs((double) (actual) - (double) (expected)) <= (double) (tolerance))) \
+        { \
+            testFail(__FILE__, __LINE__, std::string(#actual " within " #tolerance " of " #expected ", got ") + \
+                                         std::to_string(actual) + " and " + std::to_string(expected)); \
+        } \
+    } while (0)
+
+#define CHECK_EXITS(statement, message) \
+    do \
+    { \
+        std::string errors; \
+        if (!exitsWithFailure([&]() { statement; }, errors) || errors.find(message) == std::string::npos) \
+        { \
+            testFail(__FILE__, __LINE__, std::string(#statement " exits with " #message ", got ") + errors); \
+        } \
+    } while (0)
+
+#define RUN_TESTS() runTests()
+
+#endif //CHECK_H
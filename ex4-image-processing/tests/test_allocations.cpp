@@ -0,0 +1,215 @@
+// test_allocations.cpp
+//
+// Counts the Matrix buffers taken from defaultMatrixPool(): moves hand the buffer over, += works in
+// place, a forward pass of MlpNetwork allocates the output of every layer and nothing else, one of
+// MlpGraph allocates nothing at all, and a product split across threads takes pages of its own
+// instead of a pooled buffer, the same pages again when the shape repeats.
+
+#include "MlpNetwork.h"
+#include "MlpGraph.h"
+#include "Gemm.h"
+#include "Check.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// every operator new of the process, counted by the replacements below
+static std::atomic<size_t> heapAllocations(0);
+
+void *operator new(size_t size)
+{
+    heapAllocations++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * A rows × cols matrix with small deterministic values
+ * @param rows positive number
+ * @param cols positive number
+ * @return the matrix
+ */
+static Matrix filled(int rows, int cols)
+{
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = (float) ((i * 7) % 13 - 6) / (float) (cols * 4);
+    }
+    return m;
+}
+
+/**
+ * Allocations of the default pool since the last resetStats
+ */
+static size_t allocations()
+{
+    return defaultMatrixPool().getStats().allocationCount;
+}
+
+TEST_CASE(MoveConstructionTakesTheBuffer)
+{
+    Matrix a = filled(64, 64);
+    const float *buffer = a.data();
+    defaultMatrixPool().resetStats();
+    Matrix b(std::move(a));
+    CHECK_EQ(allocations(), (size_t) 0);
+    CHECK(b.data() == buffer);
+    CHECK(a.data() == nullptr);
+}
+
+TEST_CASE(MoveAssignmentTakesTheBuffer)
+{
+    Matrix a = filled(64, 64);
+    Matrix b = filled(8, 8);
+    const float *buffer = a.data();
+    defaultMatrixPool().resetStats();
+    b = std::move(a);
+    CHECK_EQ(allocations(), (size_t) 0);
+    CHECK(b.data() == buffer);
+    CHECK_EQ(b.getRows(), 64);
+}
+
+TEST_CASE(PlusEqualsIsInPlace)
+{
+    Matrix a = filled(128, 1);
+    const Matrix b = filled(128, 1);
+    const float before = a[5];
+    defaultMatrixPool().resetStats();
+    a += b;
+    CHECK_EQ(allocations(), (size_t) 0);
+    CHECK_EQ(a[5], before + b[5]);
+}
+
+TEST_CASE(ForwardPassAllocatesOnlyTheLayerOutputs)
+{
+    Matrix weights[MLP_SIZE];
+    Matrix biases[MLP_SIZE];
+    for (int i = 0; i < MLP_SIZE; i++)
+    {
+        weights[i] = filled(weightsDims[i].rows, weightsDims[i].cols);
+        biases[i] = filled(biasDims[i].rows, biasDims[i].cols);
+    }
+    const MlpNetwork network(weights, biases);
+    const Matrix img = filled(imgDims.rows * imgDims.cols, 1);
+    // the first pass may set up per thread scratch space
+    const Digit expected = network(img);
+
+    defaultMatrixPool().resetStats();
+    const Digit digit = network(img);
+    CHECK_EQ(allocations(), (size_t) MLP_SIZE);
+    CHECK_EQ(digit.value, expected.value);
+    CHECK_EQ(digit.probability, expected.probability);
+}
+
+TEST_CASE(GraphForwardPassAllocatesNothing)
+{
+    // six layers, wider in the middle than at the input, so the arena is not sized by the first layer
+    const int widths[] = {784, 1024, 300, 64, 48, 32, 10};
+    const int depth = 6;
+    std::vector<Dense> layers;
+    for (int i = 0; i < depth; i++)
+    {
+        layers.emplace_back(filled(widths[i + 1], widths[i]), filled(widths[i + 1], 1),
+                            (i == depth - 1) ? Softmax : Relu);
+    }
+    const MlpGraph graph(std::move(layers));
+    CHECK_EQ(graph.getLayerCount(), depth);
+    const Matrix img = filled(784, 1);
+    Matrix output(10, 1);
+    // the first pass grows the arena of this thread
+    const Digit expected = graph(img);
+    graph.forward(img.data(), output.data());
+
+    defaultMatrixPool().resetStats();
+    const size_t heapBefore = heapAllocations;
+    for (int pass = 0; pass < 4; pass++)
+    {
+        graph.forward(img.data(), output.data());
+        const Digit digit = graph(img);
+        CHECK_EQ(digit.value, expected.value);
+        CHECK_EQ(digit.probability, expected.probability);
+    }
+    CHECK_EQ(allocations(), (size_t) 0);
+    CHECK_EQ(heapAllocations - heapBefore, (size_t) 0);
+    CHECK_EQ(output[expected.value], expected.probability);
+}
+
+TEST_CASE(ParallelProductBypassesThePool)
+{
+    const Matrix a = filled(256, 192);
+    const Matrix b = filled(192, 160);
+    setGemmThreads(1);
+    const Matrix expected = a * b;
+    setGemmThreads(4);
+    CHECK(gemmRunsParallel(256, 160, 192));
+    defaultMatrixPool().resetStats();
+    const Matrix product = a * b;
+    const Matrix sum = a * b + expected;
+    CHECK_EQ(allocations(), (size_t) 0);
+    // under the threshold the pool still serves the product
+    const Matrix small = filled(8, 8) * filled(8, 8);
+    CHECK_EQ(allocations(), (size_t) 3);
+    setGemmThreads(0);
+    for (int i = 0; i < product.size(); i++)
+    {
+        CHECK_EQ(product[i], expected[i]);
+        CHECK_NEAR(sum[i], 2 * expected[i], 1e-5);
+    }
+}
+
+TEST_CASE(RepeatedParallelProductReusesItsPages)
+{
+    const Matrix a = filled(256, 192);
+    const Matrix b = filled(192, 160);
+    setGemmThreads(4);
+    PageAllocator &pages = pageMatrixAllocator();
+    pages.trim();
+    const float *first = nullptr;
+    {
+        const Matrix product = a * b;
+        first = product.data();
+    }
+    pages.resetStats();
+    const Matrix again = a * b;
+    const AllocatorStats stats = pages.getStats();
+    CHECK_EQ(stats.allocationCount, (size_t) 1);
+    CHECK_EQ(stats.poolHits, (size_t) 1);
+    CHECK(again.data() == first);
+    // another size maps fresh pages, and the cache never holds more than PAGE_CACHE_BLOCKS blocks
+    const Matrix other = filled(256, 160) * filled(160, 160);
+    CHECK_EQ(pages.getStats().poolHits, (size_t) 1);
+    for (int i = 0; i < 2 * PAGE_CACHE_BLOCKS; i++)
+    {
+        pages.deallocate(pages.allocate(1024 * (i + 1)), 1024 * (i + 1));
+    }
+    // the last PAGE_CACHE_BLOCKS released are the ones kept
+    size_t kept = 0;
+    for (int i = PAGE_CACHE_BLOCKS; i < 2 * PAGE_CACHE_BLOCKS; i++)
+    {
+        kept += 1024 * (i + 1) * sizeof(float);
+    }
+    CHECK_EQ(pages.getStats().bytesCached, kept);
+    pages.trim();
+    CHECK_EQ(pages.getStats().bytesCached, (size_t) 0);
+    setGemmThreads(0);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,162 @@
+// test_image_stream.cpp
+//
+// ImageStream over small files of both layouts, in chunks that do not divide the image count: every
+// image arrives once and in order, and a file cut short under the stream fails on the caller's next().
+
+#include "ImageStream.h"
+#include "Check.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define RAW_FILE "test_image_stream.raw"
+#define IDX_FILE "test_image_stream.idx"
+#define IMAGE_SIZE 12
+#define IMAGE_COUNT 10
+#define CHUNK 3
+#define READ_FILE_ERROR "problem with the file"
+
+/**
+ * Pixel i of image n, a byte value so that both layouts can hold it
+ */
+static int pixel(int n, int i)
+{
+    return (n * 31 + i * 7) % 256;
+}
+
+/**
+ * Writes count raw float images of IMAGE_SIZE floats
+ */
+static void writeRaw(int count)
+{
+    std::ofstream file(RAW_FILE, std::ios::binary | std::ios::trunc);
+    for (int n = 0; n < count; n++)
+    {
+        for (int i = 0; i < IMAGE_SIZE; i++)
+        {
+            const float value = (float) pixel(n, i);
+            file.write((const char *) &value, sizeof(value));
+        }
+    }
+}
+
+/**
+ * Writes an idx3 file of count 3 × 4 images
+ */
+static void writeIdx(int count)
+{
+    const unsigned char header[] = {0, 0, 8, 3, 0, 0, 0, (unsigned char) count, 0, 0, 0, 3, 0, 0, 0, 4};
+    std::ofstream file(IDX_FILE, std::ios::binary | std::ios::trunc);
+    file.write((const char *) header, sizeof(header));
+    for (int n = 0; n < count; n++)
+    {
+        for (int i = 0; i < IMAGE_SIZE; i++)
+        {
+            file.put((char) pixel(n, i));
+        }
+    }
+}
+
+/**
+ * Reads a whole stream and checks every pixel against what was written
+ * @param stream the stream
+ * @param divisor what a written pixel is divided by on the way in
+ * @return the amount of images read
+ */
+static int drain(ImageStream &stream, float divisor)
+{
+    int n = 0;
+    const float *images = nullptr;
+    int count;
+    while ((count = stream.next(images)) > 0)
+    {
+        CHECK(count <= CHUNK);
+        for (int j = 0; j < count; j++, n++)
+        {
+            for (int i = 0; i < IMAGE_SIZE; i++)
+            {
+                CHECK_EQ(images[j * IMAGE_SIZE + i], (float) pixel(n, i) / divisor);
+            }
+        }
+    }
+    return n;
+}
+
+TEST_CASE(RawFilesAreStreamed)
+{
+    writeRaw(IMAGE_COUNT);
+    {
+        ImageStream stream(RAW_FILE, IMAGE_SIZE, CHUNK);
+        CHECK_EQ(stream.getImageCount(), IMAGE_COUNT);
+        CHECK_EQ(stream.getImageSize(), IMAGE_SIZE);
+        CHECK_EQ(drain(stream, 1.0f), IMAGE_COUNT);
+        // the end is reported again on every later call
+        const float *images = nullptr;
+        CHECK_EQ(stream.next(images), 0);
+    }
+    std::remove(RAW_FILE);
+}
+
+TEST_CASE(IdxFilesAreStreamed)
+{
+    writeIdx(IMAGE_COUNT);
+    {
+        // the image size of an idx file comes from its header
+        ImageStream stream(IDX_FILE, 1, CHUNK);
+        CHECK_EQ(stream.getImageCount(), IMAGE_COUNT);
+        CHECK_EQ(stream.getImageSize(), IMAGE_SIZE);
+        CHECK_EQ(drain(stream, 255.0f), IMAGE_COUNT);
+    }
+    std::remove(IDX_FILE);
+}
+
+TEST_CASE(EmptyFileEndsAtOnce)
+{
+    writeRaw(0);
+    {
+        ImageStream stream(RAW_FILE, IMAGE_SIZE, CHUNK);
+        const float *images = nullptr;
+        CHECK_EQ(stream.getImageCount(), 0);
+        CHECK_EQ(stream.next(images), 0);
+    }
+    std::remove(RAW_FILE);
+}
+
+TEST_CASE(StoppingEarlyJoinsTheReader)
+{
+    writeRaw(IMAGE_COUNT);
+    {
+        ImageStream stream(RAW_FILE, IMAGE_SIZE, CHUNK);
+        const float *images = nullptr;
+        CHECK_EQ(stream.next(images), CHUNK);
+    }
+    std::remove(RAW_FILE);
+}
+
+/**
+ * Opens a stream of one image per chunk, empties the file under it and reads on
+ */
+static void readCutShort()
+{
+    ImageStream stream(RAW_FILE, IMAGE_SIZE, 1);
+    // the reader is at most two chunks ahead, the rest of the file is gone when it gets there
+    std::ofstream cut(RAW_FILE, std::ios::binary | std::ios::trunc);
+    cut.close();
+    const float *images = nullptr;
+    while (stream.next(images) > 0)
+    {
+    }
+}
+
+TEST_CASE(FileCutShortFailsOnNext)
+{
+    writeRaw(IMAGE_COUNT);
+    CHECK_EXITS(readCutShort(), READ_FILE_ERROR);
+    std::remove(RAW_FILE);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
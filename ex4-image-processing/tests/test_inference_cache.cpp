@@ -0,0 +1,202 @@
+// test_inference_cache.cpp
+//
+// InferenceCache in front of a small random network: the hit, miss and eviction counters, the
+// capacity as a bound on the total, least recently used eviction within a shard, and lookups from
+// several threads at once.
+
+#include "InferenceCache.h"
+#include "Check.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+#define IMG_SIZE (imgDims.rows * imgDims.cols)
+#define THREADS 4
+#define ROUNDS 20
+
+/**
+ * A network of the weightsDims shapes with random weights
+ */
+static MlpNetwork makeNetwork()
+{
+    std::mt19937 random(17);
+    Matrix weights[MLP_SIZE];
+    Matrix biases[MLP_SIZE];
+    for (int i = 0; i < MLP_SIZE; i++)
+    {
+        std::uniform_real_distribution<float> uniform(-1.0f / weightsDims[i].cols, 1.0f / weightsDims[i].cols);
+        weights[i] = Matrix(weightsDims[i].rows, weightsDims[i].cols);
+        biases[i] = Matrix(biasDims[i].rows, biasDims[i].cols);
+        for (int j = 0; j < weights[i].size(); j++)
+        {
+            weights[i][j] = uniform(random);
+        }
+    }
+    return MlpNetwork(weights, biases);
+}
+
+/**
+ * Image number n, every n gives a different image
+ */
+static Matrix image(int n)
+{
+    Matrix img(IMG_SIZE, 1);
+    for (int i = 0; i < img.size(); i++)
+    {
+        img[i] = (float) ((i * 13 + n * 7) % 29) / 29.0f;
+    }
+    img[0] = (float) n;
+    return img;
+}
+
+/**
+ * The shard an image falls into, for a cache of more than CACHE_SHARDS entries: the high half of
+ * its hash modulo the shards
+ */
+static uint64_t shardOf(const Matrix &img)
+{
+    return (InferenceCache::hashImage(img.data(), img.size()) >> 32) % CACHE_SHARDS;
+}
+
+TEST_CASE(CountersFollowTheLookups)
+{
+    const MlpNetwork network = makeNetwork();
+    InferenceCache cache(network, 64);
+    const Matrix a = image(1);
+    const Matrix b = image(2);
+    const Digit first = cache(a);
+    const Digit second = cache(a);
+    cache(b);
+    CHECK_EQ(first.value, network(a).value);
+    CHECK_EQ(second.value, first.value);
+    CHECK_EQ(second.probability, first.probability);
+    CacheStats stats = cache.getStats();
+    CHECK_EQ(stats.hits, (uint64_t) 1);
+    CHECK_EQ(stats.misses, (uint64_t) 2);
+    CHECK_EQ(stats.evictions, (uint64_t) 0);
+    CHECK_EQ(stats.entries, (size_t) 2);
+
+    // a batch looks up every image, the repeated one included
+    std::vector<float> images;
+    for (int n : {1, 3, 3, 2})
+    {
+        const Matrix img = image(n);
+        images.insert(images.end(), img.data(), img.data() + img.size());
+    }
+    const std::vector<Digit> digits = cache.classify(images.data(), 4);
+    CHECK_EQ(digits[1].value, network(image(3)).value);
+    stats = cache.getStats();
+    CHECK_EQ(stats.hits, (uint64_t) 3);
+    CHECK_EQ(stats.misses, (uint64_t) 4);
+    CHECK_EQ(stats.entries, (size_t) 3);
+
+    cache.clear();
+    stats = cache.getStats();
+    CHECK_EQ(stats.entries, (size_t) 0);
+    CHECK_EQ(stats.hits, (uint64_t) 3);
+}
+
+TEST_CASE(CapacityBoundsTheTotal)
+{
+    const MlpNetwork network = makeNetwork();
+    for (size_t capacity : {1, 5, 16, 40})
+    {
+        InferenceCache cache(network, capacity);
+        for (int n = 0; n < 200; n++)
+        {
+            cache(image(n));
+        }
+        const CacheStats stats = cache.getStats();
+        CHECK(stats.entries <= capacity);
+        CHECK_EQ(stats.evictions, (uint64_t) (200 - stats.entries));
+    }
+    // one entry is one entry: the last image is kept, the one before is gone
+    InferenceCache single(network, 1);
+    single(image(1));
+    single(image(2));
+    single(image(2));
+    single(image(1));
+    const CacheStats stats = single.getStats();
+    CHECK_EQ(stats.entries, (size_t) 1);
+    CHECK_EQ(stats.hits, (uint64_t) 1);
+    CHECK_EQ(stats.misses, (uint64_t) 3);
+}
+
+TEST_CASE(LeastRecentlyUsedIsEvicted)
+{
+    // CACHE_SHARDS + 1 entries: shard 0 holds two, every other shard one
+    const MlpNetwork network = makeNetwork();
+    InferenceCache cache(network, CACHE_SHARDS + 1);
+    std::vector<Matrix> sameShard;
+    for (int n = 0; sameShard.size() < 3; n++)
+    {
+        Matrix img = image(n);
+        if (shardOf(img) == 0)
+        {
+            sameShard.push_back(std::move(img));
+        }
+    }
+    cache(sameShard[0]);
+    cache(sameShard[1]);
+    // the first image becomes the most recently used, the third one evicts the second
+    cache(sameShard[0]);
+    cache(sameShard[2]);
+    CacheStats stats = cache.getStats();
+    CHECK_EQ(stats.evictions, (uint64_t) 1);
+    CHECK_EQ(stats.hits, (uint64_t) 1);
+    cache(sameShard[0]);
+    CHECK_EQ(cache.getStats().hits, (uint64_t) 2);
+    cache(sameShard[1]);
+    stats = cache.getStats();
+    CHECK_EQ(stats.hits, (uint64_t) 2);
+    CHECK_EQ(stats.evictions, (uint64_t) 2);
+}
+
+TEST_CASE(ConcurrentLookups)
+{
+    const MlpNetwork network = makeNetwork();
+    const int distinct = 48;
+    std::vector<Matrix> images;
+    std::vector<Digit> expected;
+    for (int n = 0; n < distinct; n++)
+    {
+        images.push_back(image(n));
+        expected.push_back(network(images.back()));
+    }
+    InferenceCache cache(network, 32);
+    std::vector<int> wrong(THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 for (int round = 0; round < ROUNDS; round++)
+                                 {
+                                     for (int n = 0; n < distinct; n++)
+                                     {
+                                         const int k = (n * (t + 1) + round) % distinct;
+                                         const Digit digit = cache(images[k]);
+                                         wrong[t] += (digit.value != expected[k].value ||
+                                                      digit.probability != expected[k].probability);
+                                     }
+                                 }
+                             });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    for (int t = 0; t < THREADS; t++)
+    {
+        CHECK_EQ(wrong[t], 0);
+    }
+    const CacheStats stats = cache.getStats();
+    CHECK_EQ(stats.hits + stats.misses, (uint64_t) THREADS * ROUNDS * distinct);
+    CHECK(stats.hits > 0);
+    CHECK(stats.entries <= (size_t) 32);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,183 @@
+// test_mapped_model.cpp
+//
+// Model files of MappedModel.h: a graph written and mapped back gives the same layers and the same
+// answers, and truncated or corrupt files fail with an error before any of their layers is used.
+
+#include "MappedModel.h"
+#include "MlpGraph.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define MODEL_FILE "test_mapped_model.mlpm"
+#define READ_FILE_ERROR "problem with the file"
+#define WRITE_FILE_ERROR "could not write the model file"
+#define FORMAT_ERROR "invalid model file"
+
+static const int WIDTHS[] = {20, 17, 9, 4};
+static const int DEPTH = 3;
+
+/**
+ * A rows × cols matrix with small deterministic values
+ */
+static Matrix filled(int rows, int cols, int seed)
+{
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = (float) ((i * 11 + seed) % 17 - 8) / 16.0f;
+    }
+    return m;
+}
+
+/**
+ * A graph of the WIDTHS shapes, ReLU then a softmax output
+ */
+static MlpGraph makeGraph()
+{
+    std::vector<Dense> layers;
+    for (int i = 0; i < DEPTH; i++)
+    {
+        layers.emplace_back(filled(WIDTHS[i + 1], WIDTHS[i], i), filled(WIDTHS[i + 1], 1, 7 + i),
+                            (i + 1 == DEPTH) ? Softmax : Relu);
+    }
+    return MlpGraph(std::move(layers));
+}
+
+/**
+ * The bytes of the model file of makeGraph()
+ */
+static std::string modelBytes()
+{
+    MappedModel::write(MODEL_FILE, makeGraph());
+    std::ifstream file(MODEL_FILE, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/**
+ * Maps a model file holding the given bytes and reads every layer
+ */
+static void mapBytes(const std::string &bytes)
+{
+    {
+        std::ofstream file(MODEL_FILE, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), (std::streamsize) bytes.size());
+    }
+    const MappedModel model(MODEL_FILE);
+    for (int i = 0; i < model.getLayerCount(); i++)
+    {
+        model.getWeights(i);
+        model.getBias(i);
+    }
+}
+
+/**
+ * The bytes of a valid model with the entry of layer 1 changed
+ * @param change edits the entry
+ */
+template<class F>
+static std::string withLayerEntry(F change)
+{
+    std::string bytes = modelBytes();
+    ModelLayerEntry entry;
+    const size_t offset = sizeof(ModelFileHeader) + sizeof(ModelLayerEntry);
+    std::memcpy(&entry, &bytes[offset], sizeof(entry));
+    change(entry);
+    std::memcpy(&bytes[offset], &entry, sizeof(entry));
+    return bytes;
+}
+
+TEST_CASE(ModelRoundTrip)
+{
+    const MlpGraph graph = makeGraph();
+    MappedModel::write(MODEL_FILE, graph);
+    {
+        const MappedModel model(MODEL_FILE);
+        CHECK_EQ(model.getLayerCount(), DEPTH);
+        for (int i = 0; i < DEPTH; i++)
+        {
+            const Matrix w = model.getWeights(i);
+            const Matrix b = model.getBias(i);
+            CHECK(w.isView());
+            CHECK_EQ(w.getRows(), WIDTHS[i + 1]);
+            CHECK_EQ(w.getCols(), WIDTHS[i]);
+            CHECK_EQ(b.getCols(), 1);
+            CHECK((uintptr_t) w.data() % MODEL_ALIGNMENT == 0);
+            CHECK(std::memcmp(w.data(), graph.getLayer(i).getWeights().data(), w.size() * sizeof(float)) == 0);
+            CHECK(std::memcmp(b.data(), graph.getLayer(i).getBias().data(), b.size() * sizeof(float)) == 0);
+            CHECK_EQ(model.getActivation(i), graph.getLayer(i).getActivation().getActivationType());
+        }
+        const MlpGraph mapped(model);
+        for (int n = 0; n < 8; n++)
+        {
+            const Matrix input = filled(WIDTHS[0], 1, 30 + n);
+            const Digit expected = graph(input);
+            const Digit digit = mapped(input);
+            CHECK_EQ(digit.value, expected.value);
+            CHECK_EQ(digit.probability, expected.probability);
+        }
+    }
+    std::remove(MODEL_FILE);
+}
+
+TEST_CASE(TruncatedModelsFail)
+{
+    const std::string bytes = modelBytes();
+    for (size_t length : {(size_t) 0, sizeof(ModelFileHeader) - 1, sizeof(ModelFileHeader) + 8, bytes.size() / 2,
+                          bytes.size() - 1})
+    {
+        CHECK_EXITS(mapBytes(bytes.substr(0, length)), FORMAT_ERROR);
+    }
+    std::remove(MODEL_FILE);
+}
+
+TEST_CASE(CorruptModelsFail)
+{
+    std::string bytes = modelBytes();
+    bytes[0] = 'X';
+    CHECK_EXITS(mapBytes(bytes), FORMAT_ERROR);
+
+    // the version is where a file of the other byte order shows
+    bytes = modelBytes();
+    ModelFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    header.version = 0x01000000;
+    std::memcpy(&bytes[0], &header, sizeof(header));
+    CHECK_EXITS(mapBytes(bytes), FORMAT_ERROR);
+    header.version = MODEL_VERSION;
+    for (uint32_t count : {0u, 1000000u})
+    {
+        header.layerCount = count;
+        std::memcpy(&bytes[0], &header, sizeof(header));
+        CHECK_EXITS(mapBytes(bytes), FORMAT_ERROR);
+    }
+
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.rows = -e.rows; })), FORMAT_ERROR);
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.cols = 0; })), FORMAT_ERROR);
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.activation = 7; })), FORMAT_ERROR);
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.weightsOffset += 4; })), FORMAT_ERROR);
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.biasOffset = 1ull << 40; })), FORMAT_ERROR);
+    // weights running past the end of the file
+    CHECK_EXITS(mapBytes(withLayerEntry([](ModelLayerEntry &e) { e.rows = 1 << 20; })), FORMAT_ERROR);
+    std::remove(MODEL_FILE);
+}
+
+TEST_CASE(MissingModelFails)
+{
+    std::remove(MODEL_FILE);
+    CHECK_EXITS(MappedModel model(MODEL_FILE), READ_FILE_ERROR);
+}
+
+TEST_CASE(UnwritableModelFails)
+{
+    CHECK_EXITS(MappedModel::write("no-such-directory/model.mlpm", makeGraph()), WRITE_FILE_ERROR);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
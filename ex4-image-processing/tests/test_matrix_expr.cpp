@@ -0,0 +1,153 @@
+// test_matrix_expr.cpp
+//
+// The lazy arithmetic of MatrixExpr.h read in place: an expression printed, indexed, plain printed
+// and vectorized gives what the same expression assigned to a Matrix gives. Temporary operands make
+// the operators return a Matrix, which is safe to keep with auto.
+
+#include "Matrix.h"
+#include "Check.h"
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+/**
+ * A rows × cols matrix with small deterministic values
+ * @param rows positive number
+ * @param cols positive number
+ * @param seed varies the values
+ * @return the matrix
+ */
+static Matrix filled(int rows, int cols, int seed)
+{
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = (float) ((i * 7 + seed) % 13 - 6) / 8.0f;
+    }
+    return m;
+}
+
+/**
+ * What plainPrint writes to std::cout
+ * @param print calls plainPrint
+ */
+template<class F>
+static std::string captured(F print)
+{
+    std::ostringstream text;
+    std::streambuf *previous = std::cout.rdbuf(text.rdbuf());
+    print();
+    std::cout.rdbuf(previous);
+    return text.str();
+}
+
+TEST_CASE(ProductIsPrinted)
+{
+    const Matrix a = filled(4, 3, 1);
+    const Matrix b = filled(3, 5, 2);
+    const Matrix product = a * b;
+    std::ostringstream expected;
+    std::ostringstream actual;
+    expected << product;
+    actual << a * b;
+    CHECK(actual.str() == expected.str());
+}
+
+TEST_CASE(ExpressionsArePlainPrinted)
+{
+    const Matrix a = filled(4, 4, 3);
+    const Matrix b = filled(4, 4, 4);
+    const Matrix product = a * b;
+    const Matrix sum = a + b;
+    CHECK(captured([&]() { (a * b).plainPrint(); }) == captured([&]() { product.plainPrint(); }));
+    CHECK(captured([&]() { (a + b).plainPrint(); }) == captured([&]() { sum.plainPrint(); }));
+}
+
+TEST_CASE(SumIsVectorized)
+{
+    const Matrix a = filled(3, 4, 5);
+    const Matrix b = filled(3, 4, 6);
+    const Matrix vector = (a + b).vectorize();
+    CHECK_EQ(vector.getRows(), 12);
+    CHECK_EQ(vector.getCols(), 1);
+    for (int i = 0; i < vector.size(); i++)
+    {
+        CHECK_EQ(vector[i], a[i] + b[i]);
+    }
+}
+
+TEST_CASE(ExpressionsAreIndexed)
+{
+    const Matrix a = filled(5, 3, 7);
+    const Matrix b = filled(3, 2, 8);
+    const Matrix product = a * b;
+    for (int i = 0; i < a.getRows(); i++)
+    {
+        for (int j = 0; j < a.getCols(); j++)
+        {
+            CHECK_EQ((2 * a)(i, j), 2 * a(i, j));
+            CHECK_EQ((a + a)[i * a.getCols() + j], a(i, j) + a(i, j));
+        }
+        for (int j = 0; j < b.getCols(); j++)
+        {
+            CHECK_EQ((a * b)(i, j), product(i, j));
+        }
+    }
+}
+
+TEST_CASE(StoredExpressionReadsItsOperands)
+{
+    const Matrix a = filled(2, 2, 9);
+    const Matrix b = filled(2, 2, 10);
+    const auto sum = a + 0.5f * b;
+    const Matrix value = sum;
+    for (int i = 0; i < value.size(); i++)
+    {
+        CHECK_EQ(sum[i], value[i]);
+        CHECK_EQ(value[i], a[i] + 0.5f * b[i]);
+    }
+}
+
+TEST_CASE(TemporaryOperandsAreEvaluatedAtOnce)
+{
+    const Matrix a = filled(6, 5, 11);
+    const Matrix b = filled(5, 4, 12);
+    const Matrix c = filled(6, 5, 13);
+    static_assert(std::is_same<decltype(filled(6, 5, 1) * b), Matrix>::value, "product of a temporary");
+    static_assert(std::is_same<decltype(a * filled(5, 4, 1)), Matrix>::value, "product of a temporary");
+    static_assert(std::is_same<decltype(filled(6, 5, 1) + a), Matrix>::value, "sum with a temporary");
+    static_assert(std::is_same<decltype(a + c + filled(6, 5, 1)), Matrix>::value, "sum with a temporary");
+    static_assert(std::is_same<decltype(2.0f * filled(6, 5, 1)), Matrix>::value, "scaled temporary");
+    static_assert(std::is_same<decltype(a * b), ProductExpr>::value, "lvalues stay lazy");
+
+    // kept with auto, the temporaries are gone by the time these are read
+    const auto product = filled(6, 5, 11) * b;
+    const auto sum = a + filled(6, 5, 13);
+    const auto scaled = filled(6, 5, 11) * 3.0f;
+    const auto both = filled(6, 5, 11) + filled(6, 5, 13);
+    const Matrix expectedProduct = a * b;
+    for (int i = 0; i < product.size(); i++)
+    {
+        CHECK_EQ(product[i], expectedProduct[i]);
+    }
+    for (int i = 0; i < a.size(); i++)
+    {
+        CHECK_EQ(sum[i], a[i] + c[i]);
+        CHECK_EQ(both[i], a[i] + c[i]);
+        CHECK_EQ(scaled[i], a[i] * 3.0f);
+    }
+}
+
+TEST_CASE(SumWithATemporaryReusesItsBuffer)
+{
+    const Matrix a = filled(8, 8, 14);
+    Matrix t = filled(8, 8, 15);
+    const float *buffer = t.data();
+    const Matrix sum = std::move(t) + a;
+    CHECK(sum.data() == buffer);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,211 @@
+// test_matrix_io.cpp
+//
+// The binary matrix files of MatrixIO.h: raw and compressed round trips, the LZ codec on its own, and
+// damaged files, which must fail with an error before anything the header claims is allocated.
+
+#include "MatrixIO.h"
+#include "Check.h"
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#define ENTRY_OFFSET MATRIX_FILE_ALIGNMENT
+#define FILE_ERROR "problem with the file"
+#define FORMAT_ERROR "invalid matrix file"
+#define LARGEST_EXPECTED_ALLOCATION (1 << 20)
+
+/**
+ * A rows × cols matrix, half of it zeros so that it compresses
+ * @param rows positive number
+ * @param cols positive number
+ * @param seed varies the values
+ */
+static Matrix filled(int rows, int cols, int seed)
+{
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = (i % 2 == 0) ? 0.0f : (float) ((i * 31 + seed) % 97 - 48) / 7.0f;
+    }
+    return m;
+}
+
+/**
+ * Checks that two matrices hold the same shape and the same bits
+ */
+static bool identical(const Matrix &a, const Matrix &b)
+{
+    return a.getRows() == b.getRows() && a.getCols() == b.getCols() &&
+           std::memcmp(a.data(), b.data(), (size_t) a.size() * sizeof(float)) == 0;
+}
+
+/**
+ * The bytes of a file holding the matrices
+ */
+static std::string fileOf(const std::vector<Matrix> &matrices, MatrixCompression compression)
+{
+    std::ostringstream output;
+    writeMatrices(output, matrices, compression);
+    return output.str();
+}
+
+/**
+ * The bytes of a valid single matrix file with its entry replaced
+ * @param entry the entry to store
+ */
+static std::string withEntry(const MatrixEntry &entry)
+{
+    std::vector<Matrix> matrices;
+    matrices.push_back(filled(4, 4, 1));
+    std::string bytes = fileOf(matrices, NoCompression);
+    std::memcpy(&bytes[ENTRY_OFFSET], &entry, sizeof(entry));
+    return bytes;
+}
+
+/**
+ * Hands out small buffers from the pool, terminates on any allocation a damaged file must not cause
+ */
+class RefusingAllocator : public MatrixAllocator
+{
+public:
+    float *allocate(size_t count) override
+    {
+        if (count > LARGEST_EXPECTED_ALLOCATION)
+        {
+            std::cerr << "allocated " << count << " floats" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return defaultMatrixPool().allocate(count);
+    }
+
+    void deallocate(float *buffer, size_t count) override
+    {
+        defaultMatrixPool().deallocate(buffer, count);
+    }
+};
+
+/**
+ * Reads a file with the refusing allocator installed
+ * @param bytes the file
+ */
+static void readRefusing(const std::string &bytes)
+{
+    static RefusingAllocator refusing;
+    Matrix::setAllocator(&refusing);
+    std::istringstream input(bytes);
+    readMatrices(input);
+}
+
+TEST_CASE(RawRoundTrip)
+{
+    std::vector<Matrix> matrices;
+    matrices.push_back(filled(1, 1, 1));
+    matrices.push_back(filled(3, 17, 2));
+    matrices.push_back(filled(128, 784, 3));
+    std::istringstream input(fileOf(matrices, NoCompression));
+    const std::vector<Matrix> read = readMatrices(input);
+    CHECK_EQ(read.size(), matrices.size());
+    for (size_t i = 0; i < read.size() && i < matrices.size(); i++)
+    {
+        CHECK(identical(read[i], matrices[i]));
+    }
+}
+
+TEST_CASE(CompressedRoundTrip)
+{
+    std::vector<Matrix> matrices;
+    matrices.push_back(filled(64, 64, 4));
+    matrices.push_back(filled(2, 3, 5));
+    Matrix zeros(300, 20);
+    matrices.push_back(zeros);
+    const std::string compressed = fileOf(matrices, LzCompression);
+    CHECK(compressed.size() < fileOf(matrices, NoCompression).size());
+    std::istringstream input(compressed);
+    const std::vector<Matrix> read = readMatrices(input);
+    CHECK_EQ(read.size(), matrices.size());
+    for (size_t i = 0; i < read.size() && i < matrices.size(); i++)
+    {
+        CHECK(identical(read[i], matrices[i]));
+    }
+}
+
+TEST_CASE(SingleMatrixRoundTrip)
+{
+    const Matrix m = filled(10, 7, 6);
+    std::stringstream file;
+    writeMatrix(file, m, LzCompression);
+    CHECK(identical(readMatrix(file), m));
+}
+
+TEST_CASE(LzCodecRoundTrip)
+{
+    for (size_t size : {0, 1, 4, 12, 13, 40, 1000, 70000})
+    {
+        std::vector<uint8_t> src(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            src[i] = (uint8_t) ((i / 9) % 5 == 0 ? i * 13 : i % 3);
+        }
+        std::vector<uint8_t> packed(lzCompressBound(size));
+        const size_t packedSize = lzCompress(src.data(), size, packed.data());
+        CHECK(packedSize <= lzCompressBound(size));
+        std::vector<uint8_t> dst(size + 1);
+        CHECK(lzDecompress(packed.data(), packedSize, dst.data(), size));
+        CHECK(std::memcmp(dst.data(), src.data(), size) == 0);
+        // the wrong expected size and a cut stream are both rejected
+        CHECK(!lzDecompress(packed.data(), packedSize, dst.data(), size + 1));
+        if (packedSize > 1)
+        {
+            CHECK(!lzDecompress(packed.data(), packedSize - 1, dst.data(), size));
+        }
+    }
+}
+
+TEST_CASE(TruncatedFilesFail)
+{
+    std::vector<Matrix> matrices;
+    matrices.push_back(filled(16, 16, 7));
+    matrices.push_back(filled(8, 8, 8));
+    for (MatrixCompression compression : {NoCompression, LzCompression})
+    {
+        const std::string bytes = fileOf(matrices, compression);
+        for (size_t length : {(size_t) 0, (size_t) 10, (size_t) ENTRY_OFFSET + 8, bytes.size() / 2,
+                              bytes.size() - 1})
+        {
+            CHECK_EXITS(readRefusing(bytes.substr(0, length)), FILE_ERROR);
+        }
+    }
+}
+
+TEST_CASE(CorruptFilesFail)
+{
+    std::vector<Matrix> matrices;
+    matrices.push_back(filled(4, 4, 9));
+    std::string badMagic = fileOf(matrices, NoCompression);
+    badMagic[0] = 'X';
+    CHECK_EXITS(readRefusing(badMagic), FORMAT_ERROR);
+
+    MatrixEntry entry{4, 4, NoCompression, 0, 4 * 4 * sizeof(float)};
+    entry.compression = 7;
+    CHECK_EXITS(readRefusing(withEntry(entry)), FORMAT_ERROR);
+    entry = MatrixEntry{4, -4, NoCompression, 0, 4 * 4 * sizeof(float)};
+    CHECK_EXITS(readRefusing(withEntry(entry)), FORMAT_ERROR);
+    entry = MatrixEntry{4, 4, NoCompression, 0, 4 * 4 * sizeof(float) - 1};
+    CHECK_EXITS(readRefusing(withEntry(entry)), FORMAT_ERROR);
+}
+
+TEST_CASE(HugeHeadersFailBeforeAllocating)
+{
+    // 46340 × 46340 floats is 8 GB, the file holds 64 bytes of it
+    const int64_t side = 46340;
+    MatrixEntry raw{(int32_t) side, (int32_t) side, NoCompression, 0, (uint64_t) (side * side) * sizeof(float)};
+    CHECK_EXITS(readRefusing(withEntry(raw)), FILE_ERROR);
+    // more than LZ can expand 64 bytes to
+    MatrixEntry compressed{(int32_t) side, (int32_t) side, LzCompression, 0, 64};
+    CHECK_EXITS(readRefusing(withEntry(compressed)), FORMAT_ERROR);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,94 @@
+// test_matrix_print.cpp
+//
+// Matrix::plainPrint formats into one buffer, its output must be byte for byte what streaming every
+// element to std::cout prints, whatever format state std::cout is in.
+
+#include "Matrix.h"
+#include "Check.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/**
+ * A matrix of values that need every digit of a float, with a negative and a zero
+ */
+static Matrix values()
+{
+    Matrix m(3, 4);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = (float) (i - 5) / 3.0f * ((i % 2 == 0) ? 1e-7f : 12345.678f);
+    }
+    return m;
+}
+
+/**
+ * What std::cout receives from print, its format state is restored afterwards
+ * @param setup puts std::cout into the format state under test
+ * @param print writes to std::cout
+ */
+template<class S, class F>
+static std::string captured(S setup, F print)
+{
+    std::ostringstream text;
+    std::ios state(nullptr);
+    state.copyfmt(std::cout);
+    std::streambuf *previous = std::cout.rdbuf(text.rdbuf());
+    setup();
+    print();
+    std::cout.rdbuf(previous);
+    std::cout.copyfmt(state);
+    return text.str();
+}
+
+/**
+ * Checks plainPrint against streaming every element to std::cout, in the given format state
+ * @param setup puts std::cout into the format state under test
+ */
+template<class S>
+static bool printsAsStreamed(S setup)
+{
+    const Matrix m = values();
+    const std::string printed = captured(setup, [&]() { m.plainPrint(); });
+    const std::string streamed = captured(setup, [&]()
+    {
+        for (int i = 0; i < m.getRows(); i++)
+        {
+            for (int j = 0; j < m.getCols(); j++)
+            {
+                std::cout << m(i, j) << " ";
+            }
+            std::cout << std::endl;
+        }
+    });
+    return printed == streamed;
+}
+
+TEST_CASE(DefaultFormat)
+{
+    CHECK(printsAsStreamed([]() {}));
+}
+
+TEST_CASE(LongPrecision)
+{
+    // more digits than the old fixed size buffer could hold
+    CHECK(printsAsStreamed([]() { std::cout << std::setprecision(40); }));
+    CHECK(printsAsStreamed([]() { std::cout << std::fixed << std::setprecision(40); }));
+}
+
+TEST_CASE(FixedAndScientific)
+{
+    CHECK(printsAsStreamed([]() { std::cout << std::fixed << std::setprecision(3); }));
+    CHECK(printsAsStreamed([]() { std::cout << std::scientific << std::setprecision(2); }));
+    CHECK(printsAsStreamed([]() { std::cout << std::showpos << std::uppercase << std::scientific; }));
+}
+
+TEST_CASE(FieldWidth)
+{
+    CHECK(printsAsStreamed([]() { std::cout << std::setw(20) << std::setfill('*'); }));
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
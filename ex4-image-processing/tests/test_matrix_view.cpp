@@ -0,0 +1,169 @@
+// test_matrix_view.cpp
+//
+// MatrixView.h against loops over plain indices: strided blocks and transposed views read the
+// elements they claim to, and the blocked transpose (Matrix::transpose, Matrix from a transposed
+// view, transpose between strided blocks) and the strided GEMM agree with a naive reference on
+// non-square shapes that are not multiples of the transpose tiles or blocks.
+
+#include "MatrixView.h"
+#include "Gemm.h"
+#include "Check.h"
+#include <vector>
+
+/*
+ * rows × cols shapes around the TRANSPOSE_TILE (8) and TRANSPOSE_BLOCK (32) boundaries.
+ */
+static const int SHAPES[][2] = {{1, 1}, {1, 37}, {37, 1}, {7, 13}, {9, 31}, {33, 65}, {70, 45}, {129, 31},
+                                {100, 257}};
+
+/**
+ * A rows × cols matrix whose element (i, j) encodes its own position
+ */
+static Matrix positions(int rows, int cols)
+{
+    Matrix m(rows, cols);
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            m(i, j) = (float) (i * 1000 + j);
+        }
+    }
+    return m;
+}
+
+/**
+ * Checks that a view holds the elements of the rows × cols block of m at (top, left), transposed
+ * when asked
+ */
+static bool showsBlock(const ConstMatrixView &v, const Matrix &m, int top, int left, bool transposed)
+{
+    for (int i = 0; i < v.getRows(); i++)
+    {
+        for (int j = 0; j < v.getCols(); j++)
+        {
+            const float expected = transposed ? m(top + j, left + i) : m(top + i, left + j);
+            if (v(i, j) != expected)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST_CASE(StridedBlocksReadTheirElements)
+{
+    const Matrix m = positions(45, 70);
+    const ConstMatrixView whole = m.view();
+    const ConstMatrixView block = whole.block(3, 5, 17, 29);
+    CHECK_EQ(block.getRows(), 17);
+    CHECK_EQ(block.getCols(), 29);
+    CHECK_EQ(block.getRowStride(), 70);
+    CHECK(showsBlock(block, m, 3, 5, false));
+    // a block of a block, its rows and cols, and their transposes
+    const ConstMatrixView inner = block.block(2, 4, 9, 11);
+    CHECK(showsBlock(inner, m, 5, 9, false));
+    CHECK(showsBlock(inner.row(3), m, 8, 9, false));
+    CHECK(showsBlock(inner.col(6), m, 5, 15, false));
+    CHECK(showsBlock(inner.transposed(), m, 5, 9, true));
+    CHECK(showsBlock(inner.transposed().transposed(), m, 5, 9, false));
+    CHECK(!inner.transposed().isRowMajor());
+    // a block of a transposed view is the transpose of the mirrored block
+    CHECK(showsBlock(whole.transposed().block(4, 6, 13, 7), m, 6, 4, true));
+    // copied out whatever the strides
+    const Matrix copy(inner.transposed());
+    CHECK_EQ(copy.getRows(), 11);
+    CHECK_EQ(copy.getCols(), 9);
+    CHECK(showsBlock(copy.view(), m, 5, 9, true));
+    // writes land in the matrix
+    Matrix target = positions(10, 12);
+    target.view().block(2, 3, 4, 5).transposed()(4, 1) = -1.0f;
+    CHECK_EQ(target(3, 7), -1.0f);
+}
+
+TEST_CASE(TransposeMatchesNaive)
+{
+    for (const int *shape : SHAPES)
+    {
+        const Matrix m = positions(shape[0], shape[1]);
+        const Matrix t = m.transpose();
+        const Matrix fromView(m.view().transposed());
+        CHECK_EQ(t.getRows(), shape[1]);
+        CHECK_EQ(t.getCols(), shape[0]);
+        CHECK(showsBlock(t.view(), m, 0, 0, true));
+        CHECK(showsBlock(fromView.view(), m, 0, 0, true));
+    }
+}
+
+TEST_CASE(TransposeBetweenStridedBlocks)
+{
+    for (const int *shape : SHAPES)
+    {
+        const int rows = shape[0];
+        const int cols = shape[1];
+        // both operands inside larger matrices, so every row is strided
+        const Matrix src = positions(rows + 5, cols + 3);
+        Matrix dst(cols + 4, rows + 6);
+        for (int i = 0; i < dst.size(); i++)
+        {
+            dst[i] = -2.0f;
+        }
+        transpose(src.view().block(2, 1, rows, cols), dst.view().block(3, 4, cols, rows));
+        CHECK(showsBlock(dst.view().block(3, 4, cols, rows), src, 2, 1, true));
+        // nothing around the destination block is touched
+        int outside = 0;
+        for (int i = 0; i < dst.getRows(); i++)
+        {
+            for (int j = 0; j < dst.getCols(); j++)
+            {
+                const bool inside = i >= 3 && i < 3 + cols && j >= 4 && j < 4 + rows;
+                outside += (!inside && dst(i, j) != -2.0f);
+            }
+        }
+        CHECK_EQ(outside, 0);
+    }
+}
+
+TEST_CASE(GemmOnStridedAndTransposedViews)
+{
+    for (const int *shape : SHAPES)
+    {
+        const int m = shape[0];
+        const int k = shape[1];
+        const int n = (m * 3 + k) % 41 + 1;
+        // A^T and B are read from blocks of larger matrices, C is written into one
+        Matrix a(k + 2, m + 3);
+        Matrix b(k + 1, n + 5);
+        for (int i = 0; i < a.size(); i++)
+        {
+            a[i] = (float) ((i * 7) % 11 - 5) / 4.0f;
+        }
+        for (int i = 0; i < b.size(); i++)
+        {
+            b[i] = (float) ((i * 5) % 13 - 6) / 4.0f;
+        }
+        const ConstMatrixView aView = a.view().block(1, 2, k, m).transposed();
+        const ConstMatrixView bView = b.view().block(1, 3, k, n);
+        Matrix c(m + 1, n + 2);
+        gemm(aView, bView, c.view().block(1, 1, m, n));
+        for (int i = 0; i < m; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                double sum = 0.0;
+                for (int l = 0; l < k; l++)
+                {
+                    sum += (double) aView(i, l) * bView(l, j);
+                }
+                CHECK_NEAR(c(i + 1, j + 1), sum, 1e-3);
+            }
+        }
+        CHECK_EQ(c(0, 0), 0.0f);
+    }
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
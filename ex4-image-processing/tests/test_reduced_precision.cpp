@@ -0,0 +1,190 @@
+// test_reduced_precision.cpp
+//
+// The int8 and 16 bit copies of a network (ReducedPrecisionMlpNetwork.h) against the float network
+// they were built from: the kernels on their own, the accuracy report, and the agreement of the
+// classified digits within the error the weight formats allow.
+
+#include "ReducedPrecisionMlpNetwork.h"
+#include "Check.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define IMAGES 256
+/*
+ * About twice the errors measured on this network: int8 0.042 max, 0.008 mean; bf16 0.014 max;
+ * fp16 0.0019 max. Probabilities of the float network range from 0.27 to 1.
+ */
+#define INT8_MAX_PROBABILITY_ERROR 0.08f
+#define INT8_MEAN_PROBABILITY_ERROR 0.02f
+#define BF16_MAX_PROBABILITY_ERROR 0.03f
+#define FP16_MAX_PROBABILITY_ERROR 0.005f
+#define MIN_AGREEMENT 0.97
+
+/**
+ * A rows × cols matrix of uniform values in [-scale, scale)
+ * @param rows positive number
+ * @param cols positive number
+ * @param scale half width of the range
+ * @param seed random seed
+ */
+static Matrix randomMatrix(int rows, int cols, float scale, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(-scale, scale);
+    Matrix m(rows, cols);
+    for (int i = 0; i < m.size(); i++)
+    {
+        m[i] = uniform(random);
+    }
+    return m;
+}
+
+/**
+ * A network of the weightsDims shapes, the weights scaled so the activations stay in range
+ * @param exact true for weights of at most 8 significant bits, which fp16 and bf16 hold exactly
+ */
+static MlpNetwork makeNetwork(bool exact)
+{
+    Matrix weights[MLP_SIZE];
+    Matrix biases[MLP_SIZE];
+    for (int i = 0; i < MLP_SIZE; i++)
+    {
+        const float scale = 4.0f / std::sqrt((float) weightsDims[i].cols);
+        weights[i] = randomMatrix(weightsDims[i].rows, weightsDims[i].cols, scale, 11 + i);
+        biases[i] = randomMatrix(biasDims[i].rows, biasDims[i].cols, 0.1f, 23 + i);
+        if (exact)
+        {
+            for (int j = 0; j < weights[i].size(); j++)
+            {
+                weights[i][j] = std::round(weights[i][j] * 256.0f) / 256.0f;
+            }
+        }
+    }
+    return MlpNetwork(weights, biases);
+}
+
+/**
+ * count images of uniform pixels in [0, 1), stored one after the other
+ */
+static std::vector<float> randomImages(int count)
+{
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<float> images((size_t) count * imgDims.rows * imgDims.cols);
+    for (float &pixel : images)
+    {
+        pixel = uniform(random);
+    }
+    return images;
+}
+
+TEST_CASE(QuantizedLayerIsWithinItsScale)
+{
+    const MlpNetwork network = makeNetwork(false);
+    for (int l = 0; l < network.getLayerCount(); l++)
+    {
+        const Dense &dense = network.getLayer(l);
+        const QuantizedDense layer(dense);
+        const int cols = layer.getCols();
+        const Matrix x = randomMatrix(cols, 1, 1.0f, 31 + l);
+        std::vector<float> expected((size_t) layer.getRows());
+        std::vector<float> actual((size_t) layer.getRows());
+        dense.apply(x.data(), expected.data());
+        layer.apply(x.data(), actual.data());
+        // every product is off by at most half a step of each operand, summed over the inputs
+        float xMax = 0.0f;
+        float wMax = 0.0f;
+        for (int j = 0; j < cols; j++)
+        {
+            xMax = std::fmax(xMax, std::fabs(x[j]));
+        }
+        for (int j = 0; j < dense.getWeights().size(); j++)
+        {
+            wMax = std::fmax(wMax, std::fabs(dense.getWeights()[j]));
+        }
+        const float bound = (float) cols * (wMax * xMax / 127.0f);
+        for (int i = 0; i < layer.getRows(); i++)
+        {
+            CHECK_NEAR(actual[i], expected[i], bound);
+        }
+    }
+}
+
+TEST_CASE(QuantizedNetworkAgrees)
+{
+    const MlpNetwork network = makeNetwork(false);
+    const std::vector<float> images = randomImages(IMAGES);
+    const QuantizedMlpNetwork quantized(network);
+    const QuantizationReport report = quantized.compareWith(network, images.data(), IMAGES);
+    CHECK_EQ(report.images, IMAGES);
+    CHECK(report.agreeing >= MIN_AGREEMENT * IMAGES);
+    CHECK(report.maxProbabilityError <= INT8_MAX_PROBABILITY_ERROR);
+    CHECK(report.meanProbabilityError <= INT8_MEAN_PROBABILITY_ERROR);
+    CHECK(report.meanProbabilityError <= report.maxProbabilityError);
+    // one image at a time gives what the batch gave
+    const std::vector<Digit> digits = quantized.classify(images.data(), IMAGES);
+    for (int j = 0; j < 8; j++)
+    {
+        const Matrix img(imgDims.rows * imgDims.cols, 1,
+                         const_cast<float *>(images.data()) + j * imgDims.rows * imgDims.cols);
+        const Digit digit = quantized(img);
+        CHECK_EQ(digit.value, digits[j].value);
+        CHECK_EQ(digit.probability, digits[j].probability);
+    }
+}
+
+TEST_CASE(HalfNetworksAgree)
+{
+    const MlpNetwork network = makeNetwork(false);
+    const std::vector<float> images = randomImages(IMAGES);
+    const HalfMlpNetwork bf16(network, BFloat16);
+    const HalfMlpNetwork fp16(network, Float16);
+    const QuantizationReport bf16Report = bf16.compareWith(network, images.data(), IMAGES);
+    const QuantizationReport fp16Report = fp16.compareWith(network, images.data(), IMAGES);
+    CHECK(bf16Report.agreeing >= MIN_AGREEMENT * IMAGES);
+    CHECK(fp16Report.agreeing >= MIN_AGREEMENT * IMAGES);
+    CHECK(bf16Report.maxProbabilityError <= BF16_MAX_PROBABILITY_ERROR);
+    CHECK(fp16Report.maxProbabilityError <= FP16_MAX_PROBABILITY_ERROR);
+    // fp16 keeps 3 more mantissa bits than bf16
+    CHECK(fp16Report.meanProbabilityError <= bf16Report.meanProbabilityError);
+}
+
+TEST_CASE(HalfNetworkIsExactOnRepresentableWeights)
+{
+    // multiples of 1 / 256 below 1/2 fit both formats, only the summation order may differ
+    const MlpNetwork network = makeNetwork(true);
+    const std::vector<float> images = randomImages(IMAGES);
+    for (HalfFormat format : {Float16, BFloat16})
+    {
+        const HalfMlpNetwork half(network, format);
+        const QuantizationReport report = half.compareWith(network, images.data(), IMAGES);
+        CHECK_EQ(report.agreeing, IMAGES);
+        CHECK(report.maxProbabilityError <= 1e-5f);
+    }
+}
+
+TEST_CASE(HalfConversionRoundsToNearest)
+{
+    CHECK_EQ(halfToFloat(floatToHalf(1.0f)), 1.0f);
+    CHECK_EQ(halfToFloat(floatToHalf(-0.375f)), -0.375f);
+    CHECK_EQ(halfToFloat(floatToHalf(65504.0f)), 65504.0f);
+    CHECK_NEAR(halfToFloat(floatToHalf(0.1f)), 0.1f, 0.1f / 2048);
+    CHECK_NEAR(halfToFloat(floatToHalf(3.14159f)), 3.14159f, 3.14159f / 2048);
+}
+
+TEST_CASE(EmptyComparisonIsEmpty)
+{
+    const MlpNetwork network = makeNetwork(false);
+    const QuantizedMlpNetwork quantized(network);
+    const QuantizationReport report = quantized.compareWith(network, nullptr, 0);
+    CHECK_EQ(report.images, 0);
+    CHECK_EQ(report.agreeing, 0);
+    CHECK_EQ(report.maxProbabilityError, 0.0f);
+    CHECK_EQ(report.meanProbabilityError, 0.0f);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,158 @@
+// test_softmax.cpp
+//
+// Accuracy of vecSoftmax and vecLogSoftmax against a double precision reference, over lengths that
+// reach the vector tails of every ISA and logits far beyond the range exp can take in float.
+
+#include "VectorOps.h"
+#include "Check.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define SOFTMAX_RELATIVE_ERROR 2e-5
+#define LOG_SOFTMAX_ERROR 5e-5
+
+static const int lengths[] = {1, 2, 7, 8, 10, 15, 16, 17, 33, 64, 100, 1000};
+static const float offsets[] = {0.0f, 1000.0f, -1000.0f, 3000.0f};
+
+/**
+ * n logits spread over [offset - 20, offset + 20]
+ * @param n amount of logits
+ * @param offset center of the range
+ * @param seed random seed
+ */
+static std::vector<float> logits(int n, float offset, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> spread(-20.0f, 20.0f);
+    std::vector<float> a((size_t) n);
+    for (float &x : a)
+    {
+        x = offset + spread(random);
+    }
+    return a;
+}
+
+/**
+ * softmax(a) in double precision
+ * @param a logits
+ * @param log true for log(softmax(a))
+ */
+static std::vector<double> reference(const std::vector<float> &a, bool log)
+{
+    double max = a[0];
+    for (float x : a)
+    {
+        max = std::fmax(max, (double) x);
+    }
+    double sum = 0;
+    for (float x : a)
+    {
+        sum += std::exp((double) x - max);
+    }
+    std::vector<double> out(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        out[i] = log ? (double) a[i] - max - std::log(sum) : std::exp((double) a[i] - max) / sum;
+    }
+    return out;
+}
+
+TEST_CASE(SoftmaxMatchesTheReference)
+{
+    unsigned int seed = 1;
+    for (int n : lengths)
+    {
+        for (float offset : offsets)
+        {
+            const std::vector<float> a = logits(n, offset, seed++);
+            const std::vector<double> expected = reference(a, false);
+            std::vector<float> out((size_t) n);
+            const float sum = vecSoftmax(a.data(), out.data(), n);
+            double total = 0;
+            for (int i = 0; i < n; i++)
+            {
+                CHECK(std::isfinite(out[i]));
+                CHECK_NEAR(out[i], expected[i], SOFTMAX_RELATIVE_ERROR * expected[i]);
+                total += out[i];
+            }
+            CHECK_NEAR(total, 1.0, SOFTMAX_RELATIVE_ERROR);
+            // 1 / sum is the probability of the largest logit
+            const int best = vecArgmax(a.data(), n);
+            CHECK_EQ(vecArgmax(out.data(), n), best);
+            CHECK_NEAR(1.0 / sum, expected[best], SOFTMAX_RELATIVE_ERROR * expected[best]);
+        }
+    }
+}
+
+TEST_CASE(LogSoftmaxMatchesTheReference)
+{
+    unsigned int seed = 100;
+    for (int n : lengths)
+    {
+        for (float offset : offsets)
+        {
+            const std::vector<float> a = logits(n, offset, seed++);
+            const std::vector<double> expected = reference(a, true);
+            std::vector<float> out((size_t) n);
+            std::vector<float> probabilities((size_t) n);
+            vecLogSoftmax(a.data(), out.data(), n);
+            vecSoftmax(a.data(), probabilities.data(), n);
+            for (int i = 0; i < n; i++)
+            {
+                CHECK(std::isfinite(out[i]));
+                CHECK(out[i] <= 0.0f);
+                CHECK_NEAR(out[i], expected[i], LOG_SOFTMAX_ERROR);
+                // the two agree with each other, not only with the reference
+                CHECK_NEAR(std::exp((double) out[i]), probabilities[i],
+                           LOG_SOFTMAX_ERROR * probabilities[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE(HugeLogitsStayFinite)
+{
+    // exp overflows float past 88, only the shift by the maximum keeps these finite
+    const float a[] = {1e4f, 9990.0f, -1e4f, 3e4f, 29995.0f, 0.0f, 3e4f, -3e4f, 12.5f};
+    const int n = (int) (sizeof(a) / sizeof(a[0]));
+    float out[sizeof(a) / sizeof(a[0])];
+    float logOut[sizeof(a) / sizeof(a[0])];
+    const float sum = vecSoftmax(a, out, n);
+    vecLogSoftmax(a, logOut, n);
+    CHECK(std::isfinite(sum));
+    double total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        CHECK(std::isfinite(out[i]));
+        CHECK(std::isfinite(logOut[i]));
+        total += out[i];
+    }
+    CHECK_NEAR(total, 1.0, SOFTMAX_RELATIVE_ERROR);
+    // the two equal maxima share the mass, the one 5 below gets exp(-5) of either
+    const double top = 1.0 / (2.0 + std::exp(-5.0));
+    CHECK_NEAR(out[3], top, SOFTMAX_RELATIVE_ERROR * top);
+    CHECK_NEAR(out[6], top, SOFTMAX_RELATIVE_ERROR * top);
+    CHECK_NEAR(logOut[3], std::log(top), LOG_SOFTMAX_ERROR);
+    CHECK_NEAR(logOut[4], std::log(top) - 5.0, LOG_SOFTMAX_ERROR);
+    CHECK_EQ(out[0], 0.0f);
+}
+
+TEST_CASE(EqualLogitsAreUniform)
+{
+    for (int n : lengths)
+    {
+        std::vector<float> a((size_t) n, 2500.0f);
+        std::vector<float> out((size_t) n);
+        vecSoftmax(a.data(), out.data(), n);
+        for (int i = 0; i < n; i++)
+        {
+            CHECK_NEAR(out[i], 1.0 / n, SOFTMAX_RELATIVE_ERROR / n);
+        }
+    }
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,101 @@
+// test_thread_pool.cpp
+//
+// ThreadPool::parallelFor: every index of a range runs exactly once, nested calls from inside a
+// chunk complete, and a caller whose remaining chunks run on other threads sleeps instead of
+// spinning.
+
+#include "ThreadPool.h"
+#include "Check.h"
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#define THREADS 4
+#define SLOW_CHUNK_MS 100
+// far below SLOW_CHUNK_MS, a caller that spins for the slow chunks burns about that much
+#define MAX_WAITING_CPU_MS 30.0
+
+/**
+ * CPU time used by the calling thread so far, in milliseconds
+ */
+static double threadCpuMs()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (double) now.tv_sec * 1e3 + (double) now.tv_nsec / 1e6;
+}
+
+TEST_CASE(EveryIndexRunsOnce)
+{
+    ThreadPool pool(THREADS);
+    CHECK_EQ(pool.getThreadCount(), THREADS);
+    for (int grain : {1, 3, 16, 1000})
+    {
+        std::vector<std::atomic<int>> hits(1000);
+        for (std::atomic<int> &hit : hits)
+        {
+            hit = 0;
+        }
+        pool.parallelFor(0, (int) hits.size(), grain, [&hits, grain](int first, int last)
+        {
+            CHECK(last - first <= grain);
+            CHECK(ThreadPool::insideTask());
+            for (int i = first; i < last; i++)
+            {
+                hits[i]++;
+            }
+        });
+        for (const std::atomic<int> &hit : hits)
+        {
+            CHECK_EQ(hit.load(), 1);
+        }
+    }
+    CHECK(!ThreadPool::insideTask());
+}
+
+TEST_CASE(NestedCallsComplete)
+{
+    ThreadPool pool(THREADS);
+    std::atomic<int> total(0);
+    pool.parallelFor(0, 8, 1, [&pool, &total](int, int)
+    {
+        pool.parallelFor(0, 64, 4, [&total](int first, int last)
+        {
+            total += last - first;
+        });
+    });
+    CHECK_EQ(total.load(), 8 * 64);
+}
+
+TEST_CASE(WaitingCallerSleeps)
+{
+    ThreadPool pool(THREADS);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> workerStarted(false);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const double cpuBefore = threadCpuMs();
+    // chunks on the caller return once a worker holds one, the workers' chunks are slow
+    pool.parallelFor(0, THREADS, 1, [caller, &workerStarted](int, int)
+    {
+        if (std::this_thread::get_id() == caller)
+        {
+            while (!workerStarted.load())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return;
+        }
+        workerStarted = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_CHUNK_MS));
+    });
+    const double cpu = threadCpuMs() - cpuBefore;
+    const double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(wall >= SLOW_CHUNK_MS);
+    CHECK(cpu < MAX_WAITING_CPU_MS);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
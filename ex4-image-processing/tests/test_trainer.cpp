@@ -0,0 +1,248 @@
+// test_trainer.cpp
+//
+// MlpTrainer on a tiny network: the gradients of the backward pass against central differences of
+// the loss, one SGD and one Adam run against the textbook update rules, and label files that do not
+// hold the labels their header claims.
+
+#include "MlpTrainer.h"
+#include "Check.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#define IMAGES 6
+#define STEPS 3
+#define FINITE_DIFFERENCE 1e-3f
+#define LABEL_FORMAT_ERROR "invalid label file"
+#define LABEL_FILE "test_trainer_labels.idx"
+
+static const std::vector<int> WIDTHS = {7, 6, 5, 4};
+
+/**
+ * IMAGES inputs of uniform values in [0, 1), stored one after the other
+ */
+static std::vector<float> randomImages()
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<float> images((size_t) IMAGES * WIDTHS.front());
+    for (float &pixel : images)
+    {
+        pixel = uniform(random);
+    }
+    return images;
+}
+
+/**
+ * IMAGES labels covering every output
+ */
+static std::vector<int> labels()
+{
+    std::vector<int> labels(IMAGES);
+    for (int i = 0; i < IMAGES; i++)
+    {
+        labels[i] = i % WIDTHS.back();
+    }
+    return labels;
+}
+
+/**
+ * The mean loss of a trainer's network with one parameter moved
+ * @param trainer the network
+ * @param layer layer of the parameter
+ * @param bias true for a bias, false for a weight
+ * @param index index of the parameter
+ * @param delta added to the parameter
+ */
+static double shiftedLoss(const MlpTrainer &trainer, int layer, bool bias, int index, float delta)
+{
+    std::vector<Dense> layers = trainer.toLayers();
+    Matrix w = layers[layer].getWeights();
+    Matrix b = layers[layer].getBias();
+    (bias ? b : w)[index] += delta;
+    layers[layer] = Dense(w, b, layers[layer].getActivation().getActivationType());
+    MlpTrainer shifted(MlpGraph(std::move(layers)));
+    const std::vector<float> images = randomImages();
+    const std::vector<int> expected = labels();
+    return shifted.gradients(images.data(), expected.data(), IMAGES);
+}
+
+/**
+ * Checks one analytic gradient against the central difference of the loss
+ */
+static bool matchesDifference(const MlpTrainer &trainer, int layer, bool bias, int index, float gradient)
+{
+    const double numeric = (shiftedLoss(trainer, layer, bias, index, FINITE_DIFFERENCE) -
+                            shiftedLoss(trainer, layer, bias, index, -FINITE_DIFFERENCE)) /
+                           (2.0 * FINITE_DIFFERENCE);
+    return std::fabs(numeric - gradient) <= 2e-3 + 2e-2 * std::fabs(gradient);
+}
+
+TEST_CASE(GradientsMatchFiniteDifferences)
+{
+    MlpTrainer trainer(WIDTHS, 5);
+    const std::vector<float> images = randomImages();
+    const std::vector<int> expected = labels();
+    const double loss = trainer.gradients(images.data(), expected.data(), IMAGES);
+    CHECK_NEAR(loss, shiftedLoss(trainer, 0, false, 0, 0.0f), 1e-6);
+    for (int l = 0; l < trainer.getLayerCount(); l++)
+    {
+        const Matrix &gradW = trainer.getWeightsGradient(l);
+        const Matrix &gradBias = trainer.getBiasGradient(l);
+        CHECK_EQ(gradW.getRows(), trainer.getWeights(l).getRows());
+        CHECK_EQ(gradW.getCols(), trainer.getWeights(l).getCols());
+        for (int i = 0; i < gradW.size(); i++)
+        {
+            CHECK(matchesDifference(trainer, l, false, i, gradW[i]));
+        }
+        for (int i = 0; i < gradBias.size(); i++)
+        {
+            CHECK(matchesDifference(trainer, l, true, i, gradBias[i]));
+        }
+    }
+}
+
+/**
+ * Runs STEPS full batch steps of train and checks every parameter after each against the update
+ * rule applied to the gradients of the parameters before it
+ * @param options the optimizer under test, batchSize and epochs are set here
+ */
+static void checkSteps(TrainingOptions options)
+{
+    options.batchSize = IMAGES;
+    options.epochs = 1;
+    MlpTrainer trainer(WIDTHS, 9);
+    const std::vector<float> images = randomImages();
+    const std::vector<int> expected = labels();
+    // per layer, the weights then the biases, flattened
+    const int layers = trainer.getLayerCount();
+    std::vector<std::vector<float>> moment(layers);
+    std::vector<std::vector<float>> second(layers);
+    for (int step = 1; step <= STEPS; step++)
+    {
+        MlpTrainer reference(MlpGraph(trainer.toLayers()));
+        reference.gradients(images.data(), expected.data(), IMAGES);
+        std::vector<std::vector<float>> updated(layers);
+        for (int l = 0; l < layers; l++)
+        {
+            std::vector<float> params(trainer.getWeights(l).data(),
+                                      trainer.getWeights(l).data() + trainer.getWeights(l).size());
+            params.insert(params.end(), trainer.getBias(l).data(),
+                          trainer.getBias(l).data() + trainer.getBias(l).size());
+            std::vector<float> g(reference.getWeightsGradient(l).data(),
+                                 reference.getWeightsGradient(l).data() + reference.getWeightsGradient(l).size());
+            g.insert(g.end(), reference.getBiasGradient(l).data(),
+                     reference.getBiasGradient(l).data() + reference.getBiasGradient(l).size());
+            moment[l].resize(params.size(), 0.0f);
+            second[l].resize(params.size(), 0.0f);
+            for (size_t i = 0; i < params.size(); i++)
+            {
+                if (options.optimizer == Sgd)
+                {
+                    moment[l][i] = options.momentum * moment[l][i] - options.learningRate * g[i];
+                    params[i] += moment[l][i];
+                }
+                else
+                {
+                    moment[l][i] = options.beta1 * moment[l][i] + (1 - options.beta1) * g[i];
+                    second[l][i] = options.beta2 * second[l][i] + (1 - options.beta2) * g[i] * g[i];
+                    // the bias corrections folded into the step size (Kingma and Ba, section 2), so
+                    // epsilon is added to the uncorrected sqrt(v)
+                    const float stepSize = options.learningRate *
+                                           std::sqrt(1 - std::pow(options.beta2, (float) step)) /
+                                           (1 - std::pow(options.beta1, (float) step));
+                    params[i] -= stepSize * moment[l][i] / (std::sqrt(second[l][i]) + options.epsilon);
+                }
+            }
+            updated[l] = params;
+        }
+        trainer.train(images.data(), expected.data(), IMAGES, options);
+        for (int l = 0; l < layers; l++)
+        {
+            const Matrix &w = trainer.getWeights(l);
+            const Matrix &b = trainer.getBias(l);
+            for (int i = 0; i < w.size(); i++)
+            {
+                CHECK_NEAR(w[i], updated[l][i], 1e-5);
+            }
+            for (int i = 0; i < b.size(); i++)
+            {
+                CHECK_NEAR(b[i], updated[l][w.size() + i], 1e-5);
+            }
+        }
+    }
+}
+
+TEST_CASE(SgdFollowsTheUpdateRule)
+{
+    TrainingOptions options;
+    options.optimizer = Sgd;
+    options.learningRate = 0.05f;
+    options.momentum = 0.9f;
+    checkSteps(options);
+}
+
+TEST_CASE(AdamFollowsTheUpdateRule)
+{
+    TrainingOptions options;
+    options.optimizer = Adam;
+    options.learningRate = 0.01f;
+    checkSteps(options);
+}
+
+TEST_CASE(TrainingLowersTheLoss)
+{
+    MlpTrainer trainer(WIDTHS, 13);
+    const std::vector<float> images = randomImages();
+    const std::vector<int> expected = labels();
+    TrainingOptions options;
+    options.batchSize = 2;
+    options.epochs = 200;
+    options.learningRate = 0.01f;
+    const TrainingReport report = trainer.train(images.data(), expected.data(), IMAGES, options);
+    CHECK(report.loss.back() < 0.5f * report.loss.front());
+    CHECK_EQ(report.accuracy.back(), 1.0f);
+}
+
+/**
+ * Writes an idx1 label file
+ * @param count the count of its header
+ * @param labels the bytes after the header
+ */
+static void writeLabels(uint32_t count, const std::vector<unsigned char> &labels)
+{
+    const unsigned char header[] = {0, 0, 8, 1, (unsigned char) (count >> 24), (unsigned char) (count >> 16),
+                                    (unsigned char) (count >> 8), (unsigned char) count};
+    std::ofstream file(LABEL_FILE, std::ios::binary | std::ios::trunc);
+    file.write((const char *) header, sizeof(header));
+    file.write((const char *) labels.data(), (std::streamsize) labels.size());
+}
+
+TEST_CASE(LabelFilesAreRead)
+{
+    writeLabels(5, {3, 1, 4, 1, 5});
+    const std::vector<int> read = readIdxLabels(LABEL_FILE);
+    CHECK_EQ(read.size(), (size_t) 5);
+    CHECK(read == std::vector<int>({3, 1, 4, 1, 5}));
+    std::remove(LABEL_FILE);
+}
+
+TEST_CASE(LabelCountsAreCheckedAgainstTheFile)
+{
+    // a count of 4 billion over 3 labels fails before the count is allocated
+    writeLabels(0xFFFFFFF0u, {1, 2, 3});
+    CHECK_EXITS(readIdxLabels(LABEL_FILE), LABEL_FORMAT_ERROR);
+    writeLabels(4, {1, 2, 3});
+    CHECK_EXITS(readIdxLabels(LABEL_FILE), LABEL_FORMAT_ERROR);
+    writeLabels(2, {1, 2, 3});
+    CHECK_EXITS(readIdxLabels(LABEL_FILE), LABEL_FORMAT_ERROR);
+    std::remove(LABEL_FILE);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}